@@ -15,21 +15,12 @@ battery_monitor::battery_monitor()
   }
   // Initialize the current filtered value.
   battery_monitor::m_filtered_percentage = current_percentage;
+  // Initialize the power status.
+  battery_monitor::m_power_good = battery_monitor::measure_power_good();
 }
 
-// BATTERY LEVELS
-float battery_monitor::current_voltage()
-{
-  // Read analog input pin and convert to voltage.
-  // Tests indicated scaling factor of 0.0042v/div.
-  return static_cast<float>(analogRead(battery_monitor::adc_pin)) * 0.0042;
-}
-float battery_monitor::current_percentage()
-{
-  // Calculate a truncated percentage from 0 to 100, using formula % = (current - min)/(max-min)
-  return max(0, min(100, 100.0 * (battery_monitor::current_voltage() - battery_monitor::min_voltage)/(battery_monitor::max_voltage - battery_monitor::min_voltage)));
-}
-uint8_t battery_monitor::filtered_percentage()
+// METHODS
+void battery_monitor::spin_once()
 {
   // Perform filtering.
   // Grab an updated value of the raw percentage.
@@ -52,11 +43,35 @@ uint8_t battery_monitor::filtered_percentage()
     battery_monitor::m_filtered_percentage = current_percentage;
   }
 
+  // Update the power status.
+  battery_monitor::m_power_good = battery_monitor::measure_power_good();
+}
+
+// BATTERY LEVELS
+float battery_monitor::current_voltage()
+{
+  // Read analog input pin and convert to voltage.
+  // Tests indicated scaling factor of 0.0042v/div.
+  return static_cast<float>(analogRead(battery_monitor::adc_pin)) * 0.0042;
+}
+float battery_monitor::current_percentage()
+{
+  // Calculate a truncated percentage from 0 to 100, using formula % = (current - min)/(max-min)
+  return max(0, min(100, 100.0 * (battery_monitor::current_voltage() - battery_monitor::min_voltage)/(battery_monitor::max_voltage - battery_monitor::min_voltage)));
+}
+uint8_t battery_monitor::filtered_percentage()
+{
   return battery_monitor::m_filtered_percentage;
 }
 
 // STATUS
 bool battery_monitor::power_good()
+{
+  return battery_monitor::m_power_good;
+}
+
+// PRIVATE METHODS
+bool battery_monitor::measure_power_good()
 {
   // Get a debounced comparison of the current voltage to the min voltage.
 
@@ -15,6 +15,13 @@ public:
   /// \brief battery_monitor Creates a new instance of the battery monitor.
   battery_monitor();
 
+  // METHODS
+  /// \brief spin_once Samples the battery, updating the filtered percentage and the power status.
+  /// \details The filtered percentage and power status only change here, so reading them is cheap.  Meant to be called
+  /// every 25 ms: power_good() then follows a brownout within 25 ms, and the filtered percentage settles on a new level
+  /// once 5 samples in a row agree, after about 125 ms.
+  void spin_once();
+
   // BATTERY LEVELS
   /// \brief current_voltage Reads the current voltage of the battery.
   /// \returns The current battery voltage level, in volts.
@@ -23,12 +30,12 @@ public:
   /// \returns The current battery percentage level.
   float current_percentage();
   /// \brief filtered_percentage Gets a filtered version of the current battery level as a percentage.
-  /// \returns The current battery percentage level, from 0 to 100.
+  /// \returns The battery percentage level, from 0 to 100, as of the last spin_once().
   uint8_t filtered_percentage();
 
   // STATUS
   /// \brief power_good Indicates if battery power is in a usable state.
-  /// \returns TRUE if the battery is in a usable state, otherwise FALSE> 
+  /// \returns TRUE if the battery was in a usable state as of the last spin_once(), otherwise FALSE.
   bool power_good();
   
 private:
@@ -46,6 +53,12 @@ private:
   uint8_t m_percentage_window[5];
   /// \brief m_filtered_percentage Stores the most recent filtered percentage.
   uint8_t m_filtered_percentage;
+  /// \brief m_power_good Stores the most recent power status.
+  bool m_power_good;
+
+  // METHODS
+  /// \brief measure_power_good Measures if battery power is in a usable state.
+  bool measure_power_good();
 };
 
 }
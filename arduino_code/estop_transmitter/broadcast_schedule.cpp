@@ -0,0 +1,74 @@
+#include "broadcast_schedule.h"
+
+using namespace estop;
+
+// CONSTRUCTORS
+broadcast_schedule::broadcast_schedule(const phase* phases, uint8_t phase_count)
+{
+  broadcast_schedule::m_phases = phases;
+  broadcast_schedule::m_phase_count = phase_count;
+  broadcast_schedule::m_phase = 0;
+  broadcast_schedule::m_sent = 0;
+  broadcast_schedule::m_deadline = 0;
+  broadcast_schedule::m_random = 0x2545F491;
+}
+
+// METHODS
+void broadcast_schedule::restart(uint32_t now)
+{
+  broadcast_schedule::m_phase = 0;
+  broadcast_schedule::m_sent = 0;
+  broadcast_schedule::m_deadline = now;
+
+  // Stir the microsecond clock into the jitter generator, so transmitters switched at the same moment still drift apart.
+  broadcast_schedule::m_random ^= micros();
+  if(broadcast_schedule::m_random == 0)
+  {
+    broadcast_schedule::m_random = 0x2545F491;
+  }
+}
+bool broadcast_schedule::due(uint32_t now) const
+{
+  return static_cast<int32_t>(now - broadcast_schedule::m_deadline) >= 0;
+}
+void broadcast_schedule::sent(uint32_t now)
+{
+  // Move on to the next phase once this one is done.  The last phase never ends.
+  const phase& current = broadcast_schedule::m_phases[broadcast_schedule::m_phase];
+  broadcast_schedule::m_sent++;
+  if(broadcast_schedule::m_phase + 1 < broadcast_schedule::m_phase_count && broadcast_schedule::m_sent >= current.count)
+  {
+    broadcast_schedule::m_phase++;
+    broadcast_schedule::m_sent = 0;
+  }
+
+  // Space the next broadcast from when this one was due, so loop delays don't stretch the schedule.  If the loop has
+  // fallen more than a spacing behind, space it from now instead, rather than sending a burst to catch up.
+  const phase& next = broadcast_schedule::m_phases[broadcast_schedule::m_phase];
+  broadcast_schedule::m_deadline += next.spacing;
+  if(static_cast<int32_t>(now - broadcast_schedule::m_deadline) >= 0)
+  {
+    broadcast_schedule::m_deadline = now + next.spacing;
+  }
+  broadcast_schedule::m_deadline += broadcast_schedule::jitter(next.jitter);
+}
+
+// PROPERTIES
+uint8_t broadcast_schedule::current_phase() const
+{
+  return broadcast_schedule::m_phase;
+}
+
+// PRIVATE METHODS
+uint16_t broadcast_schedule::jitter(uint16_t maximum)
+{
+  if(maximum == 0)
+  {
+    return 0;
+  }
+  // xorshift32.
+  broadcast_schedule::m_random ^= broadcast_schedule::m_random << 13;
+  broadcast_schedule::m_random ^= broadcast_schedule::m_random >> 17;
+  broadcast_schedule::m_random ^= broadcast_schedule::m_random << 5;
+  return static_cast<uint16_t>(broadcast_schedule::m_random % (static_cast<uint32_t>(maximum) + 1));
+}
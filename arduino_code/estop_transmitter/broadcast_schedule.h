@@ -0,0 +1,74 @@
+/// \file broadcast_schedule.h
+/// \brief Defines the broadcast_schedule class.
+#ifndef broadcast_schedule_h
+#define broadcast_schedule_h
+
+#include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
+
+namespace estop {
+
+/// \brief broadcast_schedule Decides when to send each broadcast of a repeated command.
+/// \details A schedule is a list of phases, each sending a number of broadcasts at a fixed spacing plus random jitter,
+/// so a lost broadcast early on is made up for quickly, and later broadcasts keep the link quiet.  The last phase repeats
+/// for as long as the schedule runs.  Jitter keeps transmitters that started together from colliding on every broadcast.
+class broadcast_schedule
+{
+public:
+  // STRUCTURES
+  /// \brief phase A run of broadcasts at the same spacing.
+  struct phase
+  {
+    /// \brief count The number of broadcasts in the phase.  Ignored for the last phase, which repeats indefinitely.
+    uint8_t count;
+    /// \brief spacing The time, in milliseconds, from the previous broadcast to each broadcast in the phase.
+    /// \details Ignored for the very first broadcast, which is sent as soon as the schedule starts.
+    uint16_t spacing;
+    /// \brief jitter The maximum random time, in milliseconds, added to the spacing.
+    uint16_t jitter;
+  };
+
+  // CONSTRUCTORS
+  /// \brief broadcast_schedule Creates a new, stopped schedule.
+  /// \param phases The phases, in order.  Not copied, so must outlive the schedule.
+  /// \param phase_count The number of phases.  Must be at least 1.
+  broadcast_schedule(const phase* phases, uint8_t phase_count);
+
+  // METHODS
+  /// \brief restart Starts the schedule from its first phase, with the first broadcast due immediately.
+  /// \param now The current time, in milliseconds.
+  void restart(uint32_t now);
+  /// \brief due Checks if the next broadcast is due.
+  /// \param now The current time, in milliseconds.
+  /// \returns TRUE if a broadcast should be sent now, otherwise FALSE.
+  bool due(uint32_t now) const;
+  /// \brief sent Records that the due broadcast was sent, and schedules the next one.
+  /// \param now The current time, in milliseconds.
+  void sent(uint32_t now);
+
+  // PROPERTIES
+  /// \brief current_phase Gets the index of the phase the next broadcast belongs to.
+  uint8_t current_phase() const;
+
+private:
+  // VARIABLES
+  /// \brief m_phases The phases of the schedule.
+  const phase* m_phases;
+  /// \brief m_phase_count The number of phases.
+  uint8_t m_phase_count;
+  /// \brief m_phase The index of the current phase.
+  uint8_t m_phase;
+  /// \brief m_sent The number of broadcasts sent in the current phase.
+  uint8_t m_sent;
+  /// \brief m_deadline The time, in milliseconds, at which the next broadcast is due.
+  uint32_t m_deadline;
+  /// \brief m_random The state of the jitter generator.
+  uint32_t m_random;
+
+  // METHODS
+  /// \brief jitter Gets a random jitter between 0 and a maximum, inclusive.
+  uint16_t jitter(uint16_t maximum);
+};
+
+}
+
+#endif
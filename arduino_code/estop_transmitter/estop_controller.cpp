@@ -1,8 +1,51 @@
 #include "estop_controller.h"
 
+#include "latency_probe.h"
+
 using namespace estop;
 
+namespace {
+
+/// \brief switch_interrupt State shared between the switch's pin-change interrupt and the estop_controller.
+/// \details Pin 9 on the ItsyBitsy 32u4 is PB5/PCINT5, in pin-change group 0.  Only one controller can own it.
+struct
+{
+  /// \brief input The input register of the switch pin's port.
+  volatile uint8_t* input;
+  /// \brief mask The bit mask of the switch pin in its port.
+  uint8_t mask;
+  /// \brief lockout The time, in microseconds, to ignore edges after accepting one.
+  uint32_t lockout;
+  /// \brief level The debounced switch level.  TRUE = HIGH.
+  volatile bool level;
+  /// \brief edge The time, from micros(), at which the level last changed.
+  volatile uint32_t edge;
+  /// \brief changed Flag indicating that the level has changed since the controller last looked.
+  volatile bool changed;
+} switch_interrupt;
+
+}
+
+ISR(PCINT0_vect)
+{
+  // Other pins in the group share this interrupt, so only act on a real change of the switch pin's level.
+  uint32_t now = micros();
+  if(now - switch_interrupt.edge < switch_interrupt.lockout)
+  {
+    return;
+  }
+  bool level = (*switch_interrupt.input & switch_interrupt.mask) != 0;
+  if(level != switch_interrupt.level)
+  {
+    switch_interrupt.level = level;
+    switch_interrupt.edge = now;
+    switch_interrupt.changed = true;
+    ESTOP_PROBE_AT(switch_edge, now);
+  }
+}
+
 estop_controller::estop_controller(estop::battery_monitor* bm, estop::xbee* xb)
+  : estop_broadcasts(estop_controller::estop_schedule, sizeof(estop_controller::estop_schedule) / sizeof(estop_controller::estop_schedule[0]))
 {
   // Store pointers to battery monitor and xbee.
   estop_controller::battery_monitor = bm;
@@ -11,16 +54,96 @@ estop_controller::estop_controller(estop::battery_monitor* bm, estop::xbee* xb)
   // Set up the switch input pin.
   pinMode(estop_controller::switch_pin, INPUT);
 
+  // Set up the switch's pin-change interrupt, starting from the current level.
+  switch_interrupt.input = portInputRegister(digitalPinToPort(estop_controller::switch_pin));
+  switch_interrupt.mask = digitalPinToBitMask(estop_controller::switch_pin);
+  switch_interrupt.lockout = estop_controller::switch_lockout;
+  switch_interrupt.level = digitalRead(estop_controller::switch_pin) == HIGH;
+  switch_interrupt.edge = micros();
+  switch_interrupt.changed = false;
+  *digitalPinToPCMSK(estop_controller::switch_pin) |= _BV(digitalPinToPCMSKbit(estop_controller::switch_pin));
+  *digitalPinToPCICR(estop_controller::switch_pin) |= _BV(digitalPinToPCICRbit(estop_controller::switch_pin));
+
   // Initialize the e-stop state.
   estop_controller::estop_state = false;
-  // Initialize state action timestamp to zero to force immediate state action.
-  estop_controller::state_action_timestamp = 0;
+  // The first heartbeat is due immediately.
+  estop_controller::heartbeat_deadline = millis();
 }
 
 void estop_controller::spin_once()
 {
   // Check for a state change.
-  bool new_state = digitalRead(estop_controller::switch_pin) == HIGH;
+  estop_controller::check_switch();
+
+  // Perform state activities.
+  if(estop_controller::estop_state)
+  {
+    // Currently in e-stop state.  Broadcast e-stops on schedule.
+    estop_controller::send_estop();
+
+    // Follow up with robots that didn't confirm the broadcast.
+    if(estop_controller::unicast_retry)
+    {
+      estop_controller::xbee->retry_estop();
+    }
+  }
+  else if(estop_controller::heartbeat_enabled)
+  {
+    // Not in e-stop state.  Tell the robots they may keep running.
+    estop_controller::send_heartbeat();
+  }
+}
+void estop_controller::service_switch()
+{
+  // Nothing to do unless the interrupt has seen the switch move.
+  if(!switch_interrupt.changed)
+  {
+    return;
+  }
+
+  // Transition, and get the first e-stop on its way without waiting for the loop.
+  estop_controller::check_switch();
+  if(estop_controller::estop_state)
+  {
+    estop_controller::send_estop();
+  }
+}
+
+bool estop_controller::current_estop_state()
+{
+  return estop_controller::estop_state;
+}
+uint8_t estop_controller::responding_robots()
+{
+  return estop_controller::xbee->census().count_since(millis() - estop_controller::responder_timeout);
+}
+uint8_t estop_controller::known_robots()
+{
+  return estop_controller::xbee->census().count();
+}
+
+bool estop_controller::read_switch()
+{
+  noInterrupts();
+  switch_interrupt.changed = false;
+  // Bounce can settle on the other level inside the lockout, with no edge after it, so re-read the pin once it is over.
+  if(micros() - switch_interrupt.edge >= switch_interrupt.lockout)
+  {
+    bool level = (*switch_interrupt.input & switch_interrupt.mask) != 0;
+    if(level != switch_interrupt.level)
+    {
+      switch_interrupt.level = level;
+      switch_interrupt.edge = micros();
+    }
+  }
+  bool level = switch_interrupt.level;
+  interrupts();
+  return level;
+}
+void estop_controller::check_switch()
+{
+  // Check for a state change.
+  bool new_state = estop_controller::read_switch();
   if(new_state && !estop_controller::estop_state)
   {
     // State transition from false to true.
@@ -37,27 +160,17 @@ void estop_controller::spin_once()
     estop_controller::update_state(new_state);
   }
   // Else no change in state.
-
-  // Perform state activities.
-  if(estop_controller::estop_state)
-  {
-    // Currently in e-stop state.  Broadcast e-stops at specified rate.
-    // Check if enough time has elapsed since last state action.
-    if(estop_controller::estop_broadcast_rate * 1000 < (millis() - estop_controller::state_action_timestamp))
-    {
-      // Enough time has passed since last state action to meet specified action rate.
-      // Update last action timestamp first, since it will take time to execute the broadcast.    
-      estop_controller::state_action_timestamp = millis();
-      // Perform state action.
-      estop_controller::xbee->broadcast_estop();
-      //estop_controller::xbee->broadcast_test_packet();
-    }
-  }
 }
-
-bool estop_controller::current_estop_state()
+void estop_controller::send_estop()
 {
-  return estop_controller::estop_state;
+  uint32_t now = millis();
+  if(estop_controller::estop_broadcasts.due(now))
+  {
+    // Perform state action.
+    estop_controller::xbee->broadcast_estop();
+    //estop_controller::xbee->broadcast_test_packet();
+    estop_controller::estop_broadcasts.sent(now);
+  }
 }
 
 void estop_controller::update_state(bool new_estop_state)
@@ -67,8 +180,46 @@ void estop_controller::update_state(bool new_estop_state)
   {
     // Update internal state.
     estop_controller::estop_state = new_estop_state;
+    if(new_estop_state)
+    {
+      ESTOP_PROBE(state_change);
+      // Robots confirm afresh for each e-stop.
+      estop_controller::xbee->begin_estop();
+    }
 
-    // Reset last action timestamp.
-    estop_controller::state_action_timestamp = 0;
+    // Start the broadcast schedule over, with the first broadcast due immediately.
+    estop_controller::estop_broadcasts.restart(millis());
+    // Resume heartbeats right away on leaving the e-stop state.
+    estop_controller::heartbeat_deadline = millis();
+  }
+}
+void estop_controller::send_heartbeat()
+{
+  // Without good power the transmitter can't be trusted to e-stop, so let the robots' dead-man timers run out.
+  if(!estop_controller::battery_monitor->power_good())
+  {
+    return;
+  }
+
+  // Check if the next heartbeat is due.
+  uint32_t now = millis();
+  if(static_cast<int32_t>(now - estop_controller::heartbeat_deadline) < 0)
+  {
+    return;
+  }
+
+  // Send the heartbeat.  If the serial port is backed up, try again next spin.
+  if(!estop_controller::xbee->broadcast_heartbeat())
+  {
+    return;
+  }
+
+  // Schedule the next heartbeat a period after this one was due, so the rate holds steady despite loop jitter.  If the
+  // loop has fallen more than a period behind, start again from now rather than sending a burst to catch up.
+  const uint32_t period = static_cast<uint32_t>(1000 / estop_controller::heartbeat_rate);
+  estop_controller::heartbeat_deadline += period;
+  if(static_cast<int32_t>(now - estop_controller::heartbeat_deadline) >= 0)
+  {
+    estop_controller::heartbeat_deadline = now + period;
   }
 }
@@ -6,6 +6,7 @@
 #include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
 
 #include "battery_monitor.h"
+#include "broadcast_schedule.h"
 #include "xbee.h"
 
 namespace estop {
@@ -24,9 +25,20 @@ public:
   /// \brief spin_once Performs a single iteration of the estop_controller's duties.
   /// \details This monitors for state changes and performs state actions accordingly.
   void spin_once();
+  /// \brief service_switch Acts on a switch change flagged by the switch's pin-change interrupt, if there is one.
+  /// \details Called from yield(), so a switch thrown while the loop is sleeping or waiting on the XBee is acted on
+  /// straight away rather than at the next spin_once().  Safe to call wherever the XBee is between frames, as it is in
+  /// delay() and xbee::wait().
+  void service_switch();
   /// \brief current_estop_state Gets the current E-Stop state of the controller.
   /// \returns TRUE if in an E-Stop state, otherwise FALSE.
   bool current_estop_state();
+  /// \brief responding_robots Gets the number of robots that have recently acknowledged an E-Stop broadcast.
+  /// \returns The number of robots with an OK response within the last responder_timeout milliseconds.
+  uint8_t responding_robots();
+  /// \brief known_robots Gets the number of robots that have ever responded to an E-Stop broadcast.
+  /// \returns The number of robots in the XBee's responder census.
+  uint8_t known_robots();
   
 private:
   // COMPONENT POINTERS
@@ -38,20 +50,50 @@ private:
   // CONFIGURATION VARIABLES
   /// \brief switch_pin The digital input pin that the toggle switch is connected to.
   const uint16_t switch_pin = 9;
-  /// \brief estop_broadcast_rate The rate, in Hz, at which E-Stop commands will be broadcasted during an E-Stop state.
-  const float estop_broadcast_rate = 1;
+  /// \brief switch_lockout The time, in microseconds, that the switch's pin-change interrupt ignores further edges after
+  /// accepting one.
+  /// \details The first edge is acted on at once; contact bounce within the lockout is ignored, and the settled level
+  /// is re-read once it has passed.
+  const uint32_t switch_lockout = 10000;
+  /// \brief estop_schedule The schedule on which E-Stop commands are broadcast during an E-Stop state.
+  /// \details The first broadcast goes out as soon as the switch is thrown.  A quick burst follows, so a lost broadcast
+  /// costs tens of milliseconds rather than a second, then the rate backs off to 1 Hz.
+  const broadcast_schedule::phase estop_schedule[3] = {{5, 20, 5}, {5, 200, 20}, {1, 1000, 50}};
+  /// \brief unicast_retry Enables acknowledged unicast E-Stop retries to known robots that miss a broadcast.
+  const bool unicast_retry = true;
+  /// \brief responder_timeout The time, in milliseconds, after which a robot that stops responding is no longer counted as responding.
+  /// \details Spans a few broadcasts, so a single lost response doesn't drop a robot from the count.
+  const uint32_t responder_timeout = 3500;
+  /// \brief heartbeat_enabled Enables dead-man mode: "run permitted" heartbeats are broadcast while not in an E-Stop state.
+  /// \details Robots configured for dead-man mode stop when heartbeats go missing, so a dead transmitter, a flat battery,
+  /// or a lost link stops them too.  Heartbeats also stop when the battery monitor reports that power is not good.
+  const bool heartbeat_enabled = false;
+  /// \brief heartbeat_rate The rate, in Hz, at which heartbeats are broadcast in dead-man mode.
+  /// \details Each heartbeat is 18 bytes on the XBee's UART, so 20 Hz uses about 40% of a 9600 baud link.
+  const float heartbeat_rate = 15;
 
   // VARIABLES
   /// \brief estop_state The current E-Stop state.  TRUE indicates emergency stop mode, otherwise FALSE.
   bool estop_state;
-  /// \brief state_action_timestamp The last timestamp, in milliseconds, at which a state action was executed.
-  /// \note This is reset back to zero during each state transition.
-  uint32_t state_action_timestamp;
+  /// \brief estop_broadcasts Schedules E-Stop broadcasts.
+  /// \note This is restarted on each transition into the E-Stop state.
+  broadcast_schedule estop_broadcasts;
+  /// \brief heartbeat_deadline The timestamp, in milliseconds, at which the next heartbeat is due.
+  uint32_t heartbeat_deadline;
 
   // METHODS
-  /// \brief update_state A helper method for updating the current e-stop state and setting the state_action_timestamp.
+  /// \brief update_state A helper method for updating the current e-stop state and restarting the broadcast schedule.
   /// \param new_estop_state The new state to update to.
   void update_state(bool new_estop_state);
+  /// \brief read_switch A helper method for reading the debounced switch state.
+  /// \returns TRUE if the switch is in the e-stop position, otherwise FALSE.
+  bool read_switch();
+  /// \brief check_switch A helper method for transitioning state on a change in switch position.
+  void check_switch();
+  /// \brief send_estop A helper method for broadcasting e-stops on schedule.
+  void send_estop();
+  /// \brief send_heartbeat A helper method for broadcasting dead-man heartbeats on schedule.
+  void send_heartbeat();
 };
 
 }
@@ -3,12 +3,54 @@
 #include "estop_controller.h"
 #include "serial_manager.h"
 #include "oled_display.h"
+#include "task_scheduler.h"
+#include "latency_probe.h"
 
 estop::battery_monitor* battery_monitor;
 estop::xbee* xbee;
 estop::estop_controller* estop_controller;
 estop::serial_manager* serial_manager;
 estop::oled_display* oled;
+estop::task_scheduler* scheduler;
+
+// CALLBACKS
+void set_xbee_baud(uint32_t baud, void*)
+{
+  // Let anything written at the old rate finish going out first.
+  Serial1.flush();
+  Serial1.begin(baud);
+}
+
+// TASKS
+void spin_estop(void*)
+{
+  estop_controller->spin_once();
+  ESTOP_PROBE_POLL();
+}
+void spin_xbee(void*)
+{
+  // Forwarding mode passes XBee bytes straight through to USB, so only parse them otherwise.
+  if(!serial_manager->is_forwarding())
+  {
+    xbee->spin_once();
+  }
+}
+void spin_serial(void*)
+{
+  serial_manager->spin_once();
+}
+void spin_battery(void*)
+{
+  battery_monitor->spin_once();
+}
+void spin_display(void*)
+{
+  oled->spin_once();
+}
+void flush_display(void*)
+{
+  oled->flush_once();
+}
 
 void setup()
 {
@@ -20,7 +62,8 @@ void setup()
 
   // Initialize components.  
   battery_monitor = new estop::battery_monitor();
-  xbee = new estop::xbee();
+  // The API mode must match AP in xbee_profiles/e-stop_configuration.xpro.
+  xbee = new estop::xbee(Serial1, estop::xbee_parser::api_mode::unescaped);
   estop_controller = new estop::estop_controller(battery_monitor, xbee);
   serial_manager = new estop::serial_manager(xbee);
   oled = new estop::oled_display(battery_monitor, xbee, estop_controller, serial_manager);
@@ -28,17 +71,39 @@ void setup()
   // Display loading splash, and wait for XBee to come online.
   oled->splash();
   delay(500);
-  // Probe XBee for device/team names and display.
+  // Move the XBee's UART from 9600 baud to the fastest rate that checks out, so each e-stop frame takes a fraction of
+  // the time to reach it.  On this 8 MHz board that can be 115200, which both ends really run at about 111111.  The new
+  // rate isn't saved, so the XBee still boots at the rate in its profile.  Forwarding mode passes bytes through at
+  // whatever rate this leaves Serial1 at.
+  xbee->negotiate_baud(&set_xbee_baud, NULL, 115200, false);
+  // Read the XBee's configuration once, then display device/team names from it.
+  xbee->load_configuration();
   oled->update_names();
+
+  // Schedule components, most urgent first.  Period (ms), priority (0 = highest).
+  scheduler = new estop::task_scheduler();
+  scheduler->add(&spin_estop, NULL, 1, 0);
+  scheduler->add(&spin_xbee, NULL, 5, 1);
+  scheduler->add(&spin_serial, NULL, 5, 2);
+  // Sample the battery often enough that power_good() stops the heartbeats soon after a brownout.
+  scheduler->add(&spin_battery, NULL, 25, 3);
+  scheduler->add(&spin_display, NULL, 200, 4);
+  // Each flush is one short I2C transmission, so changes go out in pieces between everything else.
+  scheduler->add(&flush_display, NULL, 1, 5);
 }
 
 void loop()
 {
-  // Spin components.
-  estop_controller->spin_once();
-  serial_manager->spin_once();
-  oled->spin_once();
-  
-  // Sleep for 25ms before looping.
-  delay(25);
+  // Run the next task that is due, or sleep until the next interrupt.  The e-stop switch is serviced while idle, from yield().
+  scheduler->spin_once();
+}
+
+void yield()
+{
+  // delay(), the XBee's waits, and the scheduler's idle time call this, which makes them safe points to act on the e-stop switch.
+  if(estop_controller)
+  {
+    estop_controller->service_switch();
+  }
+  ESTOP_PROBE_POLL();
 }
@@ -0,0 +1,130 @@
+#include "latency_probe.h"
+
+#if ESTOP_LATENCY_PROBES
+
+#include <util/atomic.h>
+
+using namespace estop;
+
+// VARIABLES
+volatile latency_probe::point latency_probe::m_next = latency_probe::point::done;
+volatile uint32_t latency_probe::m_stamps[4];
+latency_probe::histogram latency_probe::m_histograms[latency_probe::stage_count];
+uint16_t latency_probe::m_abandoned = 0;
+
+// METHODS
+void latency_probe::poll()
+{
+  if(latency_probe::m_next != latency_probe::point::uart_drained)
+  {
+    return;
+  }
+#if defined(TXC1)
+  // Serial1 clears TXC1 each time it loads a byte, so it is only set once its buffer is empty and the last stop bit is out.
+  if(!(UCSR1A & _BV(TXC1)))
+  {
+    return;
+  }
+#endif
+  latency_probe::stamp(latency_probe::point::uart_drained);
+}
+void latency_probe::reset()
+{
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    latency_probe::m_next = latency_probe::point::done;
+    latency_probe::m_abandoned = 0;
+  }
+  memset(latency_probe::m_histograms, 0, sizeof(latency_probe::m_histograms));
+}
+uint8_t latency_probe::bucket(uint32_t time)
+{
+  uint8_t index = 0;
+  for(time >>= 4; time != 0 && index < latency_probe::bucket_count - 1; time >>= 1)
+  {
+    index++;
+  }
+  return index;
+}
+
+// PROPERTIES
+const latency_probe::histogram& latency_probe::stage_histogram(stage s)
+{
+  return latency_probe::m_histograms[static_cast<uint8_t>(s)];
+}
+uint16_t latency_probe::abandoned()
+{
+  uint16_t count;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    count = latency_probe::m_abandoned;
+  }
+  return count;
+}
+
+// PRIVATE METHODS
+void latency_probe::record(point p, uint32_t time)
+{
+  uint32_t stamps[4];
+  bool complete = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+  {
+    // Check again, now that the switch's interrupt can't get in between.
+    if(p == latency_probe::point::switch_edge)
+    {
+      // An edge before the state has changed is just the switch moving (or being released); after, the frame never made it out.
+      if(latency_probe::m_next == latency_probe::point::send_start || latency_probe::m_next == latency_probe::point::uart_drained)
+      {
+        latency_probe::m_abandoned++;
+      }
+    }
+    else if(p != latency_probe::m_next)
+    {
+      return;
+    }
+
+    uint8_t index = static_cast<uint8_t>(p);
+    latency_probe::m_stamps[index] = time;
+    latency_probe::m_next = static_cast<latency_probe::point>(index + 1);
+    if(latency_probe::m_next == latency_probe::point::done)
+    {
+      for(uint8_t i = 0; i < 4; i++)
+      {
+        stamps[i] = latency_probe::m_stamps[i];
+      }
+      complete = true;
+    }
+  }
+
+  // Only the last point, polled from the loop, gets here, so the histograms are never touched from an interrupt.
+  if(complete)
+  {
+    latency_probe::add(latency_probe::stage::switch_to_state, stamps[1] - stamps[0]);
+    latency_probe::add(latency_probe::stage::state_to_send, stamps[2] - stamps[1]);
+    latency_probe::add(latency_probe::stage::send_to_drain, stamps[3] - stamps[2]);
+    latency_probe::add(latency_probe::stage::total, stamps[3] - stamps[0]);
+  }
+}
+void latency_probe::add(stage s, uint32_t time)
+{
+  histogram& h = latency_probe::m_histograms[static_cast<uint8_t>(s)];
+  if(h.count == 0 || time < h.min)
+  {
+    h.min = time;
+  }
+  if(time > h.max)
+  {
+    h.max = time;
+  }
+  if(h.count < 0xFFFF)
+  {
+    h.count++;
+  }
+  uint16_t& bucket = h.buckets[latency_probe::bucket(time)];
+  if(bucket < 0xFFFF)
+  {
+    bucket++;
+  }
+}
+
+#endif
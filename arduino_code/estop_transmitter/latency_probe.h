@@ -0,0 +1,139 @@
+/// \file latency_probe.h
+/// \brief Defines the latency_probe class, and the ESTOP_PROBE macros that instrument the e-stop path with it.
+#ifndef latency_probe_h
+#define latency_probe_h
+
+#include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
+
+/// \brief ESTOP_LATENCY_PROBES Set to 1 to build the e-stop latency probes in.
+/// \details With 0, every ESTOP_PROBE macro compiles to nothing and the latency_probe has no storage.  The latency
+/// report message is still answered, with no histograms, so the host can tell which build it is talking to.
+#ifndef ESTOP_LATENCY_PROBES
+#define ESTOP_LATENCY_PROBES 0
+#endif
+
+#if ESTOP_LATENCY_PROBES
+/// \brief ESTOP_PROBE Timestamps a latency_probe::point now.
+#define ESTOP_PROBE(p) estop::latency_probe::stamp(estop::latency_probe::point::p)
+/// \brief ESTOP_PROBE_AT Timestamps a latency_probe::point with a time already taken from micros().
+#define ESTOP_PROBE_AT(p, time) estop::latency_probe::stamp(estop::latency_probe::point::p, (time))
+/// \brief ESTOP_PROBE_POLL Checks for the UART draining.  Call wherever the loop waits.
+#define ESTOP_PROBE_POLL() estop::latency_probe::poll()
+#else
+#define ESTOP_PROBE(p) do {} while(0)
+#define ESTOP_PROBE_AT(p, time) do {} while(0)
+#define ESTOP_PROBE_POLL() do {} while(0)
+#endif
+
+namespace estop {
+
+/// \brief latency_probe Measures the time from the e-stop switch being thrown to the first e-stop frame leaving the XBee's UART.
+/// \details Each switch edge starts a new measurement, which then follows the path point by point: the transition into
+/// the e-stop state, the start of the e-stop broadcast, and the UART's transmitter going idle after it.  Points reached
+/// out of order are ignored, so heartbeats, later broadcasts, and release edges don't disturb a measurement.  Once the
+/// UART drains, each stage is added to its histogram.
+///
+/// Every point but the last is stamped inline, from micros(), for the cost of a compare and a store.  The UART has no
+/// interrupt to stamp its drain from (TXC1's is left alone, since servicing it clears the flag that Serial1.flush()
+/// waits on), so it is polled from yield() and the e-stop task instead.  That stamp is late by at most one timer 0 tick,
+/// about 1 ms, which the scheduler sleeps through.
+///
+/// The probe is static, since the switch's interrupt, the controller, and the xbee all stamp it.
+class latency_probe
+{
+public:
+  // ENUMERATIONS
+  /// \brief point Enumerates the points along the e-stop path, in order.
+  enum class point : uint8_t
+  {
+    switch_edge = 0,    ///< The switch's pin-change interrupt accepted an edge.
+    state_change = 1,   ///< estop_controller::update_state() entered the e-stop state.
+    send_start = 2,     ///< xbee::broadcast_estop() started writing the frame.
+    uart_drained = 3,   ///< The UART finished shifting the frame out.
+    done = 4            ///< Not a point.  The measurement is complete, or none has started.
+  };
+  /// \brief stage Enumerates the histograms.
+  enum class stage : uint8_t
+  {
+    switch_to_state = 0,  ///< From switch_edge to state_change.
+    state_to_send = 1,    ///< From state_change to send_start.
+    send_to_drain = 2,    ///< From send_start to uart_drained.
+    total = 3             ///< From switch_edge to uart_drained.
+  };
+
+  // CONSTANTS
+  /// \brief stage_count The number of histograms.
+  static const uint8_t stage_count = 4;
+  /// \brief bucket_count The number of buckets in each histogram.
+  /// \details Bucket 0 counts times under 16 us, bucket n times from 2^(n+3) us up to 2^(n+4) us, and the last bucket
+  /// everything from 2^18 us (262 ms) up.
+  static const uint8_t bucket_count = 16;
+
+  // STRUCTURES
+  /// \brief histogram The distribution of one stage's times.
+  struct histogram
+  {
+    /// \brief count The number of times recorded.  Saturates.
+    uint16_t count;
+    /// \brief min The shortest time, in microseconds.
+    uint32_t min;
+    /// \brief max The longest time, in microseconds.
+    uint32_t max;
+    /// \brief buckets The number of times in each bucket.  Saturates.
+    uint16_t buckets[bucket_count];
+  };
+
+  // METHODS
+  /// \brief stamp Timestamps a point now, if it is the next point of the measurement in progress.
+  static inline void stamp(point p)
+  {
+    if(p == point::switch_edge || p == latency_probe::m_next)
+    {
+      latency_probe::record(p, micros());
+    }
+  }
+  /// \brief stamp Timestamps a point, if it is the next point of the measurement in progress.
+  /// \param time The time of the point, from micros().
+  static inline void stamp(point p, uint32_t time)
+  {
+    if(p == point::switch_edge || p == latency_probe::m_next)
+    {
+      latency_probe::record(p, time);
+    }
+  }
+  /// \brief poll Stamps uart_drained if a measurement is waiting on it and the UART has gone idle.
+  static void poll();
+  /// \brief reset Clears the histograms and abandons any measurement in progress.
+  static void reset();
+  /// \brief bucket Gets the histogram bucket a time falls in.
+  /// \param time The time, in microseconds.
+  static uint8_t bucket(uint32_t time);
+
+  // PROPERTIES
+  /// \brief stage_histogram Gets the histogram of a stage.
+  static const latency_probe::histogram& stage_histogram(stage s);
+  /// \brief abandoned Gets the number of measurements cut short by a new switch edge after the state had changed.
+  static uint16_t abandoned();
+
+private:
+  // VARIABLES
+  /// \brief m_next The next point expected, or point::done.
+  static volatile point m_next;
+  /// \brief m_stamps The times, from micros(), of each point of the measurement in progress.
+  static volatile uint32_t m_stamps[4];
+  /// \brief m_histograms The histogram of each stage.
+  static histogram m_histograms[stage_count];
+  /// \brief m_abandoned The number of measurements abandoned.
+  static uint16_t m_abandoned;
+
+  // METHODS
+  /// \brief record Stores a point's time, advances the measurement, and completes it after the last point.
+  /// \details Safe to call from an interrupt.
+  static void record(point p, uint32_t time);
+  /// \brief add Adds a time to a stage's histogram.
+  static void add(stage s, uint32_t time);
+};
+
+}
+
+#endif
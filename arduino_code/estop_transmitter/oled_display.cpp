@@ -2,6 +2,13 @@
 
 using namespace estop;
 
+namespace {
+
+/// \brief glyph_characters The characters in the glyph cache, which are all the fields other than the names use.
+const char glyph_characters[] = "0123456789%/EFLR";
+
+}
+
 // CONSTRUCTORS
 oled_display::oled_display(estop::battery_monitor* battery_monitor, estop::xbee* xbee, estop::estop_controller* estop_controller, estop::serial_manager* serial_manager)
     // Initialize the display member.
@@ -14,7 +21,7 @@ oled_display::oled_display(estop::battery_monitor* battery_monitor, estop::xbee*
   oled_display::m_serial_manager = serial_manager;
   
   // Set up the display, instructing it to use internal regulator and I2C address 0x3C.
-  oled_display::m_display.begin(SSD1306_SWITCHCAPVCC, 0x3C);  
+  oled_display::m_display.begin(SSD1306_SWITCHCAPVCC, oled_display::i2c_address);
 
   // Clear anything that may have been left on the display.
   oled_display::m_display.clearDisplay();
@@ -25,11 +32,20 @@ oled_display::oled_display(estop::battery_monitor* battery_monitor, estop::xbee*
   // Set text color for SSD1306.
   oled_display::m_display.setTextColor(SSD1306_WHITE);
 
+  // Render the glyphs the fields are drawn with, in their rotated form.
+  oled_display::cache_glyphs();
+
   // Set empty names for device/team.
   oled_display::m_device_name = NULL;
   oled_display::m_team_name = NULL;
   oled_display::m_dn_length = 0;
   oled_display::m_tn_length = 0;
+
+  // Nothing has been drawn yet, so the first redraw sends everything.
+  memset(&(oled_display::m_shown), 0, sizeof(oled_display::m_shown));
+  oled_display::m_redraw_all = true;
+  oled_display::mark_clean();
+  oled_display::m_flush_step = flush_step::idle;
 }
 
 
@@ -40,27 +56,27 @@ void oled_display::update_names()
   if(oled_display::m_device_name)
   {
     delete [] oled_display::m_device_name;
+    oled_display::m_device_name = NULL;
     oled_display::m_dn_length = 0;
   }
   if(oled_display::m_team_name)
   {
     delete [] oled_display::m_team_name;
+    oled_display::m_team_name = NULL;
     oled_display::m_tn_length = 0;
   }
   
-  // Get an updated set up team/device names from the Xbee.
-  char* ni;
-  uint16_t ni_length;
-  if(oled_display::m_xbee->get_node_identifier(ni, ni_length))
+  // Get an updated set up team/device names from the Xbee's cached configuration.
+  const char* ni;
+  uint8_t ni_length;
+  if(oled_display::m_xbee->node_identifier(ni, ni_length))
   {    
     // Extract names into local variables.
     oled_display::m_xbee->extract_device_name(ni, ni_length, oled_display::m_device_name, oled_display::m_dn_length);
     oled_display::m_xbee->extract_team_name(ni, ni_length, oled_display::m_team_name, oled_display::m_tn_length);
 
-    // Clean up ni string.
-    delete [] ni;
-
-    // Signal immediate display update.
+    // Signal immediate display update.  Names can be any length, so send the whole display.
+    oled_display::m_redraw_all = true;
     oled_display::redraw();
   }
 }
@@ -75,6 +91,53 @@ void oled_display::spin_once()
   // Redraw the display.
   oled_display::redraw();
 }
+void oled_display::flush_once()
+{
+  if(oled_display::m_flush_step == flush_step::idle && !oled_display::start_flush())
+  {
+    return;
+  }
+
+  Wire.setClock(oled_display::i2c_clock);
+  Wire.beginTransmission(oled_display::i2c_address);
+  switch(oled_display::m_flush_step)
+  {
+    case flush_step::column_window:
+    {
+      Wire.write(static_cast<uint8_t>(0x00));   // Control: command stream.
+      Wire.write(static_cast<uint8_t>(SSD1306_COLUMNADDR));
+      Wire.write(oled_display::m_flush_first);
+      Wire.write(oled_display::m_flush_last);
+      oled_display::m_flush_step = flush_step::page_window;
+      break;
+    }
+    case flush_step::page_window:
+    {
+      Wire.write(static_cast<uint8_t>(0x00));   // Control: command stream.
+      Wire.write(static_cast<uint8_t>(SSD1306_PAGEADDR));
+      Wire.write(oled_display::m_flush_page);
+      Wire.write(oled_display::m_flush_page);
+      oled_display::m_flush_step = flush_step::data;
+      break;
+    }
+    default:
+    {
+      // Copy the next piece straight from the frame buffer, as it is now.
+      uint8_t remaining = oled_display::m_flush_last - oled_display::m_flush_next + 1;
+      uint8_t count = (remaining > oled_display::i2c_chunk) ? oled_display::i2c_chunk : remaining;
+      Wire.write(static_cast<uint8_t>(0x40));   // Control: data stream.
+      Wire.write(oled_display::m_display.getBuffer() + static_cast<uint16_t>(oled_display::m_flush_page) * oled_display::width + oled_display::m_flush_next, count);
+      oled_display::m_flush_next += count;
+      if(count == remaining)
+      {
+        oled_display::m_flush_step = flush_step::idle;
+      }
+      break;
+    }
+  }
+  Wire.endTransmission();
+  Wire.setClock(oled_display::i2c_idle_clock);
+}
 void oled_display::splash()
 {
   // Clear the display.
@@ -105,33 +168,225 @@ void oled_display::draw_text(uint16_t x, uint16_t y, String text, uint16_t scale
   oled_display::m_display.println(text);
 }
 void oled_display::redraw()
-{ 
-  // Clear the display.
-  oled_display::m_display.clearDisplay();
+{
+  // Gather the information to show.
+  shown_state state;
+  state.battery = oled_display::m_battery_monitor->filtered_percentage();
+  state.has_link = oled_display::m_serial_manager->link_quality(state.link);
+  if(!state.has_link)
+  {
+    state.link = 0;
+  }
+  state.forwarding = oled_display::m_serial_manager->is_forwarding();
+  state.estop = oled_display::m_estop_controller->current_estop_state();
+  state.known_robots = oled_display::m_estop_controller->known_robots();
+  state.responding_robots = (state.known_robots > 0) ? oled_display::m_estop_controller->responding_robots() : 0;
+
+  // Find the fields that differ from what's shown.
+  bool all = oled_display::m_redraw_all;
+  bool battery_changed = all || state.battery != oled_display::m_shown.battery;
+  bool link_changed = all || state.has_link != oled_display::m_shown.has_link || state.link != oled_display::m_shown.link;
+  bool forwarding_changed = all || state.forwarding != oled_display::m_shown.forwarding;
+  bool estop_changed = all || state.estop != oled_display::m_shown.estop;
+  bool robots_changed = all || state.known_robots != oled_display::m_shown.known_robots || state.responding_robots != oled_display::m_shown.responding_robots;
+
+  // Leave a static display, and the I2C bus, alone.
+  if(!battery_changed && !link_changed && !forwarding_changed && !estop_changed && !robots_changed)
+  {
+    return;
+  }
+  oled_display::m_shown = state;
+
+  // Clearing a field on the top row would cut into a device name long enough to reach it, so start over instead.
+  if((battery_changed || forwarding_changed || estop_changed) && oled_display::m_dn_length * oled_display::cell_width > 70)
+  {
+    all = true;
+  }
+
+  // The names are only rasterized when starting over.  Otherwise they are still in the frame buffer.
+  if(all)
+  {
+    oled_display::m_display.clearDisplay();
+
+    // Draw the device name in top left corner.
+    oled_display::draw_text(0, 0, oled_display::m_device_name, oled_display::m_dn_length, 1);
+
+    // Draw the team name on the bottom.
+    oled_display::draw_text(0, 16, oled_display::m_team_name, oled_display::m_tn_length, 2);
+
+    for(uint8_t page = 0; page < oled_display::page_count; page++)
+    {
+      oled_display::mark_dirty(0, page, oled_display::width);
+    }
+    oled_display::m_redraw_all = false;
+  }
 
-  // Draw the device name in top left corner.
-  oled_display::draw_text(0, 0, oled_display::m_device_name, oled_display::m_dn_length, 1);
+  // Each field's area is wide enough for its longest text.
+  char text[8];
+  uint8_t length;
 
   // Draw the battery percentage if the top right corner.
-  String battery_percent = String(oled_display::m_battery_monitor->filtered_percentage());
-  battery_percent.concat("%");
-  oled_display::draw_text(100, 0, battery_percent, 1);
+  if(all || battery_changed)
+  {
+    length = oled_display::format_number(text, state.battery);
+    text[length++] = '%';
+    oled_display::draw_field(100, 0, oled_display::width - 100, text, length);
+  }
+
+  // Draw the serial link quality under the battery percentage, once there has been traffic.
+  if(all || link_changed)
+  {
+    length = 0;
+    if(state.has_link)
+    {
+      text[length++] = 'L';
+      length += oled_display::format_number(text + length, state.link);
+      text[length++] = '%';
+    }
+    oled_display::draw_field(92, 1, oled_display::width - 92, text, length);
+  }
 
   // Draw 'F' if in forwarding mode.
-  if(oled_display::m_serial_manager->is_forwarding())
+  if(all || forwarding_changed)
   {
-    oled_display::draw_text(80, 0, String("F"), 1);
+    oled_display::draw_field(80, 0, oled_display::cell_width, "F", state.forwarding ? 1 : 0);
   }
 
   // Draw 'E' if in e-stop broadcasting mode.
-  if(oled_display::m_estop_controller->current_estop_state())
+  if(all || estop_changed)
   {
-    oled_display::draw_text(70, 0, String("E"), 1);
+    oled_display::draw_field(70, 0, oled_display::cell_width, "E", state.estop ? 1 : 0);
   }
 
-  // Draw the team name on the bottom.
-  oled_display::draw_text(0, 16, oled_display::m_team_name, oled_display::m_tn_length, 2);
+  // Draw the number of responding/known robots under the device name, once any robot has answered an e-stop.
+  if(all || robots_changed)
+  {
+    length = 0;
+    if(state.known_robots > 0)
+    {
+      text[length++] = 'R';
+      length += oled_display::format_number(text + length, state.responding_robots);
+      text[length++] = '/';
+      length += oled_display::format_number(text + length, state.known_robots);
+    }
+    // Up to "R255/255".
+    oled_display::draw_field(0, 1, 8 * oled_display::cell_width, text, length);
+  }
 
-  // Update drawn display.
-  oled_display::m_display.display();
+  // flush_once() sends only what changed.
+}
+void oled_display::cache_glyphs()
+{
+  // Render each glyph through Adafruit_GFX once, in the top left corner, and keep the columns it left there.
+  uint8_t* buffer = oled_display::m_display.getBuffer();
+  uint16_t offset = oled_display::buffer_offset(0, 0, oled_display::glyph_width);
+  for(uint8_t i = 0; i < oled_display::glyph_count; i++)
+  {
+    oled_display::m_display.fillRect(0, 0, oled_display::cell_width, 8, SSD1306_BLACK);
+    oled_display::m_display.drawChar(0, 0, glyph_characters[i], SSD1306_WHITE, SSD1306_BLACK, 1);
+    memcpy(oled_display::m_glyphs[i], buffer + offset, oled_display::glyph_width);
+  }
+  oled_display::m_display.fillRect(0, 0, oled_display::cell_width, 8, SSD1306_BLACK);
+}
+void oled_display::draw_field(uint8_t x, uint8_t page, uint8_t columns, const char* text, uint8_t text_length)
+{
+  uint8_t* buffer = oled_display::m_display.getBuffer();
+  if(columns > oled_display::width - x)
+  {
+    columns = oled_display::width - x;
+  }
+  memset(buffer + oled_display::buffer_offset(x, page, columns), 0, columns);
+
+  for(uint8_t i = 0; i < text_length; i++)
+  {
+    uint8_t cell = x + i * oled_display::cell_width;
+    if(cell + oled_display::glyph_width > x + columns)
+    {
+      break;
+    }
+    const char* glyph = static_cast<const char*>(memchr(glyph_characters, text[i], oled_display::glyph_count));
+    if(glyph)
+    {
+      memcpy(buffer + oled_display::buffer_offset(cell, page, oled_display::glyph_width), oled_display::m_glyphs[glyph - glyph_characters], oled_display::glyph_width);
+    }
+  }
+
+  oled_display::mark_dirty(x, page, columns);
+}
+uint16_t oled_display::buffer_offset(uint8_t x, uint8_t page, uint8_t columns)
+{
+  // The frame buffer is kept unrotated, with one byte per column of each page.  Rotating by 180 degrees reverses
+  // both the pages and the columns, and the bits in each byte, which the glyphs already allow for.
+  if(oled_display::m_display.getRotation() == 2)
+  {
+    return static_cast<uint16_t>(oled_display::page_count - 1 - page) * oled_display::width + (oled_display::width - x - columns);
+  }
+  return static_cast<uint16_t>(page) * oled_display::width + x;
+}
+uint8_t oled_display::format_number(char* text, uint8_t value)
+{
+  uint8_t length = 0;
+  if(value >= 100)
+  {
+    text[length++] = '0' + value / 100;
+  }
+  if(value >= 10)
+  {
+    text[length++] = '0' + (value / 10) % 10;
+  }
+  text[length++] = '0' + value % 10;
+  return length;
+}
+
+// PRIVATE METHODS - UPDATES
+void oled_display::mark_dirty(uint8_t x, uint8_t page, uint8_t columns)
+{
+  uint8_t last = (columns > oled_display::width - x) ? oled_display::width - 1 : x + columns - 1;
+  if(oled_display::m_dirty_last[page] < oled_display::m_dirty_first[page])
+  {
+    oled_display::m_dirty_first[page] = x;
+    oled_display::m_dirty_last[page] = last;
+    return;
+  }
+  if(x < oled_display::m_dirty_first[page])
+  {
+    oled_display::m_dirty_first[page] = x;
+  }
+  if(last > oled_display::m_dirty_last[page])
+  {
+    oled_display::m_dirty_last[page] = last;
+  }
+}
+void oled_display::mark_clean()
+{
+  for(uint8_t page = 0; page < oled_display::page_count; page++)
+  {
+    oled_display::m_dirty_first[page] = 1;
+    oled_display::m_dirty_last[page] = 0;
+  }
+}
+bool oled_display::start_flush()
+{
+  uint8_t page = 0;
+  while(page < oled_display::page_count && oled_display::m_dirty_last[page] < oled_display::m_dirty_first[page])
+  {
+    page++;
+  }
+  if(page == oled_display::page_count)
+  {
+    return false;
+  }
+
+  uint8_t columns = oled_display::m_dirty_last[page] - oled_display::m_dirty_first[page] + 1;
+  uint16_t offset = oled_display::buffer_offset(oled_display::m_dirty_first[page], page, columns);
+  oled_display::m_flush_page = offset / oled_display::width;
+  oled_display::m_flush_first = offset % oled_display::width;
+  oled_display::m_flush_next = oled_display::m_flush_first;
+  oled_display::m_flush_last = oled_display::m_flush_first + columns - 1;
+  oled_display::m_flush_step = flush_step::column_window;
+
+  // Anything drawn from here on marks the page again.
+  oled_display::m_dirty_first[page] = 1;
+  oled_display::m_dirty_last[page] = 0;
+  return true;
 }
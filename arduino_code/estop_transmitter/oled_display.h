@@ -14,9 +14,45 @@
 namespace estop {
 
 /// \brief oled_display A class for managing the e-stop transmitter's 128x32 OLED display.
+/// \details Each redraw compares what would be shown against what was last drawn, and only sends the SSD1306 the
+/// parts of its pages that changed, using its column and page addressing.  A display that isn't changing gets no I2C
+/// traffic at all.
+///
+/// Changes are sent by flush_once(), one short I2C transmission per call, so the display never holds up the e-stop
+/// path for long.  Each transmission is copied from the frame buffer as it is sent.  Drawing can carry on meanwhile:
+/// whatever it changes is marked again and sent after.  So the panel always catches up to the frame buffer, without a
+/// second buffer.
+///
+/// The names are only rasterized when they change, and are otherwise left in the frame buffer.  The other fields are
+/// all small text on page boundaries, so they are copied into the frame buffer from a cache of glyphs rendered once
+/// at startup.
 class oled_display
 {
 public:
+  // CONSTANTS
+  /// \brief width The display's width, in pixels.
+  static const uint8_t width = 128;
+  /// \brief height The display's height, in pixels.
+  static const uint8_t height = 32;
+  /// \brief page_count The number of 8 pixel high pages the SSD1306 divides the display into.
+  static const uint8_t page_count = height / 8;
+  /// \brief i2c_address The display's I2C address.
+  static const uint8_t i2c_address = 0x3C;
+  /// \brief i2c_chunk The most display data bytes sent in one I2C transmission.
+  /// \details Wire blocks until a transmission is out.  At 400 kHz, the address, the control byte, and 2 data bytes
+  /// take about 100 us.
+  static const uint8_t i2c_chunk = 2;
+  /// \brief i2c_clock The I2C clock used while sending to the display, as Adafruit_SSD1306 uses.
+  static const uint32_t i2c_clock = 400000;
+  /// \brief i2c_idle_clock The I2C clock restored after sending to the display, as Adafruit_SSD1306 restores.
+  static const uint32_t i2c_idle_clock = 100000;
+  /// \brief glyph_width The width of a glyph of the default font, in pixels.
+  static const uint8_t glyph_width = 5;
+  /// \brief cell_width The width of a character of the default font, including its spacing, in pixels.
+  static const uint8_t cell_width = 6;
+  /// \brief glyph_count The number of glyphs in the glyph cache.
+  static const uint8_t glyph_count = 16;
+
   // CONSTRUCTORS
   /// \brief oled_display Initializes a new instance of the oled_display class.
   /// \param battery_monitor A pointer to the e-stop's battery_monitor instance.
@@ -29,8 +65,11 @@ public:
   /// \brief update_names Probes the XBee for the currently set device and team names, and updates the display accordingly.
   void update_names();
   /// \brief spin_once Performs a single iteration of the oled_display's duties.
-  /// \details This essentially redraws the latest information onto the display.
+  /// \details This essentially redraws the latest information into the frame buffer.  flush_once() sends it.
   void spin_once();
+  /// \brief flush_once Sends the next piece of any change to the display.
+  /// \details Makes at most one I2C transmission, so call it often.  A full display takes about 260 calls.
+  void flush_once();
   /// \brief splash Displays a "LOADING..." splash screen on the display.
   void splash();
   
@@ -59,6 +98,62 @@ private:
   /// \brief m_tn_length Stores the length of the current m_team_name.
   uint16_t m_tn_length;
 
+  // ENUMERATIONS
+  /// \brief flush_step Enumerates the transmissions that send a page's changed columns.
+  enum class flush_step : uint8_t
+  {
+    idle = 0,           ///< No page is being sent.
+    column_window = 1,  ///< Next, limit the SSD1306's write window to the changed columns.
+    page_window = 2,    ///< Next, limit the SSD1306's write window to the page.
+    data = 3            ///< Next, send the next i2c_chunk of the page's changed columns.
+  };
+
+  // STRUCTURES
+  /// \brief shown_state The information the display is drawn from, less the names.
+  struct shown_state
+  {
+    /// \brief battery The battery percentage.
+    uint8_t battery;
+    /// \brief has_link TRUE if the link quality is shown.
+    bool has_link;
+    /// \brief link The link quality percentage.
+    uint8_t link;
+    /// \brief forwarding TRUE if the 'F' flag is shown.
+    bool forwarding;
+    /// \brief estop TRUE if the 'E' flag is shown.
+    bool estop;
+    /// \brief known_robots The number of known robots.  The robot count is only shown once this is nonzero.
+    uint8_t known_robots;
+    /// \brief responding_robots The number of responding robots.
+    uint8_t responding_robots;
+  };
+
+  // VARIABLES - CHANGE DETECTION
+  /// \brief m_shown Stores the information the display was last drawn from.
+  shown_state m_shown;
+  /// \brief m_redraw_all Indicates that the whole display must be sent on the next redraw, such as after the names change.
+  bool m_redraw_all;
+  /// \brief m_dirty_first Stores the first changed column of each page, in the rotated coordinates drawn in.
+  uint8_t m_dirty_first[page_count];
+  /// \brief m_dirty_last Stores the last changed column of each page, or is less than m_dirty_first if the page is unchanged.
+  uint8_t m_dirty_last[page_count];
+
+  // VARIABLES - FLUSH
+  /// \brief m_flush_step Stores the next transmission of the page being sent.
+  flush_step m_flush_step;
+  /// \brief m_flush_page Stores the SSD1306 page being sent.
+  uint8_t m_flush_page;
+  /// \brief m_flush_first Stores the first SSD1306 column being sent.
+  uint8_t m_flush_first;
+  /// \brief m_flush_next Stores the next SSD1306 column to send.
+  uint8_t m_flush_next;
+  /// \brief m_flush_last Stores the last SSD1306 column being sent.
+  uint8_t m_flush_last;
+
+  // VARIABLES - GLYPH CACHE
+  /// \brief m_glyphs Stores the columns of each cached glyph, as they appear in the frame buffer.
+  uint8_t m_glyphs[glyph_count][glyph_width];
+
   // METHODS - DRAWING
   /// \brief draw_text Draws a c-style array of text to an image for display.
   /// \param x The x coordinate to draw the text at.
@@ -73,8 +168,40 @@ private:
   /// \param text The string of characters to draw.
   /// \param scale OPTIONAL The scale to draw the text at.  Default = 1.
   void draw_text(uint16_t x, uint16_t y, String text, uint16_t scale = 1);
-  /// \brief redraw Updates the display with the most recent information.
+  /// \brief redraw Updates the display with the most recent information, if any of it has changed.
   void redraw();
+  /// \brief cache_glyphs Renders the glyphs of the glyph cache.
+  void cache_glyphs();
+  /// \brief draw_field Replaces a field's area of a page with text from the glyph cache, and marks it as changed.
+  /// \param x The first column of the field.
+  /// \param page The page of the field.
+  /// \param columns The width of the field, which is cleared first, clipped to the edge of the display.
+  /// \param text The text to draw.  Characters missing from the glyph cache are left blank.
+  /// \param text_length The length of the text, in characters.
+  void draw_field(uint8_t x, uint8_t page, uint8_t columns, const char* text, uint8_t text_length);
+  /// \brief buffer_offset Gets where a range of columns of a page starts in the frame buffer, allowing for rotation.
+  /// \param x The first column of the range, in the rotated coordinates drawn in.
+  /// \param page The page, in the rotated coordinates drawn in.
+  /// \param columns The number of columns in the range.
+  /// \returns The offset of the range's lowest column in the frame buffer.  The page is offset / width.
+  uint16_t buffer_offset(uint8_t x, uint8_t page, uint8_t columns);
+  /// \brief format_number Writes a number out in decimal.
+  /// \param text The buffer to write to, which must have room for 3 characters.
+  /// \param value The number to write.
+  /// \returns The number of characters written.
+  static uint8_t format_number(char* text, uint8_t value);
+
+  // METHODS - UPDATES
+  /// \brief mark_dirty Marks part of a page as changed.
+  /// \param x The first column of the change, in the rotated coordinates drawn in.
+  /// \param page The page of the change, in the rotated coordinates drawn in.
+  /// \param columns The number of columns changed, clipped to the edge of the display.
+  void mark_dirty(uint8_t x, uint8_t page, uint8_t columns);
+  /// \brief mark_clean Marks every page as unchanged.
+  void mark_clean();
+  /// \brief start_flush Takes the first changed page's columns to send, and marks the page clean.
+  /// \returns TRUE if a page had changed, otherwise FALSE.
+  bool start_flush();
 };
 
 }
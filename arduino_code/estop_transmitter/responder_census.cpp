@@ -0,0 +1,127 @@
+#include "responder_census.h"
+
+using namespace estop;
+
+// CONSTRUCTORS
+responder_census::responder_census()
+{
+  responder_census::clear();
+}
+
+// METHODS
+void responder_census::record(const uint8_t* address, uint32_t time, uint16_t latency, uint8_t status)
+{
+  uint8_t index = responder_census::slot(address);
+  if(index == responder_census::capacity)
+  {
+    // No room for a new robot.
+    if(responder_census::m_overflowed < 0xFFFF)
+    {
+      responder_census::m_overflowed++;
+    }
+    return;
+  }
+
+  responder& entry = responder_census::m_table[index];
+  if(!entry.used)
+  {
+    // Add the new robot.
+    for(uint8_t i = 0; i < 8; i++)
+    {
+      entry.address[i] = address[i];
+    }
+    entry.used = true;
+    responder_census::m_count++;
+  }
+  entry.last_ack = time;
+  entry.latency = latency;
+  entry.status = status;
+}
+void responder_census::clear()
+{
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
+  {
+    responder_census::m_table[i].used = false;
+  }
+  responder_census::m_count = 0;
+  responder_census::m_overflowed = 0;
+}
+const responder_census::responder* responder_census::find(const uint8_t* address) const
+{
+  uint8_t index = responder_census::slot(address);
+  if(index == responder_census::capacity || !responder_census::m_table[index].used)
+  {
+    return NULL;
+  }
+  return &(responder_census::m_table[index]);
+}
+const responder_census::responder* responder_census::entry(uint8_t index) const
+{
+  if(index >= responder_census::capacity || !responder_census::m_table[index].used)
+  {
+    return NULL;
+  }
+  return &(responder_census::m_table[index]);
+}
+
+// PROPERTIES
+uint8_t responder_census::count() const
+{
+  return responder_census::m_count;
+}
+uint8_t responder_census::count_since(uint32_t time) const
+{
+  uint8_t count = 0;
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
+  {
+    const responder& entry = responder_census::m_table[i];
+    if(entry.used && entry.status == 0x00 && static_cast<int32_t>(entry.last_ack - time) >= 0)
+    {
+      count++;
+    }
+  }
+  return count;
+}
+uint16_t responder_census::overflowed() const
+{
+  return responder_census::m_overflowed;
+}
+
+// PRIVATE METHODS
+uint8_t responder_census::slot(const uint8_t* address) const
+{
+  // Hash the address.  Robots share the Digi OUI prefix, so the low bytes carry most of the differences.
+  uint8_t hash = 0;
+  for(uint8_t i = 0; i < 8; i++)
+  {
+    hash = static_cast<uint8_t>((hash * 31) ^ address[i]);
+  }
+
+  // Probe linearly from the hashed slot.
+  const uint8_t mask = responder_census::capacity - 1;
+  for(uint8_t probe = 0; probe < responder_census::capacity; probe++)
+  {
+    uint8_t index = (hash + probe) & mask;
+    const responder& entry = responder_census::m_table[index];
+    if(!entry.used)
+    {
+      return index;
+    }
+
+    bool match = true;
+    for(uint8_t i = 0; i < 8; i++)
+    {
+      if(entry.address[i] != address[i])
+      {
+        match = false;
+        break;
+      }
+    }
+    if(match)
+    {
+      return index;
+    }
+  }
+
+  return responder_census::capacity;
+}
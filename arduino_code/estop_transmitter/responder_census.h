@@ -0,0 +1,85 @@
+/// \file responder_census.h
+/// \brief Defines the responder_census class.
+#ifndef responder_census_h
+#define responder_census_h
+
+#include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
+
+namespace estop {
+
+/// \brief responder_census A table of the robots that have answered e-stop broadcasts.
+/// \details Robots are keyed by their XBee's 64 bit address in a fixed-size, open-addressed hash table, so the
+/// census never allocates.  Entries are never removed individually, so lookups probe until they find the address
+/// or an empty slot.
+class responder_census
+{
+public:
+  // STRUCTURES
+  /// \brief responder The census entry for a single robot.
+  struct responder
+  {
+    /// \brief address The 64 bit address of the robot's XBee.
+    uint8_t address[8];
+    /// \brief last_ack The time, in milliseconds, of the robot's last response.
+    uint32_t last_ack;
+    /// \brief latency The time, in milliseconds, from the start of the e-stop (the first broadcast) to the robot's last response.
+    uint16_t latency;
+    /// \brief status The AT command status of the robot's last response.  0 = OK.
+    uint8_t status;
+    /// \brief used Flag indicating that the entry holds a robot.
+    bool used;
+  };
+
+  // CONSTANTS
+  /// \brief capacity The number of robots the census can hold.  Must be a power of two.
+  static const uint8_t capacity = 16;
+
+  // CONSTRUCTORS
+  /// \brief responder_census Creates a new, empty census.
+  responder_census();
+
+  // METHODS
+  /// \brief record Records a response from a robot, adding it to the census if it is new.
+  /// \param address The 64 bit address of the robot's XBee.
+  /// \param time The time of the response, in milliseconds.
+  /// \param latency The time from the start of the e-stop to the response, in milliseconds.
+  /// \param status The AT command status of the response.
+  void record(const uint8_t* address, uint32_t time, uint16_t latency, uint8_t status);
+  /// \brief clear Forgets all robots.
+  void clear();
+  /// \brief find Finds the census entry for a robot.
+  /// \param address The 64 bit address of the robot's XBee.
+  /// \returns The entry, or NULL if the robot has never responded.
+  const responder* find(const uint8_t* address) const;
+  /// \brief entry Gets a census entry by index, for iterating over the table.
+  /// \param index The index of the entry, less than capacity.
+  /// \returns The entry, or NULL if the slot is empty.
+  const responder* entry(uint8_t index) const;
+
+  // PROPERTIES
+  /// \brief count Gets the number of robots that have ever responded.
+  uint8_t count() const;
+  /// \brief count_since Gets the number of robots that have responded with an OK status since a given time.
+  /// \param time The time, in milliseconds.
+  uint8_t count_since(uint32_t time) const;
+  /// \brief overflowed Gets the number of responses dropped because the census was full.
+  uint16_t overflowed() const;
+
+private:
+  // VARIABLES
+  /// \brief m_table The hash table of responders.
+  responder m_table[capacity];
+  /// \brief m_count The number of used entries in the table.
+  uint8_t m_count;
+  /// \brief m_overflowed The number of responses dropped because the table was full.
+  uint16_t m_overflowed;
+
+  // METHODS
+  /// \brief slot Finds the slot for an address: the slot holding it, or the empty slot it would go in.
+  /// \returns The index of the slot, or capacity if the address is not present and the table is full.
+  uint8_t slot(const uint8_t* address) const;
+};
+
+}
+
+#endif
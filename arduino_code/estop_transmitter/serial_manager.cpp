@@ -15,6 +15,7 @@ serial_manager::serial_manager(estop::xbee* xb)
 
   // Initialize flags.
   serial_manager::f_team_updated = false;
+  serial_manager::f_team_pending = false;
 }
 
 void serial_manager::spin_once()
@@ -28,6 +29,8 @@ void serial_manager::spin_once()
       serial_manager::communicator->Spin();
       // Handle any received messages.
       serial_manager::handle_messages();
+      // Check on any team update in progress.
+      serial_manager::check_team_update();
       break;
     }
     case serial_manager::operating_mode::forwarding:
@@ -56,13 +59,20 @@ bool serial_manager::team_updated()
   return output;
 }
 
+bool serial_manager::link_quality(uint8_t& percent)
+{
+  const SC::LinkQuality* quality = serial_manager::communicator->pLinkQuality();
+  percent = quality->pPercent();
+  return quality->pSamples() > 0;
+}
+
 void serial_manager::handle_messages()
 {
   // Handle all messages currently in the RX queue.
-  for(uint16_t i = 0; i < serial_manager::communicator->MessagesAvailable(); i++)
+  while(serial_manager::communicator->MessagesAvailable() > 0)
   {
-    // Recieve message from RX queue.
-    const SC::Message* message = serial_manager::communicator->Receive();
+    // Recieve message from RX queue.  The handle returns the message to the communicator when it goes out of scope.
+    SC::MessageHandle message = serial_manager::communicator->Receive();
 
     // Handle message based on ID.
     if(message)
@@ -71,7 +81,7 @@ void serial_manager::handle_messages()
       {
         case serial_manager::message_id::set_team:
         {
-          serial_manager::handle_set_team(message);
+          serial_manager::handle_set_team(message.pMessage());
           break;
         }
         case serial_manager::message_id::set_forwarding_mode:
@@ -79,15 +89,17 @@ void serial_manager::handle_messages()
           serial_manager::handle_set_forwarding_mode();
           break;
         }
+        case serial_manager::message_id::latency_report:
+        {
+          serial_manager::handle_latency_report(message.pMessage());
+          break;
+        }
         default:
         {
           // Do nothing.
         }
       }
     }
-
-    // Clean up the message.
-    delete message;
   }
 }
 void serial_manager::handle_set_team(const SC::Message* message)
@@ -110,36 +122,83 @@ void serial_manager::handle_set_team(const SC::Message* message)
     encryption_key[i] = message->GetData<char>(address++);
   }
 
-  // Update the encryption key first.
-  if(serial_manager::xbee->set_encryption_key(encryption_key, ek_length))
+  // Update the encryption key and team name as a single batch, and save them.
+  // The XBee answers in the background, so e-stop handling carries on meanwhile.
+  if(serial_manager::xbee->set_team(team_name, tn_length, encryption_key, ek_length))
   {
-    // If encryption key was updated successfully, update the team name.
-    if(serial_manager::xbee->set_team_name(team_name, tn_length))
-    {
-      // Both encryption key and team name have been updated.
-      // Save settings to the XBee memory.
-      serial_manager::xbee->save_configuration();
-      
-      // Mark flag.
-      serial_manager::f_team_updated = true;
-    }
+    serial_manager::f_team_pending = true;
   }
 
   // Clean up strings.
   delete [] team_name;
   delete [] encryption_key;
 }
+void serial_manager::check_team_update()
+{
+  if(serial_manager::f_team_pending && serial_manager::xbee->batch_state() != estop::xbee::request_state::pending)
+  {
+    // Mark flag if both encryption key and team name have been updated and saved.
+    serial_manager::f_team_updated = serial_manager::xbee->batch_state() == estop::xbee::request_state::complete;
+    serial_manager::f_team_pending = false;
+  }
+}
 void serial_manager::handle_set_forwarding_mode()
 {
   // Update forwarding mode.
   serial_manager::current_mode = serial_manager::operating_mode::forwarding;
 
+  // The host may reconfigure the XBee directly while forwarding, so stop trusting the cached configuration.
+  serial_manager::xbee->invalidate_configuration();
+
   // Spin the communicator a few more times to ensure that acknowledgments get returned.
   for(uint16_t i = 0; i < 5; i++)
   {
     serial_manager::communicator->Spin();
   }
 }
+void serial_manager::handle_latency_report(const SC::Message* message)
+{
+#if ESTOP_LATENCY_PROBES
+  const uint8_t stages = estop::latency_probe::stage_count;
+  const uint8_t buckets = estop::latency_probe::bucket_count;
+
+  // Send each stage's histogram in its own reply, so every packet fits in the USB serial port's 64 byte buffer.  The
+  // communicator waits for room for a whole packet, and would wait forever on a bigger one.
+  for(uint8_t s = 0; s < stages; s++)
+  {
+    const estop::latency_probe::histogram& h = estop::latency_probe::stage_histogram(static_cast<estop::latency_probe::stage>(s));
+    SC::Message reply(static_cast<uint16_t>(serial_manager::message_id::latency_report), 16 + 2 * buckets);
+    reply.SetData<uint8_t>(0, 1);
+    reply.SetData<uint8_t>(1, stages);
+    reply.SetData<uint8_t>(2, buckets);
+    reply.SetData<uint16_t>(3, estop::latency_probe::abandoned());
+    reply.SetData<uint8_t>(5, s);
+    reply.SetData<uint16_t>(6, h.count);
+    reply.SetData<uint32_t>(8, h.min);
+    reply.SetData<uint32_t>(12, h.max);
+    for(uint8_t b = 0; b < buckets; b++)
+    {
+      reply.SetData<uint16_t>(16 + 2 * b, h.buckets[b]);
+    }
+    serial_manager::communicator->Send(static_cast<SC::Message&&>(reply));
+  }
+
+  // Clear the histograms if asked to, so each report covers a fresh set of switch throws.
+  if(message->pDataLength() > 0 && message->GetData<uint8_t>(0) != 0)
+  {
+    estop::latency_probe::reset();
+  }
+#else
+  // Without the probes, a single reply with no stages says so.
+  SC::Message reply(static_cast<uint16_t>(serial_manager::message_id::latency_report), 5);
+  reply.SetData<uint8_t>(0, 0);
+  reply.SetData<uint8_t>(1, 0);
+  reply.SetData<uint8_t>(2, 0);
+  reply.SetData<uint16_t>(3, 0);
+  serial_manager::communicator->Send(static_cast<SC::Message&&>(reply));
+  (void)message;
+#endif
+}
 
 void serial_manager::forward_data(Stream& from, Stream& to)
 {
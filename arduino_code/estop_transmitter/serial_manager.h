@@ -6,6 +6,7 @@
 #include <Arduino.h>              // Include Arduino.h to enroll class h/cpp file in compilation.
 #include <SerialCommunicator.h>   // Adds serial communication functionality.
 
+#include "latency_probe.h"
 #include "xbee.h"
 
 namespace estop {
@@ -22,6 +23,10 @@ public:
 
   bool is_forwarding();
   bool team_updated();
+  /// \brief link_quality Gets the quality of the serial link to the host.
+  /// \param percent The link quality as a percentage, from the communicator's receipt and checksum history.
+  /// \return TRUE if there has been traffic to estimate from, otherwise FALSE.
+  bool link_quality(uint8_t& percent);
   
 private:  
   enum class operating_mode
@@ -32,7 +37,8 @@ private:
   enum class message_id
   {
     set_team = 0x1001,
-    set_forwarding_mode = 0x1002
+    set_forwarding_mode = 0x1002,
+    latency_report = 0x1003
   };
   
   SC::Communicator* communicator;
@@ -40,6 +46,8 @@ private:
 
   operating_mode current_mode;
   bool f_team_updated;
+  /// \brief f_team_pending Flag indicating that a team update has been sent to the XBee, but not answered yet.
+  bool f_team_pending;
 
   /// \brief forward_data Forwards all current data from one serial port to another.
   /// \param from The serial port to forward data from.
@@ -48,7 +56,16 @@ private:
 
   void handle_messages();
   void handle_set_team(const SC::Message* message);  
+  /// \brief check_team_update Checks if a team update in progress has finished, and sets f_team_updated if it succeeded.
+  void check_team_update();
   void handle_set_forwarding_mode();
+  /// \brief handle_latency_report Answers a latency report request with the latency_probe's histograms.
+  /// \details The request may carry one byte; if it is nonzero, the histograms are cleared once reported.  There is one
+  /// reply per stage, with the same ID, so that each fits in a 64 byte USB packet.  Each holds enabled (u8, 0 if the
+  /// probes are compiled out), stage_count (u8), bucket_count (u8), abandoned (u16), and the stage (u8), then that
+  /// stage's count (u16), min (u32), max (u32), and bucket_count buckets (u16).  Times are in microseconds, and
+  /// everything is big endian.  With the probes compiled out, there is a single reply that stops after abandoned.
+  void handle_latency_report(const SC::Message* message);
 };
 
 }
@@ -0,0 +1,143 @@
+#include "task_scheduler.h"
+
+#include <avr/sleep.h>
+
+using namespace estop;
+
+// CONSTRUCTORS
+task_scheduler::task_scheduler()
+{
+  task_scheduler::m_task_count = 0;
+  task_scheduler::m_idle_time = 0;
+  task_scheduler::m_sleep_enabled = true;
+}
+
+// METHODS
+uint8_t task_scheduler::add(task_function function, void* context, uint16_t period, uint8_t priority)
+{
+  if(task_scheduler::m_task_count >= task_scheduler::max_tasks)
+  {
+    return task_scheduler::invalid_task;
+  }
+
+  task& added = task_scheduler::m_tasks[task_scheduler::m_task_count];
+  added.function = function;
+  added.context = context;
+  added.period = static_cast<uint32_t>(period) * 1000;
+  added.release = micros();
+  added.priority = priority;
+  memset(&added.stats, 0, sizeof(added.stats));
+
+  return task_scheduler::m_task_count++;
+}
+void task_scheduler::spin_once()
+{
+  // Pick the highest priority task that is due, breaking ties on the earliest deadline.
+  uint32_t now = micros();
+  task* next = NULL;
+  for(uint8_t i = 0; i < task_scheduler::m_task_count; i++)
+  {
+    task& candidate = task_scheduler::m_tasks[i];
+    if(static_cast<int32_t>(now - candidate.release) < 0)
+    {
+      continue;
+    }
+    if(!next || candidate.priority < next->priority ||
+       (candidate.priority == next->priority && static_cast<int32_t>(candidate.release - next->release) < 0))
+    {
+      next = &candidate;
+    }
+  }
+  if(!next)
+  {
+    task_scheduler::idle();
+    return;
+  }
+
+  // Skip releases that have been missed entirely.
+  uint32_t deadline = next->release + next->period;
+  bool overrun = false;
+  while(static_cast<int32_t>(now - deadline) >= 0)
+  {
+    next->release = deadline;
+    deadline += next->period;
+    overrun = true;
+  }
+
+  // Run the task, and time it.
+  next->function(next->context);
+  uint32_t finish = micros();
+  uint32_t elapsed = finish - now;
+  if(static_cast<int32_t>(finish - deadline) > 0)
+  {
+    overrun = true;
+  }
+
+  // Update the task's statistics.
+  task_stats& stats = next->stats;
+  stats.runs++;
+  stats.last_time = (elapsed > 0xFFFF) ? 0xFFFF : static_cast<uint16_t>(elapsed);
+  if(stats.last_time > stats.max_time)
+  {
+    stats.max_time = stats.last_time;
+  }
+  stats.total_time += elapsed;
+  if(overrun && stats.overruns < 0xFFFF)
+  {
+    stats.overruns++;
+  }
+
+  // Release the task again next period.
+  next->release = deadline;
+}
+void task_scheduler::reset_stats()
+{
+  for(uint8_t i = 0; i < task_scheduler::m_task_count; i++)
+  {
+    memset(&task_scheduler::m_tasks[i].stats, 0, sizeof(task_stats));
+  }
+  task_scheduler::m_idle_time = 0;
+}
+
+// PROPERTIES
+uint8_t task_scheduler::task_count() const
+{
+  return task_scheduler::m_task_count;
+}
+const task_scheduler::task_stats& task_scheduler::stats(uint8_t index) const
+{
+  return task_scheduler::m_tasks[index].stats;
+}
+uint32_t task_scheduler::idle_time() const
+{
+  return task_scheduler::m_idle_time;
+}
+bool task_scheduler::sleep_enabled() const
+{
+  return task_scheduler::m_sleep_enabled;
+}
+void task_scheduler::sleep_enabled(bool enabled)
+{
+  task_scheduler::m_sleep_enabled = enabled;
+}
+
+// PRIVATE METHODS
+void task_scheduler::idle()
+{
+  uint32_t start = micros();
+
+  // Give anything hooked into yield() a turn first.
+  yield();
+
+  // Sleep until the next interrupt.  Idle mode keeps the timers, USB, UART, and I2C running, and the millisecond timer
+  // interrupt wakes the CPU at least every 1 ms, so no release is missed by more than that.
+  if(task_scheduler::m_sleep_enabled)
+  {
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    sleep_enable();
+    sleep_cpu();
+    sleep_disable();
+  }
+
+  task_scheduler::m_idle_time += micros() - start;
+}
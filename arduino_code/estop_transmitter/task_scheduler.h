@@ -0,0 +1,113 @@
+/// \file task_scheduler.h
+/// \brief Defines the task_scheduler class.
+#ifndef task_scheduler_h
+#define task_scheduler_h
+
+#include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
+
+namespace estop {
+
+/// \brief task_scheduler A small cooperative scheduler for periodic tasks.
+/// \details Each task is released once per period, and must finish by its next release (its deadline).  Each spin runs
+/// the highest priority task that is due, earliest deadline first among equals, then returns, so a higher priority task
+/// never waits behind more than one lower priority one.  Tasks run to completion, so long tasks delay everything else.
+/// A task that starts or finishes after its deadline counts as an overrun; releases missed entirely are skipped, and
+/// also count as overruns, rather than being run back to back to catch up.  When nothing is due, the scheduler calls
+/// yield() and then sleeps until the next interrupt.  Timing is taken from micros().
+class task_scheduler
+{
+public:
+  // TYPES
+  /// \brief task_function A task.
+  /// \param context The context given when the task was added.
+  typedef void (*task_function)(void* context);
+
+  // STRUCTURES
+  /// \brief task_stats The execution statistics of a task.
+  struct task_stats
+  {
+    /// \brief runs The number of times the task has run.
+    uint32_t runs;
+    /// \brief overruns The number of releases that started late, finished late, or were skipped.
+    uint16_t overruns;
+    /// \brief last_time The execution time, in microseconds, of the last run.
+    uint16_t last_time;
+    /// \brief max_time The longest execution time, in microseconds.
+    uint16_t max_time;
+    /// \brief total_time The total execution time, in microseconds.  Wraps after about 71 minutes.
+    uint32_t total_time;
+  };
+
+  // CONSTANTS
+  /// \brief max_tasks The number of tasks the scheduler can hold.
+  static const uint8_t max_tasks = 6;
+  /// \brief invalid_task The index returned when a task can't be added.
+  static const uint8_t invalid_task = 0xFF;
+
+  // CONSTRUCTORS
+  /// \brief task_scheduler Creates a new scheduler with no tasks.
+  task_scheduler();
+
+  // METHODS
+  /// \brief add Adds a periodic task.  The first release is immediate.
+  /// \param function The task.
+  /// \param context Passed to the task on each run.
+  /// \param period The period, in milliseconds.
+  /// \param priority The priority.  0 is the highest.
+  /// \returns The index of the task, or invalid_task if the scheduler is full.
+  uint8_t add(task_function function, void* context, uint16_t period, uint8_t priority);
+  /// \brief spin_once Runs the highest priority task that is due, or idles if none is.
+  void spin_once();
+  /// \brief reset_stats Clears the execution statistics of every task and the idle time.
+  void reset_stats();
+
+  // PROPERTIES
+  /// \brief task_count Gets the number of tasks.
+  uint8_t task_count() const;
+  /// \brief stats Gets the execution statistics of a task.
+  /// \param index The index of the task, as returned by add().
+  const task_stats& stats(uint8_t index) const;
+  /// \brief idle_time Gets the total time, in microseconds, spent idle since the statistics were last reset.
+  uint32_t idle_time() const;
+  /// \brief sleep_enabled Gets if the scheduler sleeps when idle.
+  bool sleep_enabled() const;
+  /// \brief sleep_enabled Sets if the scheduler sleeps when idle.
+  void sleep_enabled(bool enabled);
+
+private:
+  // STRUCTURES
+  /// \brief task A scheduled task.
+  struct task
+  {
+    /// \brief function The task.
+    task_function function;
+    /// \brief context Passed to the task on each run.
+    void* context;
+    /// \brief period The period, in microseconds.
+    uint32_t period;
+    /// \brief release The time, from micros(), of the task's current release.
+    uint32_t release;
+    /// \brief priority The priority.  0 is the highest.
+    uint8_t priority;
+    /// \brief stats The execution statistics.
+    task_stats stats;
+  };
+
+  // VARIABLES
+  /// \brief m_tasks The tasks.
+  task m_tasks[max_tasks];
+  /// \brief m_task_count The number of tasks.
+  uint8_t m_task_count;
+  /// \brief m_idle_time The total time, in microseconds, spent idle.
+  uint32_t m_idle_time;
+  /// \brief m_sleep_enabled Flag indicating that the scheduler sleeps when idle.
+  bool m_sleep_enabled;
+
+  // METHODS
+  /// \brief idle Passes the time until the next interrupt.
+  void idle();
+};
+
+}
+
+#endif
@@ -1,216 +1,646 @@
 #include "xbee.h"
 
+#include "latency_probe.h"
+
 using namespace estop;
 
-// PUBLIC METHODS
-bool xbee::set_node_identifier(const char* identifier, uint16_t length)
+// PRIVATE TEMPLATES
+template <class frame>
+void xbee::send_fixed()
 {
-  // Create a data packet to set NI.
-  uint16_t data_length = 4 + length;
-  uint8_t* data = new uint8_t[data_length];
+  static_assert(frame::length <= xbee::max_data_length + 4, "Fixed frame is too long.");
 
-  // Write fields.
-  data[0] = 0x08;               // Frame Type: 0x08 AT Command
-  data[1] = 0x01;               // Frame ID: 1
-  data[2] = 0x4E;               // AT Command: NI = 0x4E49
-  data[3] = 0x49;               // AT Command: NI = 0x4E49
-  // Write identifier string.
-  for(uint16_t i = 0; i < length; i++)
+  // Copy the frame out of flash and write it in one go.  Fixed frames never need escaping.
+  uint8_t buffer[frame::length];
+  memcpy_P(buffer, frame::bytes, frame::length);
+  xbee::m_serial->write(buffer, frame::length);
+
+  // Log the frame if capturing.
+  if(xbee::m_capture)
+  {
+    xbee::m_capture->Record(SC::Capture::Channel::XBeeTX, buffer, frame::length);
+  }
+}
+template <class frame>
+uint8_t xbee::track_fixed(uint16_t timeout, response_handler handler, void* context)
+{
+  // Responses have the request's frame type with the top bit set (0x08 -> 0x88, 0x17 -> 0x97).
+  // The AT command follows the frame ID for local commands, and the addresses and options for remote ones.
+  const bool remote = (frame::frame_type == 0x17);
+  const uint8_t command = remote ? 16 : 5;
+  pending_request* request = xbee::open_request(frame::frame_id, frame::frame_type | 0x80, pgm_read_byte(&frame::bytes[command]), pgm_read_byte(&frame::bytes[command + 1]), timeout, handler, context);
+  if(!request)
   {
-    data[4+i] = identifier[i];
+    return 0;
   }
+  request->broadcast = remote;
+  return request->frame_id;
+}
 
-  // Send the packet.
-  xbee::send_message(data, data_length);
-  
-  // Get ACK from XBee.
-  return xbee::at_ack('N', 'I');
+// CONSTRUCTORS
+xbee::xbee(Stream& serial, xbee_parser::api_mode mode)
+  : m_parser(mode)
+{
+  xbee::m_serial = &serial;
+
+  // Start with an empty pending-request table.
+  for(uint8_t i = 0; i < xbee::max_pending_requests; i++)
+  {
+    xbee::m_requests[i].frame_id = 0;
+  }
+  xbee::m_next_frame_id = 1;
+
+  // Drop unsolicited frames by default.
+  xbee::m_unsolicited = NULL;
+  xbee::m_unsolicited_context = NULL;
+
+  // Not capturing by default.
+  xbee::m_capture = NULL;
+
+  // Nothing is known about the configuration until it is loaded.
+  xbee::invalidate_configuration();
+
+  // No batch yet.
+  xbee::m_batch_active = false;
+  xbee::m_batch_open = false;
+  xbee::m_batch_failed = false;
+  xbee::m_batch_outstanding = 0;
+  xbee::m_staged_ni = false;
+  xbee::m_staged_ky = false;
+
+  xbee::m_episode_timestamp = 0;
+  xbee::m_answer_timestamp = 0;
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
+  {
+    xbee::m_retry_ids[i] = 0;
+    xbee::m_retry_counts[i] = 0;
+  }
+
+  // The baud rate is whatever the application opened the port at until it is negotiated.
+  xbee::m_baud = 0;
 }
 
-bool xbee::get_node_identifier(char*& identifier, uint16_t& length)
+// PUBLIC METHODS - ASYNCHRONOUS
+void xbee::spin_once()
 {
-  // Create data packet to query NI.
-  uint16_t data_length = 4;
-  uint8_t* data = new uint8_t[data_length];
+  // Parse only what has already arrived, and only up to a limit, so that a busy link can't hold up the loop.
+  for(uint8_t i = 0; i < xbee::max_bytes_per_spin && xbee::m_serial->available() > 0; i++)
+  {
+    int read_byte = xbee::m_serial->read();
+    if(read_byte < 0)
+    {
+      break;
+    }
+
+    xbee_parser::result result = xbee::m_parser.parse(static_cast<uint8_t>(read_byte));
+    if(result != xbee_parser::result::incomplete)
+    {
+      // Log the frame if capturing, before it is validated.
+      if(xbee::m_capture)
+      {
+        xbee::m_capture->Record(SC::Capture::Channel::XBeeRX, xbee::m_parser.frame(), xbee::m_parser.length());
+      }
+
+      if(result == xbee_parser::result::frame)
+      {
+        xbee::dispatch(xbee::m_parser.frame(), xbee::m_parser.length());
+      }
+    }
+  }
+
+  // Expire any requests that have run past their deadlines.
+  unsigned long now = millis();
+  for(uint8_t i = 0; i < xbee::max_pending_requests; i++)
+  {
+    pending_request* request = &(xbee::m_requests[i]);
+    if(request->frame_id != 0 && request->state == xbee::request_state::pending && static_cast<long>(now - request->deadline) >= 0)
+    {
+      // Broadcasts collect responses until the deadline, and succeed if anyone answered.
+      if(request->broadcast && request->responses > 0)
+      {
+        xbee::finish(request, xbee::request_state::complete, NULL);
+      }
+      else
+      {
+        xbee::finish(request, xbee::request_state::timed_out, NULL);
+      }
+    }
+  }
+}
+
+uint8_t xbee::at_command(char at1, char at2, const uint8_t* parameter, uint8_t length, uint16_t timeout, response_handler handler, void* context)
+{
+  // 0x08 AT Command: set or query, applying any queued changes.
+  return xbee::local_at_command(0x08, at1, at2, parameter, length, timeout, handler, context);
+}
+uint8_t xbee::remote_at_command(const uint8_t* address, uint8_t options, char at1, char at2, const uint8_t* parameter, uint8_t length, uint16_t timeout, response_handler handler, void* context)
+{
+  pending_request* request = xbee::open_request(0, 0x97, at1, at2, timeout, handler, context);
+  if(!request)
+  {
+    return 0;
+  }
+  request->broadcast = (address == NULL);
+
+  // Create a data packet.
+  uint8_t data[xbee::max_data_length];
+  if(length > xbee::max_data_length - 15)
+  {
+    length = xbee::max_data_length - 15;
+  }
 
   // Write fields.
-  data[0] = 0x08;               // Frame Type: 0x08 AT Command
-  data[1] = 0x01;               // Frame ID: 1
-  data[2] = 0x4E;               // AT Command: NI = 0x4E49
-  data[3] = 0x49;               // AT Command: NI = 0x4E49
-
-  // Send the query packet.
-  xbee::send_message(data, data_length);
-
-  // Get response from XBee.
-  uint8_t* response = NULL;
-  uint16_t response_length;
-  if(xbee::read_response(0x88, response, response_length))
-  {
-    // Calculate string length.
-    length = response_length - 9;
-    // Copy the name bytes into the output buffer.
-    identifier = new char[length];
-    for(uint16_t i = 0; i < length; i++)
+  data[0] = 0x17;               // Frame Type: 0x17 Remote AT Command
+  data[1] = request->frame_id;  // Frame ID
+  if(address)
+  {
+    // 64b Address
+    for(uint8_t i = 0; i < 8; i++)
     {
-      identifier[i] = response[8+i];
+      data[2+i] = address[i];
     }
+  }
+  else
+  {
+    // 64b Address = 0x00 00 00 00 00 00 FF FF (Broadcast)
+    for(uint8_t i = 0; i < 6; i++)
+    {
+      data[2+i] = 0x00;
+    }
+    data[8] = 0xFF;
+    data[9] = 0xFF;
+  }
+  data[10] = 0xFF;              // 16b Address = 0xFF FE (Reserved)
+  data[11] = 0xFE;              // 16b Address = 0xFF FE (Reserved)
+  data[12] = options;           // Remote CMD Options
+  data[13] = at1;               // AT Command
+  data[14] = at2;               // AT Command
+  // Write parameter.
+  for(uint8_t i = 0; i < length; i++)
+  {
+    data[15+i] = parameter[i];
+  }
 
-    // Clean up response.
-    delete [] response;
-    
-    return true;
+  // Send the packet.
+  xbee::send_message(data, 15 + length);
+
+  return request->frame_id;
+}
+xbee::request_state xbee::poll(uint8_t frame_id)
+{
+  pending_request* request = xbee::find_request(frame_id);
+  return request ? request->state : xbee::request_state::none;
+}
+uint8_t xbee::response_count(uint8_t frame_id)
+{
+  pending_request* request = xbee::find_request(frame_id);
+  return request ? request->responses : 0;
+}
+const uint8_t* xbee::response_value(uint8_t frame_id, uint8_t& length)
+{
+  pending_request* request = xbee::find_request(frame_id);
+  if(!request || request->responses == 0)
+  {
+    length = 0;
+    return NULL;
+  }
+  length = request->value_length;
+  return request->value;
+}
+void xbee::release(uint8_t frame_id)
+{
+  pending_request* request = xbee::find_request(frame_id);
+  if(!request)
+  {
+    return;
+  }
+
+  if(request->state == xbee::request_state::pending)
+  {
+    // Let the request run to completion so its responses are absorbed, then free itself.
+    request->detached = true;
   }
   else
   {
-    // Did not get a response from the XBee.
+    request->frame_id = 0;
+  }
+}
+xbee::request_state xbee::wait(uint8_t frame_id)
+{
+  while(xbee::poll(frame_id) == xbee::request_state::pending)
+  {
+    xbee::spin_once();
+    yield();
+  }
+  return xbee::poll(frame_id);
+}
+void xbee::unsolicited(frame_handler handler, void* context)
+{
+  xbee::m_unsolicited = handler;
+  xbee::m_unsolicited_context = context;
+}
+
+// PUBLIC METHODS - CONFIGURATION
+bool xbee::load_configuration()
+{
+  // Query NI.
+  uint8_t frame_id = xbee::track_fixed<xbee_frames::node_identifier_query>(xbee::at_timeout);
+  if(frame_id == 0)
+  {
     return false;
   }
+  xbee::send_fixed<xbee_frames::node_identifier_query>();
+
+  // Fill the cache from the response.
+  if(xbee::wait(frame_id) == xbee::request_state::complete)
+  {
+    uint8_t value_length = 0;
+    const uint8_t* value = xbee::response_value(frame_id, value_length);
+    xbee::m_ni_length = (value_length < xbee::max_node_identifier_length) ? value_length : static_cast<uint8_t>(xbee::max_node_identifier_length);
+    memcpy(xbee::m_node_identifier, value, xbee::m_ni_length);
+    xbee::m_ni_cached = true;
+  }
+
+  xbee::release(frame_id);
+  return xbee::m_ni_cached;
 }
+void xbee::invalidate_configuration()
+{
+  xbee::m_ni_length = 0;
+  xbee::m_ni_cached = false;
+  xbee::m_ky_hash = 0;
+  xbee::m_ky_cached = false;
+  xbee::m_configuration_dirty = false;
+}
+bool xbee::node_identifier(const char*& identifier, uint8_t& length) const
+{
+  if(!xbee::m_ni_cached)
+  {
+    return false;
+  }
+  identifier = xbee::m_node_identifier;
+  length = xbee::m_ni_length;
+  return true;
+}
+
+// PUBLIC METHODS - BATCHES
+bool xbee::begin_batch()
+{
+  if(xbee::batch_state() == xbee::request_state::pending)
+  {
+    return false;
+  }
 
-bool xbee::set_team_name(const char* team_name, uint16_t length)
+  xbee::m_batch_active = true;
+  xbee::m_batch_open = true;
+  xbee::m_batch_failed = false;
+  xbee::m_batch_outstanding = 0;
+  xbee::m_staged_ni = false;
+  xbee::m_staged_ky = false;
+  return true;
+}
+bool xbee::queue_command(char at1, char at2, const uint8_t* parameter, uint8_t length)
 {
-  // XBee node identifier will always be in the following format: device_name-team_name.
-  // First, get the current node identifier to extract the device name.
-  char* current_node_identifier = NULL;
-  uint16_t current_node_identifier_length = 0;
-  if(!xbee::get_node_identifier(current_node_identifier, current_node_identifier_length))
+  // Once anything has failed to stage, stage nothing more.
+  if(!xbee::m_batch_open || xbee::m_batch_failed)
+  {
+    return false;
+  }
+
+  // 0x09 AT Command - Queue Parameter Value: the XBee holds the change until AC (or any 0x08 command).
+  if(xbee::local_at_command(0x09, at1, at2, parameter, length, xbee::at_timeout, &xbee::batch_response, this) == 0)
   {
-    delete [] current_node_identifier;
+    xbee::m_batch_failed = true;
     return false;
   }
+  xbee::m_batch_outstanding++;
+  return true;
+}
+void xbee::commit_batch(bool save)
+{
+  if(!xbee::m_batch_open)
+  {
+    return;
+  }
 
-  // Extract the device name.
-  char* device_name = NULL;
-  uint16_t device_name_length = 0;
-  xbee::extract_device_name(current_node_identifier, current_node_identifier_length, device_name, device_name_length);
+  // Don't apply a batch that failed to stage.
+  if(xbee::m_batch_outstanding > 0 && !xbee::m_batch_failed)
+  {
+    // Apply everything queued at once, and save it if asked.  The XBee handles frames in order, so these follow the queued commands.
+    if(xbee::local_at_command(0x08, 'A', 'C', NULL, 0, xbee::at_timeout, &xbee::batch_response, this) != 0)
+    {
+      xbee::m_batch_outstanding++;
+    }
+    else
+    {
+      xbee::m_batch_failed = true;
+    }
+    // Never save a batch that wasn't applied.
+    if(save && !xbee::m_batch_failed)
+    {
+      if(xbee::track_fixed<xbee_frames::write_configuration>(xbee::write_timeout, &xbee::batch_response, this) != 0)
+      {
+        xbee::send_fixed<xbee_frames::write_configuration>();
+        xbee::m_batch_outstanding++;
+      }
+      else
+      {
+        xbee::m_batch_failed = true;
+      }
+    }
+  }
 
-  // Create a new string for the new node identifier.
-  // Calculate length of new node identifier
-  uint16_t new_node_identifier_length = device_name_length + 1 + length;
-  char* new_node_identifier = new char[new_node_identifier_length];
-  
-  // Populate the string.
-  uint16_t i = 0;
-  for(uint16_t j = 0; j < device_name_length; j++)
+  xbee::m_batch_open = false;
+  if(xbee::m_batch_outstanding == 0)
+  {
+    // Nothing left to wait for.
+    xbee::finish_batch(this);
+  }
+}
+xbee::request_state xbee::batch_state() const
+{
+  if(!xbee::m_batch_active)
   {
-    new_node_identifier[i++] = device_name[j];
+    return xbee::request_state::none;
   }
-  new_node_identifier[i++] = '-';
-  for(uint16_t j = 0; j < length; j++)
+  if(xbee::m_batch_open || xbee::m_batch_outstanding > 0)
   {
-    new_node_identifier[i++] = team_name[j];
+    return xbee::request_state::pending;
+  }
+  return xbee::m_batch_failed ? xbee::request_state::failed : xbee::request_state::complete;
+}
+bool xbee::set_team(const char* team_name, uint16_t tn_length, const char* encryption_key, uint16_t ek_length)
+{
+  // The new node identifier keeps the device name, so the current one must be known.
+  if(!xbee::m_ni_cached || xbee::batch_state() == xbee::request_state::pending)
+  {
+    return false;
   }
 
-  // Set the new node identifier.
-  bool success = xbee::set_node_identifier(new_node_identifier, new_node_identifier_length);
+  // Work out everything to stage before staging any of it.  Once a 0x09 command is out, the XBee applies it with the
+  // next 0x08 command, whether or not the rest of the batch made it.
+  uint16_t dn_length = 0;
+  while(dn_length < xbee::m_ni_length && xbee::m_node_identifier[dn_length] != '-')
+  {
+    dn_length++;
+  }
+  uint16_t ni_length = dn_length + 1 + tn_length;
+  if(dn_length == 0 || dn_length == xbee::m_ni_length || ni_length > xbee::max_node_identifier_length)
+  {
+    // No device name to keep, or the result won't fit.  Fail the batch without staging anything.
+    xbee::begin_batch();
+    xbee::m_batch_failed = true;
+    xbee::commit_batch(true);
+    return true;
+  }
+  memcpy(xbee::m_staged_ni_value, xbee::m_node_identifier, dn_length);
+  xbee::m_staged_ni_value[dn_length] = '-';
+  memcpy(&(xbee::m_staged_ni_value[dn_length + 1]), team_name, tn_length);
+  bool stage_ni = ni_length != xbee::m_ni_length || memcmp(xbee::m_staged_ni_value, xbee::m_node_identifier, ni_length) != 0;
 
-  // Delete strings.
-  delete [] new_node_identifier;
-  delete [] device_name;
-  delete [] current_node_identifier;
+  // Skip the key if it is already set.
+  uint32_t key_hash = xbee::hash(encryption_key, ek_length);
+  bool stage_ky = !xbee::m_ky_cached || key_hash != xbee::m_ky_hash;
 
-  return success;
+  // Make sure every request of the batch can be opened, so it can't fail halfway through staging: one per command,
+  // then AC, then WR, whose fixed frame ID must be free too.
+  if(stage_ni || stage_ky)
+  {
+    uint8_t needed = (stage_ni ? 1 : 0) + (stage_ky ? 1 : 0) + 2;
+    if(xbee::free_requests() < needed || xbee::find_request(xbee_frames::write_configuration::frame_id))
+    {
+      return false;
+    }
+  }
+
+  xbee::begin_batch();
+  if(stage_ky)
+  {
+    xbee::m_staged_ky = true;
+    xbee::m_staged_ky_hash = key_hash;
+    xbee::queue_command('K', 'Y', reinterpret_cast<const uint8_t*>(encryption_key), ek_length);
+  }
+  if(stage_ni)
+  {
+    xbee::m_staged_ni = true;
+    xbee::m_staged_ni_length = ni_length;
+    xbee::queue_command('N', 'I', reinterpret_cast<const uint8_t*>(xbee::m_staged_ni_value), ni_length);
+  }
+
+  // Apply and save everything in one go.
+  xbee::commit_batch(true);
+  return true;
 }
 
+// PUBLIC METHODS - BLOCKING
 bool xbee::set_encryption_key(const char* encryption_key, uint16_t length)
 {
-  // Create a data packet to set NI.
-  uint16_t data_length = 4 + length;
-  uint8_t* data = new uint8_t[data_length];
+  // Skip the round trip if the key is already set.
+  uint32_t key_hash = xbee::hash(encryption_key, length);
+  if(xbee::m_ky_cached && key_hash == xbee::m_ky_hash)
+  {
+    return true;
+  }
 
-  // Write fields.
-  data[0] = 0x08;               // Frame Type: 0x08 AT Command
-  data[1] = 0x01;               // Frame ID: 1
-  data[2] = 0x4B;               // AT Command: KY = 0x4B59
-  data[3] = 0x59;               // AT Command: KY = 0x4B59
-  // Write identifier string.
-  for(uint16_t i = 0; i < length; i++)
+  // Set KY, and wait for the ACK from the XBee.
+  uint8_t frame_id = xbee::at_command('K', 'Y', reinterpret_cast<const uint8_t*>(encryption_key), length);
+  if(!xbee::wait_and_release(frame_id))
   {
-    data[4+i] = encryption_key[i];
+    xbee::m_ky_cached = false;
+    return false;
   }
 
-  // Send the packet.
-  xbee::send_message(data, data_length);
-  
-  // Get command ACK from XBee.
-  return xbee::at_ack('K', 'Y');
+  xbee::m_ky_hash = key_hash;
+  xbee::m_ky_cached = true;
+  xbee::m_configuration_dirty = true;
+  return true;
 }
 
-bool xbee::save_configuration()
+uint32_t xbee::negotiate_baud(baud_setter set_baud, void* context, uint32_t max_baud, bool save)
 {
-  // Create a data packet to send WR command.
-  uint16_t data_length = 4;
-  uint8_t* data = new uint8_t[data_length];
+  // Work out the fastest rate both ends can manage.
+  uint8_t fastest = xbee::max_baud_index;
+  while(fastest > 0 && (xbee::baud_rate(fastest) > max_baud || !xbee::uart_supports(xbee::baud_rate(fastest))))
+  {
+    fastest--;
+  }
 
-  // Write fields.
-  data[0] = 0x08;               // Frame Type: 0x08 AT Command
-  data[1] = 0x01;               // Frame ID: 1
-  data[2] = 0x57;               // AT Command: WR = 0x5752
-  data[3] = 0x52;               // AT Command: WR = 0x5752
+  // Find the XBee.
+  uint8_t current = xbee::find_baud(set_baud, context, fastest);
+  if(current == 0xFF)
+  {
+    return 0;
+  }
 
-  // Temporarily increase the XBee serial timeout, since writes can take time.
-  uint32_t original_timeout = Serial1.getTimeout();
-  Serial1.setTimeout(2000);
+  // Step up to the fastest rate that passes its link check, falling back a rate at a time.
+  bool changed = false;
+  for(uint8_t index = fastest; index > current; index--)
+  {
+    if(!xbee::uart_supports(xbee::baud_rate(index)))
+    {
+      continue;
+    }
+    if(xbee::change_baud(set_baud, context, current, index))
+    {
+      current = index;
+      changed = true;
+      break;
+    }
+    // The XBee should be back at the old rate.  If it isn't, look for it again.
+    if(!xbee::check_baud(current, 1, xbee::at_timeout))
+    {
+      current = xbee::find_baud(set_baud, context, fastest);
+      if(current == 0xFF)
+      {
+        return 0;
+      }
+      changed = true;
+    }
+  }
 
-  // Send the packet.
-  xbee::send_message(data, data_length);
-  
-  // Get ACK from XBee.
-  bool ack = xbee::at_ack('W', 'R');
+  // Save the new rate if asked to, so the XBee is found at it on the first try next boot.
+  if(save && changed)
+  {
+    xbee::m_configuration_dirty = true;
+    xbee::save_configuration();
+  }
 
-  // Restore original timeout.
-  Serial1.setTimeout(original_timeout);
+  xbee::m_baud = xbee::baud_rate(current);
+  return xbee::m_baud;
+}
+bool xbee::save_configuration()
+{
+  // Nothing to save if nothing changed.
+  if(!xbee::m_configuration_dirty)
+  {
+    return true;
+  }
+
+  // Send WR with a longer timeout, since writes can take time.
+  uint8_t frame_id = xbee::track_fixed<xbee_frames::write_configuration>(xbee::write_timeout);
+  if(frame_id == 0)
+  {
+    return false;
+  }
+  xbee::send_fixed<xbee_frames::write_configuration>();
+  if(!xbee::wait_and_release(frame_id))
+  {
+    return false;
+  }
 
-  // Return ack.
-  return ack;
+  xbee::m_configuration_dirty = false;
+  return true;
 }
 
+// PUBLIC METHODS - BROADCASTS
 void xbee::broadcast_estop()
 {
-  // Create a data packet.
-  uint8_t* data = new uint8_t[16];
+  // Set D1 to Digital Output (High) = 0x05 on all robots.  Send first, since nothing else is on the critical path.
+  ESTOP_PROBE(send_start);
+  xbee::send_fixed<xbee_frames::estop_broadcast>();
 
-  // Write fields.
-  data[0] = 0x17;               // Frame Type: 0x17 Remote AT Command
-  data[1] = 0x01;               // Frame ID: 1
-  data[2] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF (Broadcast)
-  data[3] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[4] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[5] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[6] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[7] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[8] = 0xFF;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[9] = 0xFF;               // 64b Address = 0x00 00 00 00 00 00 FF FF
-  data[10] = 0xFF;              // 16b Address = 0xFF FE (Reserved)
-  data[11] = 0xFE;              // 16b Address = 0xFF FE (Reserved)
-  data[12] = 0x03;              // Remote CMD Options = 0b11 (Disable ACK, Apply Changes)
-  data[13] = 0x44;              // AT Command: D1 = 0x4431
-  data[14] = 0x31;              // AT Command: D1 = 0x4431
-  data[15] = 0x05;              // Param Value: Digital Output (High) = 0x05
+  // Nobody polls the request; it feeds the robots' responses to the census in the background as they arrive.
+  // If the last broadcast is still collecting, it takes these responses too, so keep it open for them.
+  pending_request* tracker = xbee::find_request(xbee_frames::estop_broadcast::frame_id);
+  if(tracker && tracker->state == xbee::request_state::pending)
+  {
+    tracker->deadline = millis() + xbee::broadcast_timeout;
+    return;
+  }
+  xbee::release(xbee::track_fixed<xbee_frames::estop_broadcast>(xbee::broadcast_timeout, &xbee::record_responder, this));
+}
 
-  // Send the data packet.
-  xbee::send_message(data, 16);
+void xbee::begin_estop()
+{
+  xbee::m_episode_timestamp = millis();
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
+  {
+    xbee::m_retry_counts[i] = 0;
+  }
+}
+
+void xbee::retry_estop()
+{
+  // Only send a retry if it leaves room for the next broadcast, which is written without checking.  In escaped mode,
+  // every byte of the retry after the delimiter might need escaping.
+  const uint8_t frame_length = (xbee::m_parser.mode() == xbee_parser::api_mode::escaped) ? 2 * xbee::estop_retry_length - 1 : xbee::estop_retry_length;
+  const int room = frame_length + xbee_frames::estop_broadcast::length;
+  unsigned long now = millis();
+  unsigned long elapsed = now - xbee::m_episode_timestamp;
 
-  // Read out respnses just to keep RX buffer clear.
-  // TODO: These responses can be used to figure out how many robots are responding.
-  uint8_t* response = NULL;
-  uint16_t response_length;
-  // Read until timeout.
-  while(xbee::read_response(0x97, response, response_length))
+  // While answers are still streaming in, a robot's confirmation may be queued behind the others, so wait for a gap.
+  unsigned long gap = xbee::answer_time() + xbee::estop_confirm_margin;
+  if(static_cast<long>(xbee::m_answer_timestamp - xbee::m_episode_timestamp) >= 0 && now - xbee::m_answer_timestamp < gap)
   {
-    // Clean up any read response.
-    delete [] response;
+    return;
   }
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
+  {
+    // Skip empty slots, and robots that already have a retry in flight.
+    const responder_census::responder* robot = xbee::m_census.entry(i);
+    if(!robot || xbee::m_retry_ids[i] != 0)
+    {
+      continue;
+    }
+    // Skip robots that have confirmed since the e-stop began.
+    bool answered = static_cast<long>(robot->last_ack - xbee::m_episode_timestamp) >= 0;
+    if(answered && robot->status == 0x00)
+    {
+      continue;
+    }
+    // Skip robots that have had all their retries, and robots that went quiet long before the e-stop, which have
+    // probably left the field.
+    if(xbee::m_retry_counts[i] >= xbee::estop_max_retries || (!answered && xbee::m_episode_timestamp - robot->last_ack > xbee::estop_stale_timeout))
+    {
+      continue;
+    }
+    // Give the robot a chance to answer the broadcast first.
+    if(elapsed < xbee::confirm_delay(robot))
+    {
+      continue;
+    }
+    if(xbee::free_requests() <= xbee::estop_reserved_requests)
+    {
+      // Leave entries for the broadcast's responses and for configuration requests.  Carry on next spin.
+      break;
+    }
+    if(xbee::m_serial->availableForWrite() < room)
+    {
+      // The serial buffer is full.  Carry on next spin rather than blocking.
+      break;
+    }
+
+    // Set D1 to Digital Output (High) = 0x05 on just this robot.
+    // Remote CMD Options = 0b10 (Apply Changes), with ACK enabled so the radio retries at the MAC layer.
+    const uint8_t parameter = 0x05;
+    uint8_t frame_id = xbee::remote_at_command(robot->address, 0x02, 'D', '1', &parameter, 1, xbee::estop_retry_timeout, &xbee::record_retry, this);
+    if(frame_id == 0)
+    {
+      // The pending-request table is full.  Carry on next spin.
+      break;
+    }
+    xbee::m_retry_ids[i] = frame_id;
+    xbee::m_retry_counts[i]++;
+  }
+}
+
+bool xbee::broadcast_heartbeat()
+{
+  if(xbee::m_serial->availableForWrite() < xbee_frames::heartbeat_broadcast::length)
+  {
+    return false;
+  }
+  xbee::send_fixed<xbee_frames::heartbeat_broadcast>();
+  return true;
 }
 
 void xbee::broadcast_test_packet()
 {
   // Create a data packet.
-  uint8_t* data = new uint8_t[20];
+  uint8_t data[20];
 
   data[0] = 0x00;               // Frame Type: 0x00 TX Request
-  data[1] = 0x01;               // Frame ID: 1
+  data[1] = 0x00;               // Frame ID: 0 (No TX Status)
   data[2] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF (Broadcast)
   data[3] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
   data[4] = 0x00;               // 64b Address = 0x00 00 00 00 00 00 FF FF
@@ -232,17 +662,6 @@ void xbee::broadcast_test_packet()
 
   // Send the data packet.
   xbee::send_message(data, 20);
-
-  // Read out respnses just to keep RX buffer clear.
-  // TODO: These responses can be used to figure out how many robots are responding.
-  uint8_t* response = NULL;
-  uint16_t response_length;
-  // Read until timeout.
-  while(xbee::read_response(0x97, response, response_length))
-  {
-    // Clean up any read response.
-    delete [] response;
-  }
 }
 
 void xbee::extract_device_name(const char* node_identifier, uint16_t ni_length, char*& device_name, uint16_t& dn_length)
@@ -299,125 +718,554 @@ void xbee::extract_team_name(const char* node_identifier, uint16_t ni_length, ch
 }
 
 
+// PROPERTIES
+const responder_census& xbee::census() const
+{
+  return xbee::m_census;
+}
+uint32_t xbee::baud() const
+{
+  return xbee::m_baud;
+}
+xbee_parser::api_mode xbee::api_mode() const
+{
+  return xbee::m_parser.mode();
+}
+void xbee::api_mode(xbee_parser::api_mode mode)
+{
+  xbee::m_parser.mode(mode);
+}
+
+// CAPTURE
+void xbee::capture(SC::Capture* tap)
+{
+  xbee::m_capture = tap;
+}
+
+
 // PRIVATE METHODS
-void xbee::send_message(uint8_t* data, uint16_t length)
-{
-  // Calculate full frame length, which is data + 4 control bytes.
-  uint32_t frame_length = length + 4;
-  
-  // Create a new buffer to store the full frame packet.
-  uint8_t* frame = new uint8_t[frame_length];
-  
-  // Set frame header.
-  frame[0] = 0x7E;
-  // Set length bits.
-  frame[1] = (length >> 8) & 0xFF;
-  frame[2] = length & 0xFF;
-
-  // Copy the data into the frame.
+void xbee::send_message(const uint8_t* data, uint16_t length)
+{
+  // Set frame header and length bits.  The delimiter is the only byte that is never escaped.
+  uint8_t header[3];
+  header[0] = xbee_parser::start_delimiter;
+  header[1] = (length >> 8) & 0xFF;
+  header[2] = length & 0xFF;
+  uint8_t frame_checksum = xbee::checksum(data, length);
+
+  // Write the frame to the XBee via serial, piece by piece, without assembling it first.
+  xbee::m_serial->write(header[0]);
+  xbee::write_escaped(&header[1], 2);
+  xbee::write_escaped(data, length);
+  xbee::write_escaped(&frame_checksum, 1);
+
+  // Log the frame if capturing.  The capture needs a contiguous frame, so only build one here.
+  if(xbee::m_capture)
+  {
+    uint8_t frame[xbee::max_data_length + 4];
+    for(uint8_t i = 0; i < 3; i++)
+    {
+      frame[i] = header[i];
+    }
+    for(uint16_t i = 0; i < length; i++)
+    {
+      frame[3+i] = data[i];
+    }
+    frame[3+length] = frame_checksum;
+    xbee::m_capture->Record(SC::Capture::Channel::XBeeTX, frame, length + 4);
+  }
+}
+void xbee::write_escaped(const uint8_t* data, uint16_t length)
+{
+  if(xbee::m_parser.mode() == xbee_parser::api_mode::unescaped)
+  {
+    xbee::m_serial->write(data, length);
+    return;
+  }
+
+  // Write runs of bytes that don't need escaping in bulk, and escape the rest one by one.
+  uint16_t run_start = 0;
   for(uint16_t i = 0; i < length; i++)
   {
-    frame[3+i] = data[i];
+    if(xbee_parser::needs_escape(data[i]))
+    {
+      if(i > run_start)
+      {
+        xbee::m_serial->write(&data[run_start], i - run_start);
+      }
+      xbee::m_serial->write(static_cast<uint8_t>(xbee_parser::escape));
+      xbee::m_serial->write(static_cast<uint8_t>(data[i] ^ xbee_parser::escape_mask));
+      run_start = i + 1;
+    }
+  }
+  if(length > run_start)
+  {
+    xbee::m_serial->write(&data[run_start], length - run_start);
   }
+}
 
-  // Write the checksum.
-  frame[frame_length-1] = xbee::checksum(frame, frame_length);
+uint8_t xbee::checksum(const uint8_t* data, uint16_t length)
+{
+  // Formula: Add all bytes (except for start delimiter and length), keep only the lowest 8 bits, and subtract of 0xFF.
+  uint8_t sum = 0;
+  for(uint16_t i = 0; i < length; i++)
+  {
+    sum += data[i];
+  }
+  return 0xFF - sum;
+}
 
-  // Write the frame to the XBee via serial.
-  Serial1.write(frame, frame_length);
+xbee::pending_request* xbee::open_request(uint8_t frame_id, uint8_t response_type, char at1, char at2, uint16_t timeout, response_handler handler, void* context)
+{
+  // A fixed frame ID can only have one request pending at a time.
+  if(frame_id != 0 && xbee::find_request(frame_id))
+  {
+    return NULL;
+  }
 
-  // Clean up frame and data arrays.
-  delete [] data;
-  delete [] frame;
-}
+  // Find a free entry.
+  pending_request* request = NULL;
+  for(uint8_t i = 0; i < xbee::max_pending_requests; i++)
+  {
+    if(xbee::m_requests[i].frame_id == 0)
+    {
+      request = &(xbee::m_requests[i]);
+      break;
+    }
+  }
+  if(!request)
+  {
+    return NULL;
+  }
 
-bool xbee::read_response(uint8_t frame_type, uint8_t*& frame, uint16_t &frame_length)
+  // Hand out the next frame ID not in use, wrapping before the reserved fixed IDs and skipping 0 (no response).
+  // The table is smaller than the ID range, so a free ID is always found.
+  while(frame_id == 0)
+  {
+    frame_id = xbee::m_next_frame_id;
+    xbee::m_next_frame_id = (frame_id + 1 < xbee::first_fixed_frame_id) ? frame_id + 1 : 1;
+    if(xbee::find_request(frame_id))
+    {
+      frame_id = 0;
+    }
+  }
+
+  request->frame_id = frame_id;
+  request->response_type = response_type;
+  request->command[0] = at1;
+  request->command[1] = at2;
+  request->state = xbee::request_state::pending;
+  request->broadcast = false;
+  request->detached = false;
+  request->responses = 0;
+  request->deadline = millis() + timeout;
+  request->handler = handler;
+  request->context = context;
+  request->value_length = 0;
+
+  return request;
+}
+xbee::pending_request* xbee::find_request(uint8_t frame_id)
 {
-  // Continue searching until frame_type is found or timeout occurs.
-  while(true)
+  if(frame_id == 0)
   {
-    // Read bytes until header is found or timeout.
-    uint8_t read_byte = 0;
-    while(read_byte != 0x7E)
+    return NULL;
+  }
+  for(uint8_t i = 0; i < xbee::max_pending_requests; i++)
+  {
+    if(xbee::m_requests[i].frame_id == frame_id)
     {
-      if(Serial1.readBytes(&read_byte, 1) == 0)
-      {
-        return false;
-      }
+      return &(xbee::m_requests[i]);
     }
-  
-    // If this point is reached, header has been found.
-    // Read next two bytes to determine length.
-    uint8_t length_bytes[2];
-    if(Serial1.readBytes(length_bytes, 2) < 2)
+  }
+  return NULL;
+}
+uint8_t xbee::free_requests() const
+{
+  uint8_t count = 0;
+  for(uint8_t i = 0; i < xbee::max_pending_requests; i++)
+  {
+    if(xbee::m_requests[i].frame_id == 0)
     {
-      return false;
+      count++;
+    }
+  }
+  return count;
+}
+
+void xbee::dispatch(const uint8_t* frame, uint16_t length)
+{
+  // Decode AT command responses.  Offsets are from the start delimiter, and the checksum is the last byte.
+  response parsed;
+  const uint8_t* command = NULL;
+  uint8_t frame_type = frame[3];
+  if(frame_type == 0x88 && length >= 9)
+  {
+    // Local AT Command Response: Type, ID, Command (2), Status, Data...
+    parsed.frame_id = frame[4];
+    command = &frame[5];
+    parsed.status = frame[7];
+    parsed.source = NULL;
+    parsed.value = &frame[8];
+    parsed.value_length = length - 9;
+  }
+  else if(frame_type == 0x97 && length >= 19)
+  {
+    // Remote AT Command Response: Type, ID, 64b Address (8), 16b Address (2), Command (2), Status, Data...
+    parsed.frame_id = frame[4];
+    parsed.source = &frame[5];
+    command = &frame[15];
+    parsed.status = frame[17];
+    parsed.value = &frame[18];
+    parsed.value_length = length - 19;
+  }
+
+  // Match the response to its request.
+  pending_request* request = command ? xbee::find_request(parsed.frame_id) : NULL;
+  if(!request || request->state != xbee::request_state::pending || request->response_type != frame_type || request->command[0] != command[0] || request->command[1] != command[1])
+  {
+    // Not a response anyone is waiting on.
+    if(xbee::m_unsolicited)
+    {
+      xbee::m_unsolicited(frame, length, xbee::m_unsolicited_context);
     }
-    frame_length = (static_cast<uint16_t>(length_bytes[0]) << 8) | static_cast<uint16_t>(length_bytes[1]);
-    // Add 4 to total frame length to account for header, length, and checksum bytes.
-    frame_length += 4;
-
-    // Create a new frame array to receive the response.
-    frame = new uint8_t[frame_length];
-  
-    // Read out the rest of the packet into an array.
-    // Fill in header and length bytes.
-    frame[0] = 0x7E;
-    frame[1] = length_bytes[0];
-    frame[2] = length_bytes[1];
-    // Read rest from the serial port.
-    Serial1.readBytes(&frame[3], frame_length - 3);
-  
-    // Validate the checksum and check if frame type matches.
-    if(xbee::checksum(frame, frame_length) == frame[frame_length-1] && frame[3] == frame_type)
-    {
-      // Good checksum and frame type.
-      return true;
+    return;
+  }
+
+  // Keep the first response's value for polling.
+  if(request->responses == 0)
+  {
+    request->value_length = (parsed.value_length < xbee::max_value_length) ? parsed.value_length : static_cast<uint8_t>(xbee::max_value_length);
+    for(uint8_t i = 0; i < request->value_length; i++)
+    {
+      request->value[i] = parsed.value[i];
     }
-    else
+  }
+  if(request->responses < 0xFF)
+  {
+    request->responses++;
+  }
+
+  if(request->broadcast)
+  {
+    // Keep collecting until the deadline.
+    if(request->handler)
     {
-      // Clean up outputs and repeat iteration to continue search.
-      delete [] frame;
-      frame_length = 0;
+      request->handler(request->frame_id, xbee::request_state::pending, &parsed, request->context);
     }
   }
+  else
+  {
+    xbee::finish(request, (parsed.status == 0x00) ? xbee::request_state::complete : xbee::request_state::failed, &parsed);
+  }
 }
+void xbee::finish(pending_request* request, xbee::request_state state, const xbee::response* response)
+{
+  request->state = state;
 
-uint8_t xbee::checksum(const uint8_t* message, uint32_t length)
+  if(request->handler)
+  {
+    // The handler is the only consumer, so free the entry first, letting the handler issue a new request.
+    uint8_t frame_id = request->frame_id;
+    response_handler handler = request->handler;
+    void* context = request->context;
+    request->frame_id = 0;
+    handler(frame_id, state, response, context);
+  }
+  else if(request->detached)
+  {
+    request->frame_id = 0;
+  }
+}
+uint32_t xbee::hash(const char* data, uint16_t length)
 {
-  // Formula: Add all bytes (except for start delimiter and length), keep only the lowest 8 bits, and subtract of 0xFF.
-  uint32_t sum = 0;
-  for(uint32_t i = 3; i < length - 1; i++)
+  uint32_t value = 2166136261UL;
+  for(uint16_t i = 0; i < length; i++)
   {
-    sum += message[i];
+    value ^= static_cast<uint8_t>(data[i]);
+    value *= 16777619UL;
   }
-  return (uint8_t)(255-(sum % 256));
+  return value;
 }
+void xbee::record_responder(uint8_t, xbee::request_state state, const xbee::response* response, void* context)
+{
+  // Only individual responses carry a robot.  The final call just marks the end of the collection window.
+  if(state != xbee::request_state::pending || !response || !response->source)
+  {
+    return;
+  }
 
-bool xbee::at_ack(uint8_t at1, uint8_t at2)
+  xbee* instance = static_cast<xbee*>(context);
+  unsigned long now = millis();
+  unsigned long latency = now - instance->m_episode_timestamp;
+  instance->m_census.record(response->source, now, (latency < 0xFFFF) ? latency : 0xFFFF, response->status);
+  instance->m_answer_timestamp = now;
+}
+void xbee::record_retry(uint8_t frame_id, xbee::request_state state, const xbee::response* response, void* context)
 {
-  // Read response packet.
-  uint8_t* response = NULL;
-  uint16_t response_length;
-  bool ack = false;
-  // Read responses until correct AT command found or times out.
-  while(xbee::read_response(0x88, response, response_length))
+  xbee* instance = static_cast<xbee*>(context);
+
+  // The retry is over, one way or another.  If it failed, the next retry_estop() sends another.
+  for(uint8_t i = 0; i < responder_census::capacity; i++)
   {
-    // Check if response packet AT matches desired AT.
-    if(response[5] == at1 && response[6] == at2)
+    if(instance->m_retry_ids[i] == frame_id)
     {
-      // Check that the response packet indicates an ack.
-      ack = response[7] == 0x00;
-      // Clean up final response.
-      delete [] response;
+      instance->m_retry_ids[i] = 0;
       break;
     }
-    else
+  }
+
+  // Record the confirmation, which stops further retries for the rest of the episode.
+  if(state == xbee::request_state::complete && response && response->source)
+  {
+    unsigned long now = millis();
+    unsigned long latency = now - instance->m_episode_timestamp;
+    instance->m_census.record(response->source, now, (latency < 0xFFFF) ? latency : 0xFFFF, response->status);
+  }
+}
+uint8_t xbee::local_at_command(uint8_t frame_type, char at1, char at2, const uint8_t* parameter, uint8_t length, uint16_t timeout, response_handler handler, void* context)
+{
+  // Both local frame types are answered with 0x88.
+  pending_request* request = xbee::open_request(0, 0x88, at1, at2, timeout, handler, context);
+  if(!request)
+  {
+    return 0;
+  }
+
+  // Create a data packet.
+  uint8_t data[xbee::max_data_length];
+  if(length > xbee::max_data_length - 4)
+  {
+    length = xbee::max_data_length - 4;
+  }
+
+  // Write fields.
+  data[0] = frame_type;         // Frame Type: 0x08 AT Command, or 0x09 AT Command - Queue Parameter Value
+  data[1] = request->frame_id;  // Frame ID
+  data[2] = at1;                // AT Command
+  data[3] = at2;                // AT Command
+  // Write parameter.
+  for(uint8_t i = 0; i < length; i++)
+  {
+    data[4+i] = parameter[i];
+  }
+
+  // Send the packet.
+  xbee::send_message(data, 4 + length);
+
+  return request->frame_id;
+}
+void xbee::batch_response(uint8_t, xbee::request_state state, const xbee::response*, void* context)
+{
+  xbee* instance = static_cast<xbee*>(context);
+
+  if(state != xbee::request_state::complete)
+  {
+    instance->m_batch_failed = true;
+  }
+  instance->m_batch_outstanding--;
+
+  // Once the whole batch is answered, bring the cache in line with the XBee.
+  if(!instance->m_batch_open && instance->m_batch_outstanding == 0)
+  {
+    xbee::finish_batch(instance);
+  }
+}
+void xbee::finish_batch(xbee* instance)
+{
+  if(instance->m_batch_failed)
+  {
+    // Some changes may or may not have been applied, so stop trusting the cache for what was staged.
+    if(instance->m_staged_ni)
+    {
+      instance->m_ni_cached = false;
+    }
+    if(instance->m_staged_ky)
+    {
+      instance->m_ky_cached = false;
+    }
+  }
+  else
+  {
+    if(instance->m_staged_ni)
+    {
+      memcpy(instance->m_node_identifier, instance->m_staged_ni_value, instance->m_staged_ni_length);
+      instance->m_ni_length = instance->m_staged_ni_length;
+      instance->m_ni_cached = true;
+    }
+    if(instance->m_staged_ky)
+    {
+      instance->m_ky_hash = instance->m_staged_ky_hash;
+      instance->m_ky_cached = true;
+    }
+    if(instance->m_staged_ni || instance->m_staged_ky)
+    {
+      // set_team() always saves what it changes.
+      instance->m_configuration_dirty = false;
+    }
+  }
+  instance->m_staged_ni = false;
+  instance->m_staged_ky = false;
+}
+uint16_t xbee::confirm_delay(const responder_census::responder* robot) const
+{
+  // Expect the robot to answer about as quickly as it did last time, within the radio's round trip.  Its answer still
+  // has to cross the serial link.
+  uint16_t expected = (robot->latency < xbee::estop_confirm_window) ? robot->latency : xbee::estop_confirm_window;
+  return expected + xbee::answer_time() + xbee::estop_confirm_margin;
+}
+uint16_t xbee::answer_time() const
+{
+  // 10 bits per byte.  Until the baud rate is negotiated, assume the factory rate, which is the slowest the link runs at.
+  uint32_t baud = (xbee::m_baud != 0) ? xbee::m_baud : xbee::baud_rate(xbee::factory_baud_index);
+  return xbee::estop_answer_length * 10000UL / baud + 1;
+}
+uint8_t xbee::find_baud(baud_setter set_baud, void* context, uint8_t fastest)
+{
+  // The fastest rate first, since a saved negotiation leaves the XBee there.
+  set_baud(xbee::baud_rate(fastest), context);
+  if(xbee::check_baud(fastest, 1, xbee::baud_probe_timeout))
+  {
+    return fastest;
+  }
+  // Then the factory rate.
+  const uint8_t factory = xbee::factory_baud_index;
+  if(factory != fastest)
+  {
+    set_baud(xbee::baud_rate(factory), context);
+    if(xbee::check_baud(factory, 1, xbee::baud_probe_timeout))
+    {
+      return factory;
+    }
+  }
+  // Then the rest, from the top down.
+  for(uint8_t index = xbee::max_baud_index + 1; index-- > 0;)
+  {
+    if(index == fastest || index == factory || !xbee::uart_supports(xbee::baud_rate(index)))
     {
-      // Clean up current response.
-      delete [] response;
+      continue;
     }
+    set_baud(xbee::baud_rate(index), context);
+    if(xbee::check_baud(index, 1, xbee::baud_probe_timeout))
+    {
+      return index;
+    }
+  }
+
+  // Nowhere.  Leave the port at the factory rate.
+  set_baud(xbee::baud_rate(factory), context);
+  return 0xFF;
+}
+bool xbee::change_baud(baud_setter set_baud, void* context, uint8_t from, uint8_t to)
+{
+  // Queue BD and apply it with AC.  Both are answered at the old rate, then the XBee switches.
+  uint8_t index = to;
+  uint8_t queued = xbee::local_at_command(0x09, 'B', 'D', &index, 1, xbee::at_timeout, NULL, NULL);
+  if(!xbee::wait_and_release(queued))
+  {
+    return false;
+  }
+  if(!xbee::wait_and_release(xbee::at_command('A', 'C')))
+  {
+    return false;
+  }
+  set_baud(xbee::baud_rate(to), context);
+  delay(xbee::baud_settle_time);
+
+  if(xbee::check_baud(to, xbee::baud_link_checks, xbee::at_timeout))
+  {
+    return true;
+  }
+
+  // The new rate isn't reliable.  Ask the XBee to go back over it, which may still get through, then return to the old rate.
+  // Once one request does get through, the XBee has gone back and the rest are lost harmlessly.
+  index = from;
+  for(uint8_t i = 0; i < xbee::baud_link_checks; i++)
+  {
+    if(xbee::wait_and_release(xbee::at_command('B', 'D', &index, 1, xbee::baud_probe_timeout)))
+    {
+      break;
+    }
+  }
+  set_baud(xbee::baud_rate(from), context);
+  delay(xbee::baud_settle_time);
+  return false;
+}
+bool xbee::check_baud(uint8_t index, uint8_t checks, uint16_t timeout)
+{
+  // Drop anything received at the old rate, and any partial frame made of it.
+  while(xbee::m_serial->available() > 0)
+  {
+    xbee::m_serial->read();
   }
+  xbee::m_parser.reset();
 
-  return ack;
+  for(uint8_t i = 0; i < checks; i++)
+  {
+    uint8_t frame_id = xbee::at_command('B', 'D', NULL, 0, timeout);
+    if(frame_id == 0)
+    {
+      return false;
+    }
+    if(xbee::wait(frame_id) != xbee::request_state::complete)
+    {
+      xbee::release(frame_id);
+      return false;
+    }
+
+    // BD is answered as a big endian number, which must match the rate it was heard at.
+    uint8_t length = 0;
+    const uint8_t* value = xbee::response_value(frame_id, length);
+    uint32_t answer = 0;
+    for(uint8_t b = 0; b < length; b++)
+    {
+      answer = (answer << 8) | value[b];
+    }
+    xbee::release(frame_id);
+    if(length == 0 || answer != index)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+uint32_t xbee::baud_rate(uint8_t index)
+{
+  switch(index)
+  {
+    case 0: return 1200;
+    case 1: return 2400;
+    case 2: return 4800;
+    case 3: return 9600;
+    case 4: return 19200;
+    case 5: return 38400;
+    case 6: return 57600;
+    case 7: return 115200;
+    default: return 230400;
+  }
+}
+bool xbee::uart_supports(uint32_t baud)
+{
+#if defined(F_CPU)
+  // HardwareSerial::begin() runs the UART at double speed, dividing the clock by 8 * (UBRR + 1).
+  uint32_t ubrr = (F_CPU / 4 / baud - 1) / 2;
+  uint32_t actual = F_CPU / (8 * (ubrr + 1));
+  // What matters is how closely it matches the XBee, whose UART isn't exact either: its 115200 runs at 111111.
+  uint32_t xbee_actual = (baud == 115200) ? 111111 : baud;
+  uint32_t error = (actual > xbee_actual) ? actual - xbee_actual : xbee_actual - actual;
+  return error * 1000 <= xbee_actual * 25;
+#else
+  (void)baud;
+  return true;
+#endif
+}
+bool xbee::wait_and_release(uint8_t frame_id)
+{
+  if(frame_id == 0)
+  {
+    return false;
+  }
+  bool success = xbee::wait(frame_id) == xbee::request_state::complete;
+  xbee::release(frame_id);
+  return success;
 }
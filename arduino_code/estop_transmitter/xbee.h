@@ -3,42 +3,263 @@
 #ifndef xbee_h
 #define xbee_h
 
-#include <Arduino.h>    // Include Arduino.h to enroll class h/cpp file in compilation.
+#include <Arduino.h>              // Include Arduino.h to enroll class h/cpp file in compilation.
+#include <SerialCommunicator.h>   // Adds SC::Capture for logging raw API frames.
+
+#include "xbee_parser.h"
+#include "xbee_frames.h"
+#include "responder_census.h"
 
 namespace estop {
 
 /// \brief xbee A class for interfacing with the E-Stop Transmitter's XBee module.
+/// \details Requests are asynchronous.  Each AT request is given its own frame ID and tracked in a small
+/// pending-request table, so several can be in flight at once.  spin_once() parses whatever the XBee has sent
+/// so far and matches 0x88/0x97 responses to their requests by frame ID, completing them through a handler
+/// callback or for polling.  The older blocking methods (set_encryption_key() and so on) are built on top
+/// of the same requests, and wait for them to complete.
 class xbee
 {
 public:
+  // ENUMS
+  /// \brief request_state Enumerates the states of a request.
+  enum class request_state
+  {
+    none = 0,         ///< No such request (never issued, or already released).
+    pending = 1,      ///< Waiting on responses.
+    complete = 2,     ///< Answered with an OK status.  Broadcasts are complete if anyone answered by the deadline.
+    failed = 3,       ///< Answered with an error status.
+    timed_out = 4     ///< Not answered by the deadline.
+  };
+
+  // STRUCTURES
+  /// \brief response Describes a single AT command response.
+  /// \details All pointers point into the received frame, and are only valid during the handler call.
+  struct response
+  {
+    /// \brief frame_id The frame ID of the request being answered.
+    uint8_t frame_id;
+    /// \brief status The AT command status: 0 = OK, 1 = ERROR, 2 = invalid command, 3 = invalid parameter, 4 = transmission failure.
+    uint8_t status;
+    /// \brief source The 64 bit address of the responding radio for remote AT responses, or NULL for local ones.
+    const uint8_t* source;
+    /// \brief value The command data of the response (e.g. the value of a queried register).
+    const uint8_t* value;
+    /// \brief value_length The length of the command data.
+    uint8_t value_length;
+  };
+
+  // TYPES
+  /// \brief response_handler A callback for the progress of a request.
+  /// \details Called once when a request completes, fails, or times out, with the response if there was one.  Requests
+  /// to the broadcast address also call it with request_state::pending for each response that arrives before the deadline.
+  typedef void (*response_handler)(uint8_t frame_id, xbee::request_state state, const xbee::response* response, void* context);
+  /// \brief frame_handler A callback for received frames that are not responses to a pending request.
+  typedef void (*frame_handler)(const uint8_t* frame, uint16_t length, void* context);
+  /// \brief baud_setter A callback that changes the baud rate of the serial port the XBee is connected to.
+  /// \details Must let anything already written go out at the old rate first (e.g. Serial1.flush(), then Serial1.begin()).
+  typedef void (*baud_setter)(uint32_t baud, void* context);
+
+  // CONSTANTS
+  /// \brief first_fixed_frame_id The first of the frame IDs (0xF0-0xFF) reserved for fixed, precomputed frames.
+  /// \details The allocator hands out IDs 0x01 to 0xEF in turn, skipping any still in use.
+  static const uint8_t first_fixed_frame_id = 0xF0;
+  /// \brief max_pending_requests The number of requests that can be in flight at once.
+  static const uint8_t max_pending_requests = 6;
+  /// \brief max_value_length The longest response value kept for polling.  Longer values are truncated.
+  static const uint8_t max_value_length = 20;
+  /// \brief at_timeout The default time to wait for an AT response, in milliseconds.
+  static const uint16_t at_timeout = 250;
+  /// \brief broadcast_timeout The time to collect responses to a broadcast remote AT command, in milliseconds.
+  static const uint16_t broadcast_timeout = 500;
+  /// \brief estop_confirm_window The longest a robot is expected to take to answer an e-stop broadcast over the air, in milliseconds.
+  /// \details Caps the answer time remembered from the robot's last e-stop (see confirm_delay()).
+  static const uint16_t estop_confirm_window = 60;
+  /// \brief estop_confirm_margin The slack given to a robot's expected answer time before it is sent a unicast retry, in milliseconds.
+  static const uint16_t estop_confirm_margin = 10;
+  /// \brief estop_max_retries The most unicast retries sent to one robot in one e-stop.
+  static const uint8_t estop_max_retries = 3;
+  /// \brief estop_stale_timeout How long before an e-stop a robot can have last answered and still be retried, in milliseconds.
+  /// \details Robots that have been quiet for longer, about the length of a match, have probably left the field.
+  static const uint32_t estop_stale_timeout = 300000;
+  /// \brief estop_reserved_requests The pending-request entries retries always leave free, for the broadcast's responses and configuration requests.
+  static const uint8_t estop_reserved_requests = 2;
+  /// \brief estop_retry_timeout The time to wait for an answer to a unicast e-stop retry before sending another, in milliseconds.
+  static const uint16_t estop_retry_timeout = 100;
+  /// \brief estop_retry_length The length of a unicast e-stop (remote AT D1) frame, before escaping.
+  static const uint8_t estop_retry_length = 20;
+  /// \brief estop_answer_length The length of a robot's answer to an e-stop (remote AT response, no value), before escaping.
+  static const uint8_t estop_answer_length = 19;
+  /// \brief write_timeout The time to wait for an ATWR response, in milliseconds, since writes take time.
+  static const uint16_t write_timeout = 2000;
+  /// \brief max_data_length The longest frame data (frame type onward) that can be sent.  Longer AT parameters are truncated.
+  static const uint8_t max_data_length = 44;
+  /// \brief max_node_identifier_length The longest Node Identifier name the XBee accepts.
+  static const uint8_t max_node_identifier_length = 20;
+  /// \brief max_bytes_per_spin The most received bytes parsed in a single spin_once().
+  static const uint8_t max_bytes_per_spin = 64;
+  /// \brief max_baud_index The highest BD value the XBee supports (230400 baud).
+  static const uint8_t max_baud_index = 8;
+  /// \brief factory_baud_index The BD value the XBee ships with (9600 baud).
+  static const uint8_t factory_baud_index = 3;
+  /// \brief baud_probe_timeout The time to wait for an answer when looking for the XBee at a baud rate, in milliseconds.
+  static const uint16_t baud_probe_timeout = 50;
+  /// \brief baud_settle_time The time the XBee is given to switch baud rates, in milliseconds.
+  static const uint16_t baud_settle_time = 10;
+  /// \brief baud_link_checks The number of round trips a new baud rate must pass before it is kept.  A marginal rate
+  /// drops only the odd frame, so one check isn't enough to catch it.
+  static const uint8_t baud_link_checks = 8;
+
   // CONSTRUCTORS
+  /// \brief xbee Creates a new xbee instance.
+  /// \param serial The serial port the XBee is connected to.  The application must call begin() on it first.
+  /// \param mode OPTIONAL The API mode the XBee is configured for (its AP register).
+  xbee(Stream& serial, xbee_parser::api_mode mode = xbee_parser::api_mode::unescaped);
 
-  // METHODS
-  /// \brief set_node_identifier Sets the Node Identifier name of the XBee.
-  /// \param identifier The new Node Identifier name to set.
-  /// \param length The length of the new Node Identifier name to set.
-  /// \returns TRUE if the command succeeded, otherwise FALSE.
-  bool set_node_identifier(const char* identifier, uint16_t length);
-  /// \brief get_node_identifier Gets the Node Identifier name of the XBee.
-  /// \param identifier An empty character array to store the received Node Identifier name in.
-  /// \param length An empty variable to store the recieved Node Identifier name length in.
-  /// \returns TRUE if the command succeeded, otherwise FALSE.
-  bool get_node_identifier(char*& identifier, uint16_t& length);
-  /// \brief set_team_name Sets the team name assigned to the XBee.
-  /// \param team_name The new team_name to set.
-  /// \param length The length of the new team name to set.
-  /// \returns TRUE if the command succeeded, otherwise FALSE.
-  bool set_team_name(const char* team_name, uint16_t length);
+  // METHODS - ASYNCHRONOUS
+  /// \brief spin_once Parses any received bytes, dispatches complete frames, and times out late requests.
+  /// \details Never waits on the serial port.  Should be called every loop.
+  void spin_once();
+  /// \brief at_command Sends a local AT command (0x08) without waiting for the response.
+  /// \param at1 The first character of the AT command.
+  /// \param at2 The second character of the AT command.
+  /// \param parameter OPTIONAL The parameter to set, or NULL to query.
+  /// \param length OPTIONAL The length of the parameter.
+  /// \param timeout OPTIONAL How long to wait for the response, in milliseconds.
+  /// \param handler OPTIONAL A callback for the response.  If NULL, the request must be polled and released.
+  /// \param context OPTIONAL A pointer passed through to the handler.
+  /// \returns The frame ID of the request, or 0 if the pending-request table is full and nothing was sent.
+  uint8_t at_command(char at1, char at2, const uint8_t* parameter = NULL, uint8_t length = 0, uint16_t timeout = at_timeout, response_handler handler = NULL, void* context = NULL);
+  /// \brief remote_at_command Sends a remote AT command (0x17) without waiting for the responses.
+  /// \param address The 64 bit address of the remote radio, or NULL to broadcast.
+  /// \param options The remote command options (e.g. 0x02 to apply changes).
+  /// \param at1 The first character of the AT command.
+  /// \param at2 The second character of the AT command.
+  /// \param parameter The parameter to set, or NULL to query.
+  /// \param length The length of the parameter.
+  /// \param timeout How long to wait for the response, or to collect responses to a broadcast, in milliseconds.
+  /// \param handler OPTIONAL A callback for the responses.  If NULL, the request must be polled and released.
+  /// \param context OPTIONAL A pointer passed through to the handler.
+  /// \returns The frame ID of the request, or 0 if the pending-request table is full and nothing was sent.
+  uint8_t remote_at_command(const uint8_t* address, uint8_t options, char at1, char at2, const uint8_t* parameter, uint8_t length, uint16_t timeout, response_handler handler = NULL, void* context = NULL);
+  /// \brief poll Gets the state of a request.
+  /// \param frame_id The frame ID of the request.
+  /// \returns The state of the request.  Requests without a handler keep their final state until released.
+  xbee::request_state poll(uint8_t frame_id);
+  /// \brief response_count Gets the number of responses a request has received.
+  /// \param frame_id The frame ID of the request.
+  uint8_t response_count(uint8_t frame_id);
+  /// \brief response_value Gets the value of a completed request's (first) response.
+  /// \param frame_id The frame ID of the request.
+  /// \param length A variable to store the length of the value in.
+  /// \returns A pointer to the value, valid until the request is released, or NULL if there is no response.
+  const uint8_t* response_value(uint8_t frame_id, uint8_t& length);
+  /// \brief release Gives up interest in a request.
+  /// \param frame_id The frame ID of the request.
+  /// \details A request that is still pending keeps absorbing its responses until it completes or times out, then frees itself.
+  void release(uint8_t frame_id);
+  /// \brief wait Spins until a request is no longer pending.
+  /// \param frame_id The frame ID of the request.
+  /// \returns The final state of the request.  The request is not released.
+  xbee::request_state wait(uint8_t frame_id);
+  /// \brief unsolicited Sets the callback for received frames that do not answer a pending request.
+  /// \param handler The callback, or NULL to drop such frames.
+  /// \param context A pointer passed through to the handler.
+  void unsolicited(frame_handler handler, void* context);
+
+  // METHODS - CONFIGURATION
+  /// \brief load_configuration Reads the XBee's configuration into the cache.
+  /// \details Call once at boot.  After that, the cache is kept up to date by the setters, so reading the configuration
+  /// costs no radio traffic, and setting it to what it already is costs none either.
+  /// \returns TRUE if the configuration was read, otherwise FALSE.
+  bool load_configuration();
+  /// \brief invalidate_configuration Forgets the cached configuration.
+  /// \details Call if the XBee may have been configured behind the xbee's back, such as through serial forwarding.
+  void invalidate_configuration();
+  /// \brief node_identifier Gets the cached Node Identifier name of the XBee, without any radio traffic.
+  /// \param identifier A variable to store a pointer to the cached name in.  The name is not null terminated.
+  /// \param length A variable to store the length of the cached name in.
+  /// \returns TRUE if the name is cached, otherwise FALSE.
+  bool node_identifier(const char*& identifier, uint8_t& length) const;
+
+  // METHODS - BATCHES
+  /// \brief begin_batch Starts a batch of queued AT commands, which are applied together.
+  /// \returns TRUE if the batch was started, or FALSE if the last batch is still pending.
+  bool begin_batch();
+  /// \brief queue_command Sends a parameter change (0x09) as part of the current batch, without applying it.
+  /// \param at1 The first character of the AT command.
+  /// \param at2 The second character of the AT command.
+  /// \param parameter The parameter to set.
+  /// \param length The length of the parameter.
+  /// \returns TRUE if the command was sent, otherwise FALSE, which also fails the batch.  Nothing more is sent once the
+  /// batch has failed.
+  /// \details Commands go out immediately, each with its own frame ID, and are answered in the background.
+  bool queue_command(char at1, char at2, const uint8_t* parameter, uint8_t length);
+  /// \brief commit_batch Applies the current batch with a single AC, and optionally saves it with a single WR.
+  /// \param save TRUE to also send WR.
+  /// \details Does not wait.  Poll batch_state() for the outcome.  A batch that failed to stage is neither applied nor
+  /// saved, though the XBee still holds whatever was queued until the next 0x08 command.  Nor is one whose AC couldn't
+  /// be sent saved.
+  void commit_batch(bool save);
+  /// \brief batch_state Gets the state of the last batch.
+  /// \returns pending until every command in the batch is answered, then complete if all succeeded, otherwise failed.
+  xbee::request_state batch_state() const;
+  /// \brief set_team Sets the team name and encryption key, and saves them, as a single batch.
+  /// \param team_name The new team name.
+  /// \param tn_length The length of the new team name.
+  /// \param encryption_key The new encryption key.
+  /// \param ek_length The length of the new encryption key.
+  /// \returns TRUE if the batch was started, otherwise FALSE.  Poll batch_state() for the outcome.
+  /// \details Does not wait.  Settings that are already set are skipped, and the cache is updated once the batch succeeds.
+  /// The node identifier must already be cached, since the device name is kept.  Nothing is staged unless the whole
+  /// batch can be: a team name that won't fit fails the batch, and a full request table returns FALSE.
+  bool set_team(const char* team_name, uint16_t tn_length, const char* encryption_key, uint16_t ek_length);
+
+  // METHODS - BLOCKING
   /// \brief set_encryption_key Sets the encryption key of the XBee.
   /// \param identifier The new encryption key to set.
   /// \param length The length of the new encryption key to set.
   /// \returns TRUE if the command succeeded, otherwise FALSE.
+  /// \details KY can't be read back, so only a hash of the last key set is cached.  Does nothing if the key matches it.
   bool set_encryption_key(const char* encryption_key, uint16_t length);
+  /// \brief negotiate_baud Finds the XBee's baud rate, then moves the link to the fastest rate that passes a link check.
+  /// \param set_baud Changes the baud rate of the XBee's serial port.
+  /// \param context A pointer passed through to set_baud.
+  /// \param max_baud The fastest rate to try.
+  /// \param save TRUE to save a new rate with WR, so the XBee boots at it.
+  /// \returns The rate the link was left at, or 0 if the XBee didn't answer at any rate, in which case the port is left at 9600.
+  /// \details Blocks, so call from setup().  The XBee is looked for at the fastest candidate rate first (where an earlier
+  /// save leaves it), then at 9600, then at the rest.  Rates this board's UART can't match to within 2.5% are skipped.
+  /// Each faster rate is set with BD and AC, then must answer baud_link_checks queries in a row; if it doesn't, the XBee
+  /// is told to go back over the new link, and the next rate down is tried.  If the XBee is lost altogether, it is looked
+  /// for again.
+  uint32_t negotiate_baud(baud_setter set_baud, void* context, uint32_t max_baud, bool save);
   /// \brief save_configuration Issues an ATWR command to save the current XBee configuration to it's non-volatile memory.
   /// \returns TRUE if the command succeeded, otherwise FALSE.
+  /// \details Does nothing if nothing has been set since the last save, so several changes share a single write.
   bool save_configuration();
+
+  // METHODS - BROADCASTS
   /// \brief broadcast_estop Sends a single broadcast e-stop command directly to the XBee.
+  /// \details Does not wait.  Responses from the robots are collected into the census in the background by spin_once(),
+  /// until broadcast_timeout after the latest broadcast.
   void broadcast_estop();
+  /// \brief begin_estop Marks the start of an e-stop episode, for retry_estop() and the census latencies.
+  /// \details Should be called on entering the e-stop state, before the first broadcast.
+  void begin_estop();
+  /// \brief retry_estop Sends acknowledged unicast e-stop commands to robots in the census that haven't confirmed the e-stop.
+  /// \details Should be called every loop while in the e-stop state.  Once a robot has had time to answer the first
+  /// broadcast of the episode (see confirm_delay()), and answers to the broadcast have stopped arriving, if it hasn't
+  /// confirmed since begin_estop() it is sent its own D1 command, pipelined with a distinct frame ID, and sent again if
+  /// that fails or times out, up to estop_max_retries times.  D1 stays set, so a robot that has confirmed once is left alone for the rest of the episode.  Robots that
+  /// last answered more than estop_stale_timeout before the e-stop are skipped.  Retries go out as the serial port has
+  /// room for them, so the loop never blocks on a full buffer, and always leave estop_reserved_requests entries free.
+  void retry_estop();
+  /// \brief broadcast_heartbeat Sends a single "run permitted" heartbeat broadcast directly to the XBee.
+  /// \details Nothing answers a heartbeat.  The heartbeat is skipped if the serial port can't take the whole frame without
+  /// blocking, so a backed-up link delays the next heartbeat instead of stalling the loop.
+  /// \returns TRUE if the heartbeat was sent, otherwise FALSE.
+  bool broadcast_heartbeat();
   /// \brief broadcast_test_packet Sends a single broadcast test packet directly to the XBee.
   void broadcast_test_packet();
 
@@ -55,28 +276,195 @@ public:
   /// \param tn_length An empty variable to store the extracted team name length in.
   void extract_team_name(const char* node_identifier, uint16_t ni_length, char*& team_name, uint16_t& tn_length);
 
+  // PROPERTIES
+  /// \brief census Gets the census of robots that have answered e-stop broadcasts.
+  const responder_census& census() const;
+  /// \brief api_mode Gets the API mode used to talk to the XBee.
+  xbee_parser::api_mode api_mode() const;
+  /// \brief baud Gets the baud rate the last negotiate_baud() left the link at, or 0 if it hasn't run.
+  uint32_t baud() const;
+  /// \brief api_mode Sets the API mode used to talk to the XBee.
+  /// \param mode The API mode.  This must match the XBee's AP register, so should be changed right after setting AP.
+  void api_mode(xbee_parser::api_mode mode);
+
+  // CAPTURE
+  /// \brief capture Sets the capture that raw API frames are logged to.
+  /// \param tap A pointer to the capture to log to.  Set to NULL to stop capturing.
+  /// \details Every frame written to and read from the XBee is logged, unescaped.  The xbee does not take ownership of the capture.
+  void capture(SC::Capture* tap);
+
 private:
+  // STRUCTURES
+  /// \brief pending_request An entry in the pending-request table.
+  struct pending_request
+  {
+    /// \brief frame_id The frame ID of the request.  0 marks a free entry.
+    uint8_t frame_id;
+    /// \brief response_type The frame type of the expected responses (0x88 or 0x97).
+    uint8_t response_type;
+    /// \brief command The AT command of the request.
+    uint8_t command[2];
+    /// \brief state The state of the request.
+    xbee::request_state state;
+    /// \brief broadcast Flag indicating that responses are collected until the deadline.
+    bool broadcast;
+    /// \brief detached Flag indicating that nobody will poll the request, so it frees itself once done.
+    bool detached;
+    /// \brief responses The number of responses received.
+    uint8_t responses;
+    /// \brief deadline The time at which the request times out, or a broadcast stops collecting responses.
+    unsigned long deadline;
+    /// \brief handler The callback for the request, or NULL if polled.
+    xbee::response_handler handler;
+    /// \brief context The pointer passed through to the handler.
+    void* context;
+    /// \brief value The value of the first response.
+    uint8_t value[max_value_length];
+    /// \brief value_length The length of the value of the first response.
+    uint8_t value_length;
+  };
+
+  // VARIABLES
+  /// \brief m_serial The serial port the XBee is connected to.
+  Stream* m_serial;
+  /// \brief m_parser Assembles received API frames.
+  estop::xbee_parser m_parser;
+  /// \brief m_requests The pending-request table.
+  pending_request m_requests[max_pending_requests];
+  /// \brief m_next_frame_id The next frame ID to try handing out.
+  uint8_t m_next_frame_id;
+  /// \brief m_unsolicited The callback for frames that do not answer a pending request.
+  frame_handler m_unsolicited;
+  /// \brief m_unsolicited_context The pointer passed through to m_unsolicited.
+  void* m_unsolicited_context;
+  /// \brief m_capture A pointer to the capture that raw API frames are logged to.  NULL if not capturing.
+  SC::Capture* m_capture;
+  /// \brief m_node_identifier The cached Node Identifier name.
+  char m_node_identifier[max_node_identifier_length];
+  /// \brief m_ni_length The length of the cached Node Identifier name.
+  uint8_t m_ni_length;
+  /// \brief m_ni_cached Flag indicating that m_node_identifier matches the XBee.
+  bool m_ni_cached;
+  /// \brief m_ky_hash The hash of the last encryption key set.
+  uint32_t m_ky_hash;
+  /// \brief m_ky_cached Flag indicating that m_ky_hash matches the XBee.
+  bool m_ky_cached;
+  /// \brief m_configuration_dirty Flag indicating that the configuration has changed since it was last saved.
+  bool m_configuration_dirty;
+  /// \brief m_batch_active Flag indicating that a batch has been started.
+  bool m_batch_active;
+  /// \brief m_batch_open Flag indicating that the current batch has not been committed yet.
+  bool m_batch_open;
+  /// \brief m_batch_failed Flag indicating that a command in the current batch failed.
+  bool m_batch_failed;
+  /// \brief m_batch_outstanding The number of commands in the current batch that have not been answered.
+  uint8_t m_batch_outstanding;
+  /// \brief m_staged_ni Flag indicating that the current batch changes the node identifier to m_staged_ni_value.
+  bool m_staged_ni;
+  /// \brief m_staged_ni_value The node identifier being set by the current batch.
+  char m_staged_ni_value[max_node_identifier_length];
+  /// \brief m_staged_ni_length The length of m_staged_ni_value.
+  uint8_t m_staged_ni_length;
+  /// \brief m_staged_ky Flag indicating that the current batch changes the encryption key.
+  bool m_staged_ky;
+  /// \brief m_staged_ky_hash The hash of the encryption key being set by the current batch.
+  uint32_t m_staged_ky_hash;
+  /// \brief m_census The census of robots that have answered e-stop broadcasts.
+  estop::responder_census m_census;
+  /// \brief m_episode_timestamp The time, in milliseconds, the current e-stop episode began.
+  unsigned long m_episode_timestamp;
+  /// \brief m_retry_ids The frame IDs of in-flight unicast e-stop retries, by census slot.  0 if none.
+  uint8_t m_retry_ids[responder_census::capacity];
+  /// \brief m_answer_timestamp The time, in milliseconds, of the last answer to an e-stop broadcast.
+  unsigned long m_answer_timestamp;
+  /// \brief m_retry_counts The number of unicast e-stop retries sent this episode, by census slot.
+  uint8_t m_retry_counts[responder_census::capacity];
+  /// \brief m_baud The baud rate of the link, or 0 if it hasn't been negotiated.
+  uint32_t m_baud;
+
   /// \brief send_message Sends a new message to the XBee via serial.
-  /// \param data The data to be sent. This method takes ownership of the pointer.
-  /// \param length The length of the data in bytes.
-  /// \details This method inserts the appropriate header, length, and checksum bytes.
-  void send_message(uint8_t* data, uint16_t length);
-  /// \brief read_response Reads a response message from the XBee via serial.
-  /// \param frame_type The specific frame message type to receive.
-  /// \param frame An empty byte array to store the received frame within.
-  /// \param frame_length An empty variable to store the recieved frame length within.
-  /// \returns TRUE if a response was received, otherwise FALSE.
-  bool read_response(uint8_t frame_type, uint8_t*& frame, uint16_t &frame_length);
-  /// \brief checksum Calculates the checksum of a message in frame packet form.
-  /// \param message The frame packet to calculate the checksum for.
-  /// \param length The length of the frame packet in bytes.
-  /// \returns The checksum for the frame packet data.
-  uint8_t checksum(const uint8_t* message, uint32_t length);
-  /// \brief at_ack Listens for an ACK response from the XBee for a given AT command.
-  /// \param at1 The first character of the AT Command being acknowledged.
-  /// \param at2 The second character of the AT Command being acknowledged.
-  /// \returns TRUE if the command was acknowledged by the XBee, otherwise FALSE.
-  bool at_ack(uint8_t at1, uint8_t at2);
+  /// \param data The frame data to be sent, starting with the frame type.
+  /// \param length The length of the data in bytes, up to max_data_length.
+  /// \details This method inserts the appropriate header, length, and checksum bytes, and streams the frame straight
+  /// to the serial port, escaping it on the way in escaped mode.
+  void send_message(const uint8_t* data, uint16_t length);
+  /// \brief write_escaped Writes bytes to the XBee, escaping them if in escaped mode.
+  /// \param data The bytes to write.
+  /// \param length The number of bytes to write.
+  void write_escaped(const uint8_t* data, uint16_t length);
+  /// \brief checksum Calculates the checksum of a message's frame data.
+  /// \param data The frame data to calculate the checksum for, starting with the frame type.
+  /// \param length The length of the frame data in bytes.
+  /// \returns The checksum for the frame data.
+  uint8_t checksum(const uint8_t* data, uint16_t length);
+  /// \brief send_fixed Sends a fixed frame straight from flash.
+  /// \tparam frame The xbee_frames::fixed_frame to send.
+  template <class frame>
+  void send_fixed();
+  /// \brief track_fixed Opens a pending-request entry for the responses to a fixed AT frame.
+  /// \tparam frame The xbee_frames::fixed_frame whose responses to track.  Fixed remote AT frames are treated as broadcasts.
+  /// \returns The frame ID of the fixed frame, or 0 if the table is full or the frame ID is already pending.
+  template <class frame>
+  uint8_t track_fixed(uint16_t timeout, response_handler handler = NULL, void* context = NULL);
+  /// \brief open_request Allocates a pending-request entry.
+  /// \param frame_id The fixed frame ID to use, or 0 to allocate the next free one.
+  /// \returns The entry, or NULL if the table is full or a fixed frame ID is already pending.
+  pending_request* open_request(uint8_t frame_id, uint8_t response_type, char at1, char at2, uint16_t timeout, response_handler handler, void* context);
+  /// \brief find_request Finds the pending-request entry for a frame ID.
+  /// \returns The entry, or NULL if there is none.
+  pending_request* find_request(uint8_t frame_id);
+  /// \brief free_requests Counts the pending-request entries not in use.
+  uint8_t free_requests() const;
+  /// \brief dispatch Matches a received frame to its pending request.
+  /// \param frame The received frame.
+  /// \param length The length of the received frame.
+  void dispatch(const uint8_t* frame, uint16_t length);
+  /// \brief finish Moves a request into a final state and notifies its handler.
+  void finish(pending_request* request, xbee::request_state state, const xbee::response* response);
+  /// \brief local_at_command Sends a local AT command frame without waiting for the response.
+  /// \param frame_type 0x08 to apply the command immediately, or 0x09 to queue it until AC.
+  /// \returns The frame ID of the request, or 0 if the pending-request table is full and nothing was sent.
+  uint8_t local_at_command(uint8_t frame_type, char at1, char at2, const uint8_t* parameter, uint8_t length, uint16_t timeout, response_handler handler, void* context);
+  /// \brief batch_response A response_handler that tallies the responses to a batch.
+  /// \param context The xbee instance.
+  static void batch_response(uint8_t frame_id, xbee::request_state state, const xbee::response* response, void* context);
+  /// \brief finish_batch Updates the cache with the outcome of a batch.
+  static void finish_batch(xbee* instance);
+  /// \brief hash Calculates the 32 bit FNV-1a hash of a string.
+  static uint32_t hash(const char* data, uint16_t length);
+  /// \brief record_responder A response_handler that records e-stop broadcast responses in the census.
+  /// \param context The xbee instance.
+  static void record_responder(uint8_t frame_id, xbee::request_state state, const xbee::response* response, void* context);
+  /// \brief record_retry A response_handler that records unicast e-stop retry responses in the census.
+  /// \param context The xbee instance.
+  static void record_retry(uint8_t frame_id, xbee::request_state state, const xbee::response* response, void* context);
+  /// \brief confirm_delay Gets the time a robot is given to answer the first e-stop broadcast of an episode, in milliseconds.
+  /// \details The robot's last answer time, capped at estop_confirm_window, plus the time its answer takes to cross the
+  /// serial link, plus estop_confirm_margin.
+  uint16_t confirm_delay(const responder_census::responder* robot) const;
+  /// \brief answer_time Gets the time a robot's answer to an e-stop takes to cross the serial link, in milliseconds.
+  uint16_t answer_time() const;
+  /// \brief find_baud Looks for the XBee at each baud rate in turn.
+  /// \param fastest The BD value of the fastest rate to look at.
+  /// \returns The BD value the XBee answered at, or 0xFF if it didn't answer at any, with the port left at the factory rate.
+  uint8_t find_baud(baud_setter set_baud, void* context, uint8_t fastest);
+  /// \brief change_baud Moves the XBee and the serial port from one baud rate to another, and checks the new link.
+  /// \returns TRUE if the new rate passed its link check.  Otherwise the XBee has been asked to go back to the old rate,
+  /// and the serial port is back at it.
+  bool change_baud(baud_setter set_baud, void* context, uint8_t from, uint8_t to);
+  /// \brief check_baud Queries BD and checks the answer.
+  /// \param index The BD value the XBee should be at.
+  /// \param checks The number of round trips that must succeed in a row.
+  /// \param timeout The time to wait for each answer, in milliseconds.
+  bool check_baud(uint8_t index, uint8_t checks, uint16_t timeout);
+  /// \brief baud_rate Gets the baud rate of a BD value.
+  static uint32_t baud_rate(uint8_t index);
+  /// \brief uart_supports Checks if this board's UART can generate a baud rate close enough to the XBee's to be reliable.
+  /// \details The XBee's 115200 is really 111111, which an 8 MHz board generates exactly.
+  static bool uart_supports(uint32_t baud);
+  /// \brief wait_and_release Waits for a request to complete and releases it.
+  /// \returns TRUE if the request completed with an OK status, otherwise FALSE.
+  bool wait_and_release(uint8_t frame_id);
 };
 
 }
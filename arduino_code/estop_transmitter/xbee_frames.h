@@ -0,0 +1,95 @@
+/// \file xbee_frames.h
+/// \brief Defines the fixed XBee API frames, built at compile time and stored in flash.
+#ifndef xbee_frames_h
+#define xbee_frames_h
+
+#include <Arduino.h>              // Include Arduino.h to enroll class h/cpp file in compilation.
+
+#include "xbee_parser.h"
+
+namespace estop {
+
+/// \brief xbee_frames Contains complete API frames that never change, so are never built at runtime.
+namespace xbee_frames {
+
+// HELPERS
+/// \brief sum Adds up bytes, keeping only the lowest 8 bits.
+constexpr uint8_t sum()
+{
+  return 0;
+}
+template <typename... T>
+constexpr uint8_t sum(uint8_t first, T... rest)
+{
+  return static_cast<uint8_t>(first + sum(rest...));
+}
+/// \brief any_escaped Checks if any of a set of bytes would need escaping in escaped API mode.
+constexpr bool any_escaped()
+{
+  return false;
+}
+template <typename... T>
+constexpr bool any_escaped(uint8_t first, T... rest)
+{
+  return first == 0x7E || first == 0x7D || first == 0x11 || first == 0x13 || any_escaped(rest...);
+}
+/// \brief nth Gets a byte from a set of bytes by index.
+constexpr uint8_t nth(uint8_t)
+{
+  return 0;
+}
+template <typename... T>
+constexpr uint8_t nth(uint8_t index, uint8_t first, T... rest)
+{
+  return (index == 0) ? first : nth(index - 1, rest...);
+}
+
+/// \brief fixed_frame A complete API frame, with its length and checksum worked out at compile time.
+/// \tparam Data The frame data, starting with the frame type.
+/// \details The frame is stored in flash.  Frames must not contain any bytes that would need escaping, so the same
+/// bytes can be written in either API mode, in one go.  Frame IDs should come from the reserved range 0xF0-0xFF.
+template <uint8_t... Data>
+struct fixed_frame
+{
+  /// \brief length The length of the frame, including delimiter, length, and checksum bytes.
+  static const uint8_t length = sizeof...(Data) + 4;
+  /// \brief frame_type The API frame type.
+  static const uint8_t frame_type = nth(0, Data...);
+  /// \brief frame_id The frame ID.
+  static const uint8_t frame_id = nth(1, Data...);
+  /// \brief checksum The frame checksum.
+  static const uint8_t checksum = 0xFF - sum(Data...);
+  /// \brief bytes The complete frame, in flash.
+  static const uint8_t bytes[length];
+
+  static_assert(sizeof...(Data) < 0x100, "Fixed frames must be shorter than 256 bytes.");
+  static_assert(!any_escaped(static_cast<uint8_t>(sizeof...(Data)), Data..., checksum), "Fixed frames must not need escaping.");
+};
+template <uint8_t... Data>
+const uint8_t fixed_frame<Data...>::bytes[fixed_frame<Data...>::length] PROGMEM =
+{
+  xbee_parser::start_delimiter,
+  0x00,
+  static_cast<uint8_t>(sizeof...(Data)),
+  Data...,
+  fixed_frame<Data...>::checksum
+};
+
+// FRAMES
+/// \brief estop_broadcast Sets D1 to Digital Output (High) = 0x05 on every radio.
+/// \details Remote AT Command (0x17) to 64b Address = 0x00 00 00 00 00 00 FF FF (Broadcast), 16b Address = 0xFF FE (Reserved),
+/// Remote CMD Options = 0b11 (Disable ACK, Apply Changes).
+typedef fixed_frame<0x17, 0xF0, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFE, 0x03, 'D', '1', 0x05> estop_broadcast;
+/// \brief node_identifier_query Queries the local NI (AT Command 0x08).
+typedef fixed_frame<0x08, 0xF1, 'N', 'I'> node_identifier_query;
+/// \brief write_configuration Saves the local configuration to non-volatile memory (AT Command 0x08 WR).
+typedef fixed_frame<0x08, 0xF2, 'W', 'R'> write_configuration;
+/// \brief heartbeat_broadcast Tells every robot that it may keep running.
+/// \details TX Request (0x00) with Frame ID = 0 (No TX Status) to 64b Address = 0x00 00 00 00 00 00 FF FF (Broadcast),
+/// Options = 0x01 (Disable ACK), Payload = "RUN".
+typedef fixed_frame<0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0x01, 'R', 'U', 'N'> heartbeat_broadcast;
+
+}
+}
+
+#endif
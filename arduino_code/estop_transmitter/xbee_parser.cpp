@@ -0,0 +1,139 @@
+#include "xbee_parser.h"
+
+using namespace estop;
+
+// CONSTRUCTORS
+xbee_parser::xbee_parser(api_mode mode)
+{
+  xbee_parser::m_mode = mode;
+  xbee_parser::m_skipped = 0;
+  xbee_parser::reset();
+}
+
+// PUBLIC METHODS
+xbee_parser::result xbee_parser::parse(uint8_t value)
+{
+  if(xbee_parser::m_mode == xbee_parser::api_mode::escaped)
+  {
+    if(value == xbee_parser::start_delimiter)
+    {
+      // Delimiters are never part of an escaped frame, so one always starts a new frame, abandoning any partial one.
+      xbee_parser::reset();
+    }
+    else if(value == xbee_parser::escape)
+    {
+      // Restore the next byte.
+      xbee_parser::m_escaped = true;
+      return xbee_parser::result::incomplete;
+    }
+    else if(xbee_parser::m_escaped)
+    {
+      value ^= xbee_parser::escape_mask;
+      xbee_parser::m_escaped = false;
+    }
+  }
+
+  switch(xbee_parser::m_state)
+  {
+    case xbee_parser::state::delimiter:
+    {
+      // Discard anything between frames.
+      if(value == xbee_parser::start_delimiter)
+      {
+        xbee_parser::m_frame[0] = value;
+        xbee_parser::m_position = 1;
+        xbee_parser::m_state = xbee_parser::state::length_msb;
+      }
+      break;
+    }
+    case xbee_parser::state::length_msb:
+    {
+      xbee_parser::m_frame[xbee_parser::m_position++] = value;
+      xbee_parser::m_state = xbee_parser::state::length_lsb;
+      break;
+    }
+    case xbee_parser::state::length_lsb:
+    {
+      xbee_parser::m_frame[xbee_parser::m_position++] = value;
+      // Add 4 to the frame data length to account for header, length, and checksum bytes.
+      xbee_parser::m_length = ((static_cast<uint16_t>(xbee_parser::m_frame[1]) << 8) | value) + 4;
+      if(xbee_parser::m_length > xbee_parser::max_frame_length)
+      {
+        // Too long to hold.  Skip over the rest of it.
+        xbee_parser::m_skipped++;
+        xbee_parser::m_state = xbee_parser::state::skip;
+      }
+      else
+      {
+        xbee_parser::m_state = xbee_parser::state::body;
+      }
+      break;
+    }
+    case xbee_parser::state::body:
+    {
+      xbee_parser::m_frame[xbee_parser::m_position++] = value;
+      if(xbee_parser::m_position == xbee_parser::m_length)
+      {
+        // Frame is complete.  Wait for the next one, but leave this one readable.
+        xbee_parser::m_state = xbee_parser::state::delimiter;
+
+        // Validate the checksum: all bytes after the length, including the checksum itself, sum to 0xFF.
+        uint8_t sum = 0;
+        for(uint16_t i = 3; i < xbee_parser::m_length; i++)
+        {
+          sum += xbee_parser::m_frame[i];
+        }
+        return (sum == 0xFF) ? xbee_parser::result::frame : xbee_parser::result::bad_checksum;
+      }
+      break;
+    }
+    case xbee_parser::state::skip:
+    {
+      if(++xbee_parser::m_position == xbee_parser::m_length)
+      {
+        xbee_parser::reset();
+      }
+      break;
+    }
+  }
+
+  return xbee_parser::result::incomplete;
+}
+void xbee_parser::reset()
+{
+  xbee_parser::m_escaped = false;
+  xbee_parser::m_state = xbee_parser::state::delimiter;
+  xbee_parser::m_position = 0;
+  xbee_parser::m_length = 0;
+}
+bool xbee_parser::needs_escape(uint8_t value)
+{
+  return value == xbee_parser::start_delimiter || value == xbee_parser::escape || value == 0x11 || value == 0x13;
+}
+
+// PROPERTIES
+xbee_parser::api_mode xbee_parser::mode() const
+{
+  return xbee_parser::m_mode;
+}
+void xbee_parser::mode(api_mode mode)
+{
+  xbee_parser::m_mode = mode;
+  xbee_parser::reset();
+}
+const uint8_t* xbee_parser::frame() const
+{
+  return xbee_parser::m_frame;
+}
+uint16_t xbee_parser::length() const
+{
+  return xbee_parser::m_length;
+}
+uint8_t xbee_parser::frame_type() const
+{
+  return xbee_parser::m_frame[3];
+}
+uint16_t xbee_parser::skipped() const
+{
+  return xbee_parser::m_skipped;
+}
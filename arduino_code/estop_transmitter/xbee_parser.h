@@ -0,0 +1,108 @@
+/// \file xbee_parser.h
+/// \brief Defines the xbee_parser class.
+#ifndef xbee_parser_h
+#define xbee_parser_h
+
+#include <Arduino.h>              // Include Arduino.h to enroll class h/cpp file in compilation.
+
+namespace estop {
+
+/// \brief xbee_parser An incremental parser for XBee API frames.
+/// \details Bytes are fed in one at a time as they arrive, so a frame can be assembled across any number of
+/// loop iterations without ever waiting on the serial port.  The UART's receive ring buffer holds bytes
+/// until they are parsed, and the parser assembles each frame in a fixed buffer, so parsing never allocates.
+///
+/// Both API modes are supported.  In escaped mode (AP=2), escaped bytes are restored as they arrive, and a start
+/// delimiter always begins a new frame, so the parser resynchronizes on the very next frame after any corruption.
+class xbee_parser
+{
+public:
+  // ENUMS
+  /// \brief api_mode Enumerates the XBee API modes.  Values match the XBee's AP register.
+  enum class api_mode
+  {
+    unescaped = 1,        ///< AP=1: frames are sent as-is.
+    escaped = 2           ///< AP=2: 0x7E, 0x7D, 0x11, and 0x13 after the start delimiter are escaped.
+  };
+  /// \brief result Enumerates the outcomes of feeding a byte to the parser.
+  enum class result
+  {
+    incomplete = 0,       ///< The byte was consumed, but no frame is complete yet.
+    frame = 1,            ///< A frame with a valid checksum is complete and can be read with frame().
+    bad_checksum = 2      ///< A frame is complete, but its checksum is wrong.  It can still be read with frame().
+  };
+
+  // CONSTANTS
+  /// \brief start_delimiter The byte that starts every API frame.
+  static const uint8_t start_delimiter = 0x7E;
+  /// \brief escape The byte that precedes an escaped byte in escaped mode.
+  static const uint8_t escape = 0x7D;
+  /// \brief escape_mask The mask an escaped byte is XORed with.
+  static const uint8_t escape_mask = 0x20;
+  /// \brief max_frame_length The longest frame, including delimiter, length, and checksum, that can be parsed.
+  /// \details Fits the longest AT response used (a 20 character NI) and remote AT responses.  Longer frames are skipped.
+  static const uint16_t max_frame_length = 48;
+
+  // CONSTRUCTORS
+  /// \brief xbee_parser Creates a new parser, waiting for a start delimiter.
+  /// \param mode OPTIONAL The API mode of the received bytes.
+  xbee_parser(api_mode mode = api_mode::unescaped);
+
+  // METHODS
+  /// \brief parse Feeds the next received byte to the parser.
+  /// \param value The received byte.
+  /// \returns The outcome of the byte.  When a frame is complete, it stays readable until the next call.
+  result parse(uint8_t value);
+  /// \brief reset Discards any partial frame and waits for the next start delimiter.
+  void reset();
+  /// \brief needs_escape Checks if a byte must be escaped in escaped mode.
+  /// \param value The byte to check.
+  /// \returns TRUE if the byte is 0x7E, 0x7D, 0x11 (XON), or 0x13 (XOFF).
+  static bool needs_escape(uint8_t value);
+
+  // PROPERTIES
+  /// \brief mode Gets the API mode of the received bytes.
+  api_mode mode() const;
+  /// \brief mode Sets the API mode of the received bytes, discarding any partial frame.
+  void mode(api_mode mode);
+  /// \brief frame Gets the last completed frame, including the delimiter, length, and checksum bytes.
+  const uint8_t* frame() const;
+  /// \brief length Gets the length of the last completed frame.
+  uint16_t length() const;
+  /// \brief frame_type Gets the API frame type of the last completed frame.
+  uint8_t frame_type() const;
+  /// \brief skipped Gets the number of frames skipped for being longer than max_frame_length.
+  uint16_t skipped() const;
+
+private:
+  // ENUMS
+  /// \brief state Enumerates the parts of a frame the parser can be waiting for.
+  enum class state
+  {
+    delimiter = 0,
+    length_msb = 1,
+    length_lsb = 2,
+    body = 3,
+    skip = 4
+  };
+
+  // VARIABLES
+  /// \brief m_mode The API mode of the received bytes.
+  api_mode m_mode;
+  /// \brief m_escaped Flag indicating that the last byte was an escape, in escaped mode.
+  bool m_escaped;
+  /// \brief m_state The part of the frame the parser is waiting for.
+  state m_state;
+  /// \brief m_frame The frame being assembled.
+  uint8_t m_frame[max_frame_length];
+  /// \brief m_position The number of bytes of the frame assembled so far.
+  uint16_t m_position;
+  /// \brief m_length The total length of the frame being assembled.
+  uint16_t m_length;
+  /// \brief m_skipped The number of frames skipped for being too long.
+  uint16_t m_skipped;
+};
+
+}
+
+#endif
@@ -0,0 +1,133 @@
+#include "Arduino.h"
+
+#include <time.h>
+
+namespace {
+
+bool g_virtual_clock = false;
+uint64_t g_virtual_micros = 0;
+
+uint64_t monotonic_micros()
+{
+  static uint64_t origin = 0;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t us = static_cast<uint64_t>(now.tv_sec) * 1000000ULL + static_cast<uint64_t>(now.tv_nsec) / 1000ULL;
+  // Start at zero like a freshly booted board.
+  if(origin == 0)
+  {
+    origin = us;
+  }
+  return us - origin;
+}
+
+}
+
+// HOST CLOCK
+void host::use_virtual_clock(bool enabled)
+{
+  g_virtual_clock = enabled;
+}
+void host::set_micros(uint64_t us)
+{
+  g_virtual_micros = us;
+}
+void host::advance_micros(uint64_t us)
+{
+  g_virtual_micros += us;
+}
+uint64_t host::now_micros()
+{
+  return g_virtual_clock ? g_virtual_micros : monotonic_micros();
+}
+
+// TIMING
+// The host clock is 64 bits wide and is not truncated, so it never wraps during a run.
+unsigned long millis()
+{
+  return static_cast<unsigned long>(host::now_micros() / 1000ULL);
+}
+unsigned long micros()
+{
+  return static_cast<unsigned long>(host::now_micros());
+}
+void delay(unsigned long ms)
+{
+  uint64_t end = host::now_micros() + static_cast<uint64_t>(ms) * 1000ULL;
+  while(host::now_micros() < end)
+  {
+    yield();
+    // A virtual clock jumps straight to the end of the delay.
+    if(g_virtual_clock && g_virtual_micros < end)
+    {
+      g_virtual_micros = end;
+    }
+  }
+}
+void delayMicroseconds(unsigned int us)
+{
+  if(g_virtual_clock)
+  {
+    g_virtual_micros += us;
+    return;
+  }
+  uint64_t end = monotonic_micros() + us;
+  while(monotonic_micros() < end)
+  {
+  }
+}
+void yield() __attribute__((weak));
+void yield()
+{
+}
+
+// PRINT
+size_t Print::write(const uint8_t* buffer, size_t size)
+{
+  size_t n = 0;
+  while(size--)
+  {
+    n += write(*buffer++);
+  }
+  return n;
+}
+
+// STREAM
+int Stream::timedRead()
+{
+  // Only look at the clock once the stream has run dry.
+  int c = read();
+  if(c >= 0)
+  {
+    return c;
+  }
+  uint64_t start = host::now_micros();
+  do
+  {
+    c = read();
+    if(c >= 0)
+    {
+      return c;
+    }
+    // Let a virtual clock move forward while waiting, otherwise the timeout could never elapse.
+    if(g_virtual_clock)
+    {
+      g_virtual_micros += 100;
+    }
+  } while(host::now_micros() - start < static_cast<uint64_t>(m_timeout) * 1000ULL);
+  return -1;
+}
+size_t Stream::readBytes(uint8_t* buffer, size_t length)
+{
+  size_t count = 0;
+  while(count < length)
+  {
+    int c = timedRead();
+    if(c < 0)
+    {
+      break;
+    }
+    buffer[count++] = static_cast<uint8_t>(c);
+  }
+  return count;
+}
@@ -0,0 +1,91 @@
+/// \file Arduino.h
+/// \brief A minimal host (Linux) stand-in for the Arduino core.
+/// \details Provides just enough of the Arduino API (Print, Stream, timing, PROGMEM) for the
+/// SerialCommunicator library and the e-stop xbee code to compile and run on a PC.  The clock can be
+/// switched to a virtual clock so that simulations and replays are deterministic.
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW  0x0
+
+// PROGMEM is ordinary memory on the host.
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(address) (*reinterpret_cast<const uint8_t*>(address))
+#define memcpy_P memcpy
+
+template <typename T>
+inline T min(T a, T b) { return (b < a) ? b : a; }
+template <typename T>
+inline T max(T a, T b) { return (a < b) ? b : a; }
+
+// TIMING
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+/// \brief host Contains host-only helpers that have no Arduino equivalent.
+namespace host {
+
+/// \brief use_virtual_clock Switches millis()/micros() between the real monotonic clock and a virtual clock.
+/// \param enabled TRUE to use the virtual clock, which only moves when advanced or when the code waits.
+void use_virtual_clock(bool enabled);
+/// \brief set_micros Sets the virtual clock.
+/// \param us The new virtual time, in microseconds.
+void set_micros(uint64_t us);
+/// \brief advance_micros Moves the virtual clock forward.
+/// \param us The number of microseconds to advance by.
+void advance_micros(uint64_t us);
+/// \brief now_micros Gets the current time of the active clock without 32-bit truncation.
+/// \returns The current time, in microseconds.
+uint64_t now_micros();
+
+}
+
+/// \brief Print Base class for anything bytes can be written to.
+class Print
+{
+public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+  size_t write(const char* buffer, size_t size) { return write(reinterpret_cast<const uint8_t*>(buffer), size); }
+  size_t write(const char* str) { return write(str, strlen(str)); }
+  /// \details Like the Arduino core, the default is 0.  Streams that buffer output must override this.
+  virtual int availableForWrite() { return 0; }
+  virtual void flush() {}
+  size_t print(const char* str) { return write(str); }
+  size_t print(char c) { return write(static_cast<uint8_t>(c)); }
+  size_t println(const char* str) { return write(str) + write("\r\n"); }
+};
+
+/// \brief Stream Base class for bidirectional byte streams with a read timeout.
+class Stream : public Print
+{
+public:
+  Stream() : m_timeout(1000) {}
+  virtual int available() = 0;
+  virtual int read() = 0;
+  virtual int peek() = 0;
+  void setTimeout(unsigned long timeout) { m_timeout = timeout; }
+  unsigned long getTimeout() { return m_timeout; }
+  size_t readBytes(uint8_t* buffer, size_t length);
+  size_t readBytes(char* buffer, size_t length) { return readBytes(reinterpret_cast<uint8_t*>(buffer), length); }
+
+protected:
+  unsigned long m_timeout;
+  int timedRead();
+};
+
+#endif
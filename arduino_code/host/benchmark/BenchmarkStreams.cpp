@@ -0,0 +1,130 @@
+#include "BenchmarkStreams.h"
+
+using namespace SC;
+
+// SINKSTREAM
+SinkStream::SinkStream()
+{
+    SinkStream::mWritten = 0;
+}
+int SinkStream::available()
+{
+    return 0;
+}
+int SinkStream::read()
+{
+    return -1;
+}
+int SinkStream::peek()
+{
+    return -1;
+}
+size_t SinkStream::write(uint8_t Value)
+{
+    (void)Value;
+    SinkStream::mWritten++;
+    return 1;
+}
+size_t SinkStream::write(const uint8_t* Buffer, size_t Size)
+{
+    (void)Buffer;
+    SinkStream::mWritten += Size;
+    return Size;
+}
+int SinkStream::availableForWrite()
+{
+    return 0x7FFF;
+}
+unsigned long long SinkStream::pBytesWritten() const
+{
+    return SinkStream::mWritten;
+}
+
+// PATTERNSTREAM
+PatternStream::PatternStream(const std::vector<byte>& Pattern)
+{
+    PatternStream::mPattern = Pattern;
+    PatternStream::mPosition = 0;
+}
+int PatternStream::available()
+{
+    return 0x7FFF;
+}
+int PatternStream::read()
+{
+    byte Value = PatternStream::mPattern[PatternStream::mPosition++];
+    if(PatternStream::mPosition == PatternStream::mPattern.size())
+    {
+        PatternStream::mPosition = 0;
+    }
+    return Value;
+}
+int PatternStream::peek()
+{
+    return PatternStream::mPattern[PatternStream::mPosition];
+}
+size_t PatternStream::write(uint8_t Value)
+{
+    (void)Value;
+    return 1;
+}
+
+// LOOPBACKSTREAM
+LoopbackStream::LoopbackStream()
+{
+    LoopbackStream::mInboxPosition = 0;
+    LoopbackStream::mPeer = NULL;
+    LoopbackStream::mWritten = 0;
+}
+void LoopbackStream::Connect(LoopbackStream& A, LoopbackStream& B)
+{
+    A.mPeer = &B;
+    B.mPeer = &A;
+}
+int LoopbackStream::available()
+{
+    return static_cast<int>(LoopbackStream::mInbox.size() - LoopbackStream::mInboxPosition);
+}
+int LoopbackStream::read()
+{
+    if(LoopbackStream::mInboxPosition == LoopbackStream::mInbox.size())
+    {
+        return -1;
+    }
+    byte Value = LoopbackStream::mInbox[LoopbackStream::mInboxPosition++];
+    // Reclaim the inbox once it has been read out.
+    if(LoopbackStream::mInboxPosition == LoopbackStream::mInbox.size())
+    {
+        LoopbackStream::mInbox.clear();
+        LoopbackStream::mInboxPosition = 0;
+    }
+    return Value;
+}
+int LoopbackStream::peek()
+{
+    if(LoopbackStream::mInboxPosition == LoopbackStream::mInbox.size())
+    {
+        return -1;
+    }
+    return LoopbackStream::mInbox[LoopbackStream::mInboxPosition];
+}
+size_t LoopbackStream::write(uint8_t Value)
+{
+    LoopbackStream::mPeer->mInbox.push_back(Value);
+    LoopbackStream::mWritten++;
+    return 1;
+}
+size_t LoopbackStream::write(const uint8_t* Buffer, size_t Size)
+{
+    LoopbackStream::mPeer->mInbox.insert(LoopbackStream::mPeer->mInbox.end(), Buffer, Buffer + Size);
+    LoopbackStream::mWritten += Size;
+    return Size;
+}
+int LoopbackStream::availableForWrite()
+{
+    return 0x7FFF;
+}
+unsigned long long LoopbackStream::pBytesWritten() const
+{
+    return LoopbackStream::mWritten;
+}
@@ -0,0 +1,106 @@
+/// \file BenchmarkStreams.h
+/// \brief Defines the in-memory Streams used by the SerialCommunicator benchmarks.
+#ifndef BENCHMARKSTREAMS_H
+#define BENCHMARKSTREAMS_H
+
+#include "Arduino.h"
+
+#include <vector>
+
+namespace SC {
+
+///
+/// \brief A Stream that discards everything written to it and never has anything to read.
+/// \details Used to time the transmit path on its own.
+///
+class SinkStream : public Stream
+{
+public:
+    SinkStream();
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+    size_t write(const uint8_t* Buffer, size_t Size) override;
+    int availableForWrite() override;
+
+    // PROPERTIES
+    ///
+    /// \brief pBytesWritten PROPERTY Gets the number of bytes written so far.
+    ///
+    unsigned long long pBytesWritten() const;
+
+private:
+    unsigned long long mWritten;
+};
+
+///
+/// \brief A Stream that serves the same bytes over and over.
+/// \details Used to time the receive path on its own.  Load it with exactly one escaped packet and every
+/// read of that packet's unescaped length consumes one full repetition.
+///
+class PatternStream : public Stream
+{
+public:
+    ///
+    /// \brief PatternStream Creates a new stream.
+    /// \param Pattern The bytes to serve repeatedly.  Must not be empty.
+    ///
+    PatternStream(const std::vector<byte>& Pattern);
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+
+private:
+    std::vector<byte> mPattern;
+    size_t mPosition;
+};
+
+///
+/// \brief One end of an in-memory serial link.
+/// \details Bytes written to one end can be read from the other, with no loss or delay.
+///
+class LoopbackStream : public Stream
+{
+public:
+    LoopbackStream();
+
+    ///
+    /// \brief Connect Links two ends together.
+    /// \param A The first end.
+    /// \param B The second end.
+    ///
+    static void Connect(LoopbackStream& A, LoopbackStream& B);
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+    size_t write(const uint8_t* Buffer, size_t Size) override;
+    int availableForWrite() override;
+
+    // PROPERTIES
+    ///
+    /// \brief pBytesWritten PROPERTY Gets the number of bytes written to this end so far.
+    ///
+    unsigned long long pBytesWritten() const;
+
+private:
+    ///
+    /// \brief mInbox Stores the bytes written by the other end that have not been read yet.
+    ///
+    std::vector<byte> mInbox;
+    size_t mInboxPosition;
+    LoopbackStream* mPeer;
+    unsigned long long mWritten;
+};
+
+}
+
+#endif // BENCHMARKSTREAMS_H
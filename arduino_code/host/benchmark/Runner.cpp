@@ -0,0 +1,99 @@
+#include "Runner.h"
+
+#include <algorithm>
+#include <chrono>
+
+using namespace SC;
+
+// CONSTRUCTORS
+Runner::Runner(double MinSeconds, unsigned int Repetitions, const std::string& Filter)
+{
+    Runner::mMinSeconds = MinSeconds;
+    Runner::mRepetitions = std::max(1u, Repetitions);
+    Runner::mFilter = Filter;
+}
+
+// METHODS
+void Runner::Run(const std::string& Benchmark, const std::vector<Parameter>& Parameters, unsigned long OpsPerIteration, double BytesPerOp, const Body& Function)
+{
+    std::string Name = Benchmark + "/" + Runner::Describe(Parameters, ',');
+    if(!Runner::mFilter.empty() && Name.find(Runner::mFilter) == std::string::npos)
+    {
+        return;
+    }
+
+    // Calibrate: grow the iteration count until a run takes the minimum time.
+    uint64_t Iterations = 1;
+    double Elapsed = Runner::Time(Function, Iterations);
+    while(Elapsed < Runner::mMinSeconds)
+    {
+        double Scale = (Elapsed > 0) ? 1.4 * Runner::mMinSeconds / Elapsed : 100.0;
+        Iterations = static_cast<uint64_t>(Iterations * std::min(100.0, std::max(2.0, Scale)));
+        Elapsed = Runner::Time(Function, Iterations);
+    }
+
+    // Repeat at the calibrated count and keep the median.
+    std::vector<double> Samples(1, Elapsed);
+    for(unsigned int i = 1; i < Runner::mRepetitions; i++)
+    {
+        Samples.push_back(Runner::Time(Function, Iterations));
+    }
+    std::sort(Samples.begin(), Samples.end());
+
+    Result Output;
+    Output.Benchmark = Benchmark;
+    Output.Parameters = Parameters;
+    Output.Iterations = Iterations;
+    Output.NanosecondsPerOp = Samples[Samples.size() / 2] * 1e9 / (static_cast<double>(Iterations) * OpsPerIteration);
+    Output.BytesPerOp = BytesPerOp;
+    Runner::mResults.push_back(Output);
+
+    fprintf(stderr, "%-48s %12.1f ns/op\n", Name.c_str(), Output.NanosecondsPerOp);
+}
+void Runner::WriteCSV(FILE* Output) const
+{
+    fprintf(Output, "benchmark,params,iterations,ns_per_op,bytes_per_op,mb_per_s\n");
+    for(size_t i = 0; i < Runner::mResults.size(); i++)
+    {
+        const Result& Entry = Runner::mResults[i];
+        double Throughput = (Entry.BytesPerOp > 0) ? Entry.BytesPerOp * 1e3 / Entry.NanosecondsPerOp : 0.0;
+        fprintf(Output, "%s,%s,%llu,%.3f,%.1f,%.3f\n", Entry.Benchmark.c_str(), Runner::Describe(Entry.Parameters, ';').c_str(),
+                static_cast<unsigned long long>(Entry.Iterations), Entry.NanosecondsPerOp, Entry.BytesPerOp, Throughput);
+    }
+}
+void Runner::WriteJSON(FILE* Output) const
+{
+    fprintf(Output, "{\n  \"results\": [");
+    for(size_t i = 0; i < Runner::mResults.size(); i++)
+    {
+        const Result& Entry = Runner::mResults[i];
+        double Throughput = (Entry.BytesPerOp > 0) ? Entry.BytesPerOp * 1e3 / Entry.NanosecondsPerOp : 0.0;
+        fprintf(Output, "%s\n    {\"benchmark\": \"%s\", \"params\": {", (i > 0) ? "," : "", Entry.Benchmark.c_str());
+        for(size_t j = 0; j < Entry.Parameters.size(); j++)
+        {
+            fprintf(Output, "%s\"%s\": %ld", (j > 0) ? ", " : "", Entry.Parameters[j].Name.c_str(), Entry.Parameters[j].Value);
+        }
+        fprintf(Output, "}, \"iterations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_op\": %.1f, \"mb_per_s\": %.3f}",
+                static_cast<unsigned long long>(Entry.Iterations), Entry.NanosecondsPerOp, Entry.BytesPerOp, Throughput);
+    }
+    fprintf(Output, "\n  ]\n}\n");
+}
+double Runner::Time(const Body& Function, uint64_t Iterations)
+{
+    std::chrono::steady_clock::time_point Start = std::chrono::steady_clock::now();
+    Function(Iterations);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+}
+std::string Runner::Describe(const std::vector<Parameter>& Parameters, char Separator)
+{
+    std::string Output;
+    for(size_t i = 0; i < Parameters.size(); i++)
+    {
+        if(i > 0)
+        {
+            Output += Separator;
+        }
+        Output += Parameters[i].Name + "=" + std::to_string(Parameters[i].Value);
+    }
+    return Output;
+}
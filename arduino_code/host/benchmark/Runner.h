@@ -0,0 +1,106 @@
+/// \file Runner.h
+/// \brief Defines the SC::Runner class.
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace SC {
+
+///
+/// \brief Prevents the compiler from optimizing away a benchmarked result.
+/// \param Value The value to keep.
+///
+template <typename T>
+inline void Keep(const T& Value)
+{
+    asm volatile("" : : "r,m"(Value) : "memory");
+}
+
+///
+/// \brief Times benchmark bodies and collects their results.
+/// \details Each benchmark is calibrated until one run takes at least the minimum time, then repeated and
+/// the median is reported.  Results are written as CSV or JSON so runs can be compared by scripts.
+///
+class Runner
+{
+public:
+    // STRUCTURES
+    ///
+    /// \brief A named integer parameter of a benchmark case (e.g. payload length).
+    ///
+    struct Parameter
+    {
+        std::string Name;
+        long Value;
+    };
+    ///
+    /// \brief The result of one benchmark case.
+    ///
+    struct Result
+    {
+        std::string Benchmark;
+        std::vector<Parameter> Parameters;
+        uint64_t Iterations;
+        double NanosecondsPerOp;
+        double BytesPerOp;
+    };
+    ///
+    /// \brief A benchmark body.  Runs the measured operation the given number of iterations.
+    ///
+    typedef std::function<void(uint64_t)> Body;
+
+    // CONSTRUCTORS
+    ///
+    /// \brief Runner Creates a new runner.
+    /// \param MinSeconds The minimum duration of each timed run.
+    /// \param Repetitions The number of timed runs per case.  The median is reported.
+    /// \param Filter Only cases whose "benchmark/parameters" name contains this are run.  Empty runs everything.
+    ///
+    Runner(double MinSeconds, unsigned int Repetitions, const std::string& Filter);
+
+    // METHODS
+    ///
+    /// \brief Run Times a benchmark case.
+    /// \param Benchmark The name of the benchmark.
+    /// \param Parameters The parameters of this case.
+    /// \param OpsPerIteration The number of operations performed by one iteration of the body.
+    /// \param BytesPerOp The number of payload bytes processed per operation, or 0 if throughput is meaningless.
+    /// \param Function The body to time.
+    ///
+    void Run(const std::string& Benchmark, const std::vector<Parameter>& Parameters, unsigned long OpsPerIteration, double BytesPerOp, const Body& Function);
+    ///
+    /// \brief WriteCSV Writes all results as CSV, one case per line.
+    /// \param Output The file to write to.
+    ///
+    void WriteCSV(FILE* Output) const;
+    ///
+    /// \brief WriteJSON Writes all results as a JSON document.
+    /// \param Output The file to write to.
+    ///
+    void WriteJSON(FILE* Output) const;
+
+private:
+    double mMinSeconds;
+    unsigned int mRepetitions;
+    std::string mFilter;
+    std::vector<Result> mResults;
+
+    ///
+    /// \brief Time Runs the body once and measures it.
+    /// \return The elapsed time in seconds.
+    ///
+    static double Time(const Body& Function, uint64_t Iterations);
+    ///
+    /// \brief Describe Formats parameters as "name=value" pairs.
+    ///
+    static std::string Describe(const std::vector<Parameter>& Parameters, char Separator);
+};
+
+}
+
+#endif // RUNNER_H
@@ -0,0 +1,507 @@
+/// \file scbench.cpp
+/// \brief Microbenchmarks for the SerialCommunicator hot paths.
+///
+/// Usage:
+///   scbench [--format csv|json] [--filter text] [--min-time seconds] [--repetitions n] [--output file]
+///
+/// Results go to stdout (or --output) as CSV or JSON; progress goes to stderr.
+#include "BenchmarkStreams.h"
+#include "Runner.h"
+
+#include <SerialCommunicator.h>
+#include <utility/Serialization.h>
+#include <utility/Escape.h>
+
+#include <stdlib.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace SC;
+
+namespace {
+
+///
+/// \brief Exposes the Communicator's internal framing methods to the benchmarks.
+///
+class CommunicatorProbe : public Communicator
+{
+public:
+    CommunicatorProbe(Stream& SerialPort) : Communicator(SerialPort) {}
+
+    using Communicator::Checksum;
+    using Communicator::TX;
+    using Communicator::RX;
+    using Communicator::TXQCount;
+
+    static const byte cHeader = Communicator::cHeaderByte;
+    static const byte cEscape = Communicator::cEscapeByte;
+};
+
+void fail(const char* what)
+{
+    fprintf(stderr, "scbench: %s\n", what);
+    exit(1);
+}
+
+///
+/// \brief Builds a packet of the given length whose bytes after the header need escaping at the given rate.
+/// \param length The packet length, including the header byte.
+/// \param density The percentage of bytes that are header or escape bytes.
+///
+std::vector<byte> make_packet(unsigned int length, unsigned int density)
+{
+    std::vector<byte> packet(length);
+    uint32_t state = 0x2015u + length * 31u + density;
+    packet[0] = CommunicatorProbe::cHeader;
+    for(unsigned int i = 1; i < length; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        if((state >> 8) % 100 < density)
+        {
+            if(state & 0x80000000u)
+            {
+                packet[i] = CommunicatorProbe::cHeader;
+            }
+            else
+            {
+                packet[i] = CommunicatorProbe::cEscape;
+            }
+        }
+        else
+        {
+            // Any byte but the two special ones.
+            byte value = static_cast<byte>(state >> 24);
+            packet[i] = (value == CommunicatorProbe::cHeader || value == CommunicatorProbe::cEscape) ? value + 2 : value;
+        }
+    }
+    return packet;
+}
+
+///
+/// \brief Escapes the bytes after the header the same way Communicator::TX does.
+///
+std::vector<byte> escape(const std::vector<byte>& packet)
+{
+    std::vector<byte> output;
+    for(size_t i = 1; i < packet.size(); i++)
+    {
+        if(packet[i] == CommunicatorProbe::cHeader || packet[i] == CommunicatorProbe::cEscape)
+        {
+            output.push_back(static_cast<byte>(CommunicatorProbe::cEscape));
+            output.push_back(packet[i] - 1);
+        }
+        else
+        {
+            output.push_back(packet[i]);
+        }
+    }
+    return output;
+}
+
+template <typename T>
+void bench_serialize(Runner& runner)
+{
+    byte buffer[256];
+    runner.Run("serialize", {{"size", sizeof(T)}}, 1, sizeof(T), [&](uint64_t n) {
+        for(uint64_t i = 0; i < n; i++)
+        {
+            SC::Serialize<T>(buffer, (i & 63) * 4, static_cast<T>(i));
+        }
+        Keep(buffer);
+    });
+    runner.Run("deserialize", {{"size", sizeof(T)}}, 1, sizeof(T), [&](uint64_t n) {
+        T sum = 0;
+        for(uint64_t i = 0; i < n; i++)
+        {
+            sum += SC::Deserialize<T>(buffer, (i & 63) * 4);
+        }
+        Keep(sum);
+    });
+}
+
+void bench_message(Runner& runner)
+{
+    const unsigned int lengths[] = {0, 4, 16, 64, 255};
+    for(unsigned int length : lengths)
+    {
+        Message message(0x1001, length);
+        for(unsigned int i = 0; i < length; i++)
+        {
+            message.SetData<uint8_t>(i, static_cast<uint8_t>(i));
+        }
+        std::vector<byte> buffer(message.pMessageLength());
+        runner.Run("message_serialize", {{"len", length}}, 1, message.pMessageLength(), [&](uint64_t n) {
+            for(uint64_t i = 0; i < n; i++)
+            {
+                message.Serialize(buffer.data(), 0);
+                Keep(buffer[0]);
+            }
+        });
+        runner.Run("message_deserialize", {{"len", length}}, 1, message.pMessageLength(), [&](uint64_t n) {
+            for(uint64_t i = 0; i < n; i++)
+            {
+                Message copy(buffer.data(), 0);
+                Keep(copy);
+            }
+        });
+    }
+}
+
+void bench_checksum(Runner& runner)
+{
+    SinkStream sink;
+    CommunicatorProbe probe(sink);
+    const unsigned int lengths[] = {8, 32, 128, 512, 2048};
+    for(unsigned int length : lengths)
+    {
+        std::vector<byte> packet = make_packet(length, 10);
+        runner.Run("checksum", {{"len", length}}, 1, length, [&](uint64_t n) {
+            for(uint64_t i = 0; i < n; i++)
+            {
+                Keep(probe.Checksum(packet.data(), length));
+            }
+        });
+    }
+}
+
+///
+/// \brief Checks that FindEscape() matches FindEscapeScalar() at every offset and length, on random and adversarial data.
+///
+void check_escape_scan()
+{
+    std::vector<byte> data = make_packet(4096, 3);
+    std::vector<byte> dense = make_packet(4096, 50);
+    data.insert(data.end(), dense.begin(), dense.end());
+    for(unsigned int start = 0; start < 64; start++)
+    {
+        for(unsigned long length = 0; length + start <= data.size(); length += (length < 128) ? 1 : 61)
+        {
+            const byte* chunk = data.data() + start;
+            if(FindEscape(chunk, length, CommunicatorProbe::cHeader, CommunicatorProbe::cEscape) != FindEscapeScalar(chunk, length, CommunicatorProbe::cHeader, CommunicatorProbe::cEscape)
+               || FindEscape(chunk, length, CommunicatorProbe::cEscape, CommunicatorProbe::cEscape) != FindEscapeScalar(chunk, length, CommunicatorProbe::cEscape, CommunicatorProbe::cEscape))
+            {
+                fail("FindEscape does not match FindEscapeScalar");
+            }
+        }
+    }
+}
+
+///
+/// \brief Times splitting a payload into escape-free runs with the vectorized and scalar scans.
+/// \details density 50 with period 0 is random; a non-zero period instead places an escape byte every period bytes,
+/// which is the adversarial case for the vectorized scan (a match in every block).
+///
+void bench_escape_scan(Runner& runner)
+{
+    struct Case { unsigned int density; unsigned int period; };
+    const Case cases[] = {{0, 0}, {1, 0}, {5, 0}, {25, 0}, {100, 0}, {0, 2}, {0, 17}};
+    const unsigned int length = 4096;
+    for(const Case& test : cases)
+    {
+        std::vector<byte> payload = make_packet(length, test.density);
+        for(unsigned int i = 1; test.period > 0 && i < length; i += test.period)
+        {
+            payload[i] = CommunicatorProbe::cEscape;
+        }
+        for(unsigned int simd = 0; simd < 2; simd++)
+        {
+            unsigned long (*scan)(const byte*, unsigned long, byte, byte) = simd ? FindEscape : FindEscapeScalar;
+            runner.Run("escape_scan", {{"len", length}, {"density", test.density}, {"period", test.period}, {"simd", simd}}, 1, length, [&](uint64_t n) {
+                for(uint64_t i = 0; i < n; i++)
+                {
+                    unsigned long runs = 0;
+                    for(unsigned long position = 0; position < length; position++)
+                    {
+                        position += scan(&payload[position], length - position, CommunicatorProbe::cHeader, CommunicatorProbe::cEscape);
+                        runs++;
+                    }
+                    Keep(runs);
+                }
+            });
+        }
+    }
+}
+
+void bench_escape(Runner& runner)
+{
+    const unsigned int lengths[] = {16, 64, 256, 4096};
+    const unsigned int densities[] = {0, 5, 25, 50, 100};
+    for(unsigned int length : lengths)
+    {
+        for(unsigned int density : densities)
+        {
+            std::vector<byte> packet = make_packet(length, density);
+
+            SinkStream sink;
+            CommunicatorProbe transmitter(sink);
+            runner.Run("escape_tx", {{"len", length}, {"density", density}}, 1, length, [&](uint64_t n) {
+                for(uint64_t i = 0; i < n; i++)
+                {
+                    transmitter.TX(packet.data(), length);
+                }
+            });
+
+            // RX reads everything after the header, so the pattern is one escaped packet body.
+            PatternStream pattern(escape(packet));
+            CommunicatorProbe receiver(pattern);
+            std::vector<byte> buffer(length - 1);
+            if(receiver.RX(buffer.data(), length - 1) != length - 1 || !std::equal(buffer.begin(), buffer.end(), packet.begin() + 1))
+            {
+                fail("unescape_rx does not reproduce the packet");
+            }
+            runner.Run("unescape_rx", {{"len", length}, {"density", density}}, 1, length, [&](uint64_t n) {
+                for(uint64_t i = 0; i < n; i++)
+                {
+                    receiver.RX(buffer.data(), length - 1);
+                    Keep(buffer[0]);
+                }
+            });
+        }
+    }
+}
+
+///
+/// \brief Times Send -> Spin -> Spin -> Receive, one way over a loopback link.
+/// \details bytes_per_op is the number of bytes written to the link per message, in both directions.
+///
+void bench_roundtrip(Runner& runner)
+{
+    const unsigned int lengths[] = {0, 4, 64};
+    for(unsigned int length : lengths)
+    {
+        for(unsigned int receipt = 0; receipt < 2; receipt++)
+        {
+            LoopbackStream a, b;
+            LoopbackStream::Connect(a, b);
+            Communicator sender(a), receiver(b);
+            sender.pReceiptTimeout(60000);
+
+            auto once = [&]() {
+                sender.Send(Message(0x1001, length), receipt);
+                sender.Spin();
+                receiver.Spin();
+                MessageHandle message = receiver.Receive();
+                if(!message)
+                {
+                    fail("roundtrip lost a message");
+                }
+                if(receipt)
+                {
+                    sender.Spin();
+                }
+            };
+            once();
+            unsigned long long before = a.pBytesWritten() + b.pBytesWritten();
+            once();
+            double wire = static_cast<double>(a.pBytesWritten() + b.pBytesWritten() - before);
+
+            runner.Run("roundtrip", {{"len", length}, {"receipt", receipt}}, 1, wire, [&](uint64_t n) {
+                for(uint64_t i = 0; i < n; i++)
+                {
+                    once();
+                }
+            });
+        }
+    }
+}
+
+///
+/// \brief Times a request/response exchange with receipts in both directions, with and without piggybacked receipts.
+/// \details bytes_per_op is the number of bytes written to the link per exchange, in both directions.
+///
+void bench_exchange(Runner& runner)
+{
+    for(unsigned int piggyback = 0; piggyback < 2; piggyback++)
+    {
+        LoopbackStream a, b;
+        LoopbackStream::Connect(a, b);
+        Communicator client(a), server(b);
+        client.pReceiptTimeout(60000);
+        server.pReceiptTimeout(60000);
+        client.pPiggybackAcks(piggyback);
+        server.pPiggybackAcks(piggyback);
+
+        // Each side spins until the other's message arrives, since standalone receipts take a spin of their own.
+        auto once = [&]() {
+            client.Send(Message(0x1001, 8), true);
+            client.Spin();
+            for(unsigned int i = 0; i < 4 && server.MessagesAvailable() == 0; i++)
+            {
+                server.Spin();
+            }
+            if(!server.Receive())
+            {
+                fail("exchange lost a request");
+            }
+            server.Send(Message(0x1002, 8), true);
+            server.Spin();
+            for(unsigned int i = 0; i < 4 && client.MessagesAvailable() == 0; i++)
+            {
+                client.Spin();
+            }
+            if(!client.Receive())
+            {
+                fail("exchange lost a response");
+            }
+        };
+        once();
+        unsigned long long before = a.pBytesWritten() + b.pBytesWritten();
+        for(unsigned int i = 0; i < 100; i++)
+        {
+            once();
+        }
+        double wire = (a.pBytesWritten() + b.pBytesWritten() - before) / 100.0;
+
+        runner.Run("exchange", {{"piggyback", piggyback}}, 1, wire, [&](uint64_t n) {
+            for(uint64_t i = 0; i < n; i++)
+            {
+                once();
+            }
+        });
+    }
+}
+
+///
+/// \brief Times filling and draining full TX and RX queues of various depths.
+/// \details The sender queues `depth` messages and sends them all before the receiver spins, so both the TX
+/// queues and the receiver's RX queue reach full depth.  Reported per message.
+///
+void bench_queue_depth(Runner& runner)
+{
+    const unsigned int depths[] = {20, 100, 1000, 10000};
+    for(unsigned int depth : depths)
+    {
+        for(unsigned int receipt = 0; receipt < 2; receipt++)
+        {
+            LoopbackStream a, b;
+            LoopbackStream::Connect(a, b);
+            CommunicatorProbe sender(a), receiver(b);
+            sender.pQueueSize(depth);
+            receiver.pQueueSize(depth);
+            sender.pReceiptTimeout(600000);
+
+            runner.Run("queue_depth", {{"depth", depth}, {"receipt", receipt}}, depth, 0, [&](uint64_t n) {
+                for(uint64_t i = 0; i < n; i++)
+                {
+                    for(unsigned int j = 0; j < depth; j++)
+                    {
+                        if(!sender.Send(Message(0x1001, 4), receipt))
+                        {
+                            fail("queue_depth overflowed the TX queue");
+                        }
+                    }
+                    for(unsigned int j = 0; j < depth; j++)
+                    {
+                        sender.Spin();
+                    }
+                    for(unsigned int j = 0; j < depth; j++)
+                    {
+                        receiver.Spin();
+                    }
+                    unsigned int received = 0;
+                    while(receiver.Receive())
+                    {
+                        received++;
+                    }
+                    if(receipt)
+                    {
+                        for(unsigned int j = 0; j < depth; j++)
+                        {
+                            sender.Spin();
+                        }
+                    }
+                    if(received != depth || sender.TXQCount() != 0)
+                    {
+                        fail("queue_depth did not drain");
+                    }
+                }
+            });
+        }
+    }
+}
+
+int usage()
+{
+    fprintf(stderr, "usage: scbench [--format csv|json] [--filter text] [--min-time seconds] [--repetitions n] [--output file]\n");
+    return 2;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+    std::string format = "csv";
+    std::string filter;
+    std::string output;
+    double min_time = 0.2;
+    unsigned int repetitions = 3;
+    for(int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if(i + 1 >= argc)
+        {
+            return usage();
+        }
+        std::string value = argv[++i];
+        if(option == "--format" && (value == "csv" || value == "json"))
+        {
+            format = value;
+        }
+        else if(option == "--filter")
+        {
+            filter = value;
+        }
+        else if(option == "--min-time")
+        {
+            min_time = atof(value.c_str());
+        }
+        else if(option == "--repetitions")
+        {
+            repetitions = static_cast<unsigned int>(atoi(value.c_str()));
+        }
+        else if(option == "--output")
+        {
+            output = value;
+        }
+        else
+        {
+            return usage();
+        }
+    }
+
+    check_escape_scan();
+    fprintf(stderr, "escape kernel: %s\n", EscapeKernel());
+
+    Runner runner(min_time, repetitions, filter);
+    bench_serialize<uint8_t>(runner);
+    bench_serialize<uint16_t>(runner);
+    bench_serialize<uint32_t>(runner);
+    bench_message(runner);
+    bench_checksum(runner);
+    bench_escape_scan(runner);
+    bench_escape(runner);
+    bench_roundtrip(runner);
+    bench_exchange(runner);
+    bench_queue_depth(runner);
+
+    FILE* file = output.empty() ? stdout : fopen(output.c_str(), "w");
+    if(file == NULL)
+    {
+        fprintf(stderr, "scbench: cannot write %s\n", output.c_str());
+        return 1;
+    }
+    if(format == "json")
+    {
+        runner.WriteJSON(file);
+    }
+    else
+    {
+        runner.WriteCSV(file);
+    }
+    if(file != stdout)
+    {
+        fclose(file);
+    }
+    return 0;
+}
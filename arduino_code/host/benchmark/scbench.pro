@@ -0,0 +1,15 @@
+TEMPLATE = app
+TARGET = scbench
+
+include(../host.pri)
+
+QMAKE_CXXFLAGS_RELEASE += -O2
+
+SOURCES += \
+    BenchmarkStreams.cpp \
+    Runner.cpp \
+    scbench.cpp
+
+HEADERS += \
+    BenchmarkStreams.h \
+    Runner.h
@@ -0,0 +1,189 @@
+#include "CaptureReader.h"
+
+#include <utility/Serialization.h>
+
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace SC;
+
+CaptureReader::CaptureReader()
+{
+  CaptureReader::mData = NULL;
+  CaptureReader::mSize = 0;
+  CaptureReader::mTruncated = false;
+  CaptureReader::Rewind();
+}
+CaptureReader::~CaptureReader()
+{
+  CaptureReader::Close();
+}
+
+// METHODS
+bool CaptureReader::Open(const char* Path)
+{
+  CaptureReader::Close();
+
+  int File = open(Path, O_RDONLY);
+  if(File < 0)
+  {
+    return false;
+  }
+  struct stat Info;
+  if(fstat(File, &Info) != 0 || Info.st_size == 0)
+  {
+    close(File);
+    return false;
+  }
+  void* Map = mmap(NULL, Info.st_size, PROT_READ, MAP_PRIVATE, File, 0);
+  // The mapping stays valid after the descriptor is closed.
+  close(File);
+  if(Map == MAP_FAILED)
+  {
+    return false;
+  }
+  // Captures are read front to back.
+  madvise(Map, Info.st_size, MADV_SEQUENTIAL);
+
+  CaptureReader::mData = static_cast<const byte*>(Map);
+  CaptureReader::mSize = Info.st_size;
+  CaptureReader::Rewind();
+
+  // A capture must start with a session record.
+  Record First;
+  if(!CaptureReader::Parse(0, First) || First.Channel != Capture::Channel::Session ||
+     First.Length < 5 || memcmp(First.Frame, "SCAP", 4) != 0)
+  {
+    CaptureReader::Close();
+    return false;
+  }
+  return true;
+}
+void CaptureReader::Close()
+{
+  if(CaptureReader::mData != NULL)
+  {
+    munmap(const_cast<byte*>(CaptureReader::mData), CaptureReader::mSize);
+  }
+  CaptureReader::mData = NULL;
+  CaptureReader::mSize = 0;
+  CaptureReader::mTruncated = false;
+  CaptureReader::mIndex.clear();
+  CaptureReader::Rewind();
+}
+void CaptureReader::Rewind()
+{
+  CaptureReader::mPosition = 0;
+  CaptureReader::mSession = 0;
+  CaptureReader::mSessionStart = 0;
+  CaptureReader::mLastRaw = 0;
+  CaptureReader::mEpoch = 0;
+  CaptureReader::mInSession = false;
+}
+bool CaptureReader::Next(Record& Output)
+{
+  if(!CaptureReader::Parse(CaptureReader::mPosition, Output))
+  {
+    // Anything left over is a partially written record.
+    CaptureReader::mTruncated = CaptureReader::mPosition < CaptureReader::mSize;
+    return false;
+  }
+  CaptureReader::mPosition += Capture::cRecordHeaderLength + Output.Length;
+
+  // Parse() leaves the raw 32-bit micros() value in Timestamp.  Unwrap it relative to the session start.
+  uint32_t Raw = static_cast<uint32_t>(Output.Timestamp);
+  if(Output.Channel == Capture::Channel::Session)
+  {
+    if(CaptureReader::mInSession)
+    {
+      CaptureReader::mSession++;
+    }
+    CaptureReader::mInSession = true;
+    CaptureReader::mSessionStart = Raw;
+    CaptureReader::mEpoch = 0;
+  }
+  else if(Raw < CaptureReader::mLastRaw)
+  {
+    // micros() wrapped.
+    CaptureReader::mEpoch += 0x100000000ULL;
+  }
+  CaptureReader::mLastRaw = Raw;
+  Output.Session = CaptureReader::mSession;
+  Output.Timestamp = CaptureReader::mEpoch + Raw - CaptureReader::mSessionStart;
+
+  return true;
+}
+size_t CaptureReader::BuildIndex()
+{
+  CaptureReader::mIndex.clear();
+  CaptureReader::Rewind();
+  Record Current;
+  while(CaptureReader::Next(Current))
+  {
+    Entry Indexed = {Current.Offset, Current.Timestamp, Current.Session};
+    CaptureReader::mIndex.push_back(Indexed);
+  }
+  CaptureReader::Rewind();
+  return CaptureReader::mIndex.size();
+}
+bool CaptureReader::At(size_t Index, Record& Output) const
+{
+  if(Index >= CaptureReader::mIndex.size() || !CaptureReader::Parse(CaptureReader::mIndex[Index].Offset, Output))
+  {
+    return false;
+  }
+  Output.Session = CaptureReader::mIndex[Index].Session;
+  Output.Timestamp = CaptureReader::mIndex[Index].Timestamp;
+  return true;
+}
+size_t CaptureReader::Seek(unsigned long Session, uint64_t Timestamp) const
+{
+  // Entries are sorted by session, then by time within the session.
+  Entry Key = {0, Timestamp, Session};
+  std::vector<Entry>::const_iterator Found = std::lower_bound(CaptureReader::mIndex.begin(), CaptureReader::mIndex.end(), Key,
+    [](const Entry& A, const Entry& B)
+    {
+      return A.Session < B.Session || (A.Session == B.Session && A.Timestamp < B.Timestamp);
+    });
+  return Found - CaptureReader::mIndex.begin();
+}
+
+// PROPERTIES
+size_t CaptureReader::pRecordCount() const
+{
+  return CaptureReader::mIndex.size();
+}
+uint64_t CaptureReader::pSize() const
+{
+  return CaptureReader::mSize;
+}
+bool CaptureReader::pTruncated() const
+{
+  return CaptureReader::mTruncated;
+}
+
+// PRIVATE METHODS
+bool CaptureReader::Parse(uint64_t Offset, Record& Output) const
+{
+  if(CaptureReader::mData == NULL || Offset + Capture::cRecordHeaderLength > CaptureReader::mSize)
+  {
+    return false;
+  }
+  const byte* Header = CaptureReader::mData + Offset;
+  unsigned int Length = SC::Deserialize<uint16_t>(Header, 6);
+  if(Offset + Capture::cRecordHeaderLength + Length > CaptureReader::mSize)
+  {
+    return false;
+  }
+  Output.Channel = static_cast<Capture::Channel>(Header[0]);
+  Output.Flags = Header[1];
+  Output.Session = 0;
+  Output.Timestamp = SC::Deserialize<uint32_t>(Header, 2);
+  Output.Offset = Offset;
+  Output.Frame = Header + Capture::cRecordHeaderLength;
+  Output.Length = Length;
+  return true;
+}
@@ -0,0 +1,128 @@
+/// \file CaptureReader.h
+/// \brief Defines the SC::CaptureReader class.
+#ifndef CAPTUREREADER_H
+#define CAPTUREREADER_H
+
+#include <Arduino.h>
+#include <Capture.h>
+
+#include <vector>
+
+namespace SC {
+
+///
+/// \brief Reads SC::Capture files on the host through a read-only memory map.
+/// \details Records are read in place from the mapping, so scanning a multi-GB capture costs one pass
+/// over the record headers and no copies.  An optional index of record offsets allows random access
+/// and timestamp seeks.
+///
+class CaptureReader
+{
+public:
+    ///
+    /// \brief A single record, pointing into the mapped file.
+    ///
+    struct Record
+    {
+        Capture::Channel Channel;   ///< The channel the frame was seen on.
+        byte Flags;                 ///< The record flags.  Reserved, currently always 0.
+        unsigned long Session;      ///< The index of the session the record belongs to, starting at 0.
+        uint64_t Timestamp;         ///< Microseconds since the start of the record's session, unwrapped.
+        uint64_t Offset;            ///< The offset of the record header within the file.
+        const byte* Frame;          ///< The raw frame bytes.  Valid until the reader is closed.
+        unsigned int Length;        ///< The length of the frame in bytes.
+    };
+
+    CaptureReader();
+    ~CaptureReader();
+
+    // METHODS
+    ///
+    /// \brief Open Maps a capture file for reading.
+    /// \param Path The path of the capture file.
+    /// \return TRUE if the file was opened and begins with a session record, otherwise FALSE.
+    ///
+    bool Open(const char* Path);
+    ///
+    /// \brief Close Unmaps the capture file and drops the index.
+    ///
+    void Close();
+    ///
+    /// \brief Rewind Restarts sequential reading from the first record.
+    ///
+    void Rewind();
+    ///
+    /// \brief Next Reads the next record sequentially.
+    /// \param Output The record to fill in.
+    /// \return TRUE if a record was read, FALSE at the end of the capture.
+    ///
+    bool Next(Record& Output);
+    ///
+    /// \brief BuildIndex Scans the whole capture and records the position of every record.
+    /// \return The number of records indexed.
+    ///
+    size_t BuildIndex();
+    ///
+    /// \brief At Reads an indexed record.
+    /// \param Index The index of the record, from 0 to pRecordCount() - 1.
+    /// \param Output The record to fill in.
+    /// \return TRUE if the record was read, FALSE if the index is out of range.
+    ///
+    bool At(size_t Index, Record& Output) const;
+    ///
+    /// \brief Seek Finds the first indexed record at or after a time.
+    /// \param Session The session to search within.
+    /// \param Timestamp The time within the session, in microseconds.
+    /// \return The index of the record, or pRecordCount() if there is none.
+    ///
+    size_t Seek(unsigned long Session, uint64_t Timestamp) const;
+
+    // PROPERTIES
+    ///
+    /// \brief pRecordCount PROPERTY Gets the number of indexed records.
+    ///
+    size_t pRecordCount() const;
+    ///
+    /// \brief pSize PROPERTY Gets the size of the mapped file in bytes.
+    ///
+    uint64_t pSize() const;
+    ///
+    /// \brief pTruncated PROPERTY Gets if the capture ends in a partially written record.
+    /// \details This is expected if the device lost power while writing.  The partial record is ignored.
+    ///
+    bool pTruncated() const;
+
+private:
+    ///
+    /// \brief An index entry.  Timestamps are kept here so seeks don't need to touch the file.
+    ///
+    struct Entry
+    {
+        uint64_t Offset;
+        uint64_t Timestamp;
+        unsigned long Session;
+    };
+
+    const byte* mData;
+    uint64_t mSize;
+    bool mTruncated;
+    std::vector<Entry> mIndex;
+
+    // Sequential read state.
+    uint64_t mPosition;
+    unsigned long mSession;
+    uint32_t mSessionStart;
+    uint32_t mLastRaw;
+    uint64_t mEpoch;
+    bool mInSession;
+
+    ///
+    /// \brief Parse Reads the record header at an offset.
+    /// \return TRUE if a complete record is present at the offset.
+    ///
+    bool Parse(uint64_t Offset, Record& Output) const;
+};
+
+}
+
+#endif // CAPTUREREADER_H
@@ -0,0 +1,200 @@
+#include "FrameDecoder.h"
+
+#include <utility/Serialization.h>
+
+#include <stdio.h>
+
+using namespace SC;
+
+bool SC::DecodeSCPacket(const byte* Frame, unsigned int Length, SCPacket& Output)
+{
+  // Header(1) + Sequence(4) + Receipt(1) + ID(2) + Priority(1) + DataLength(2) + Checksum(1)
+  if(Length < 12 || Frame[0] != 0xAA)
+  {
+    return false;
+  }
+  Output.Sequence = SC::Deserialize<uint32_t>(Frame, 1);
+  Output.Receipt = Frame[5];
+  Output.ID = SC::Deserialize<uint16_t>(Frame, 6);
+  Output.Priority = Frame[8];
+  Output.DataLength = SC::Deserialize<uint16_t>(Frame, 9);
+  if(Length != 12u + Output.DataLength)
+  {
+    return false;
+  }
+  Output.Data = Frame + 11;
+
+  byte Checksum = 0;
+  for(unsigned int i = 0; i < Length - 1; i++)
+  {
+    Checksum ^= Frame[i];
+  }
+  Output.ChecksumOK = Checksum == Frame[Length - 1];
+  return true;
+}
+
+bool SC::DecodeXBeeFrame(const byte* Frame, unsigned int Length, XBeeFrame& Output)
+{
+  // Delimiter(1) + Length(2) + Type(1) + Checksum(1)
+  if(Length < 5 || Frame[0] != 0x7E || SC::Deserialize<uint16_t>(Frame, 1) + 4u != Length)
+  {
+    return false;
+  }
+
+  byte Sum = 0;
+  for(unsigned int i = 3; i < Length; i++)
+  {
+    Sum += Frame[i];
+  }
+  Output.ChecksumOK = Sum == 0xFF;
+
+  const byte* Body = Frame + 3;
+  unsigned int BodyLength = Length - 4;
+  Output.Type = Body[0];
+  Output.FrameID = 0;
+  Output.Address = 0;
+  Output.Command[0] = Output.Command[1] = Output.Command[2] = 0;
+  Output.Status = 0;
+  Output.Data = Body + 1;
+  Output.DataLength = BodyLength - 1;
+
+  // Fixed-position fields for the frame types the e-stop uses.
+  unsigned int Header = 0;
+  switch(Output.Type)
+  {
+  case 0x08:  // AT Command: ID, Command
+  case 0x09:  // AT Command Queue: ID, Command
+    Header = 4;
+    break;
+  case 0x88:  // AT Response: ID, Command, Status
+    Header = 5;
+    break;
+  case 0x17:  // Remote AT Command: ID, Address64, Address16, Options, Command
+    Header = 15;
+    break;
+  case 0x97:  // Remote AT Response: ID, Address64, Address16, Command, Status
+    Header = 15;
+    break;
+  case 0x00:  // TX Request (64-bit): ID, Address64, Options
+    Header = 11;
+    break;
+  case 0x89:  // TX Status: ID, Status
+    Header = 3;
+    break;
+  default:
+    return true;
+  }
+  if(BodyLength < Header)
+  {
+    return false;
+  }
+  Output.FrameID = Body[1];
+  switch(Output.Type)
+  {
+  case 0x08:
+  case 0x09:
+    Output.Command[0] = Body[2];
+    Output.Command[1] = Body[3];
+    break;
+  case 0x88:
+    Output.Command[0] = Body[2];
+    Output.Command[1] = Body[3];
+    Output.Status = Body[4];
+    break;
+  case 0x17:
+    Output.Address = SC::Deserialize<uint64_t>(Body, 2);
+    Output.Command[0] = Body[13];
+    Output.Command[1] = Body[14];
+    break;
+  case 0x97:
+    Output.Address = SC::Deserialize<uint64_t>(Body, 2);
+    Output.Command[0] = Body[12];
+    Output.Command[1] = Body[13];
+    Output.Status = Body[14];
+    break;
+  case 0x00:
+    Output.Address = SC::Deserialize<uint64_t>(Body, 2);
+    break;
+  case 0x89:
+    Output.Status = Body[2];
+    break;
+  }
+  Output.Data = Body + Header;
+  Output.DataLength = BodyLength - Header;
+  return true;
+}
+
+const char* SC::ChannelName(Capture::Channel Channel)
+{
+  switch(Channel)
+  {
+  case Capture::Channel::Session:
+    return "SESSION";
+  case Capture::Channel::SCTX:
+    return "SC-TX";
+  case Capture::Channel::SCRX:
+    return "SC-RX";
+  case Capture::Channel::XBeeTX:
+    return "XB-TX";
+  case Capture::Channel::XBeeRX:
+    return "XB-RX";
+  }
+  return "UNKNOWN";
+}
+
+std::string SC::Describe(Capture::Channel Channel, const byte* Frame, unsigned int Length)
+{
+  char Line[256];
+  switch(Channel)
+  {
+  case Capture::Channel::Session:
+    snprintf(Line, sizeof(Line), "capture format v%u", Length >= 5 ? Frame[4] : 0);
+    break;
+  case Capture::Channel::SCTX:
+  case Capture::Channel::SCRX:
+    {
+      SCPacket Packet;
+      if(!SC::DecodeSCPacket(Frame, Length, Packet))
+      {
+        snprintf(Line, sizeof(Line), "malformed SC packet (%u bytes)", Length);
+        break;
+      }
+      static const char* const Receipts[] = {"none", "required", "received", "checksum-mismatch"};
+      snprintf(Line, sizeof(Line), "seq=%lu receipt=%s id=0x%04X pri=%u len=%u%s",
+               static_cast<unsigned long>(Packet.Sequence),
+               Packet.Receipt < 4 ? Receipts[Packet.Receipt] : "?",
+               Packet.ID, Packet.Priority, Packet.DataLength,
+               Packet.ChecksumOK ? "" : " BAD-CHECKSUM");
+    }
+    break;
+  case Capture::Channel::XBeeTX:
+  case Capture::Channel::XBeeRX:
+    {
+      XBeeFrame Decoded;
+      if(!SC::DecodeXBeeFrame(Frame, Length, Decoded))
+      {
+        snprintf(Line, sizeof(Line), "malformed XBee frame (%u bytes)", Length);
+        break;
+      }
+      int Written = snprintf(Line, sizeof(Line), "type=0x%02X id=%u", Decoded.Type, Decoded.FrameID);
+      if(Decoded.Address != 0)
+      {
+        Written += snprintf(Line + Written, sizeof(Line) - Written, " addr=%016llX", static_cast<unsigned long long>(Decoded.Address));
+      }
+      if(Decoded.Command[0] != 0)
+      {
+        Written += snprintf(Line + Written, sizeof(Line) - Written, " cmd=%s", Decoded.Command);
+      }
+      if(Decoded.Type == 0x88 || Decoded.Type == 0x97 || Decoded.Type == 0x89)
+      {
+        Written += snprintf(Line + Written, sizeof(Line) - Written, " status=%u", Decoded.Status);
+      }
+      snprintf(Line + Written, sizeof(Line) - Written, " data=%u%s", Decoded.DataLength, Decoded.ChecksumOK ? "" : " BAD-CHECKSUM");
+    }
+    break;
+  default:
+    snprintf(Line, sizeof(Line), "unknown channel (%u bytes)", Length);
+    break;
+  }
+  return std::string(Line);
+}
@@ -0,0 +1,73 @@
+/// \file FrameDecoder.h
+/// \brief Defines decoders for the raw frames stored in SC::Capture files.
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <Arduino.h>
+#include <Capture.h>
+
+#include <string>
+
+namespace SC {
+
+///
+/// \brief The fields of a decoded SC::Communicator packet.
+///
+struct SCPacket
+{
+    uint32_t Sequence;          ///< The sender's sequence number.
+    byte Receipt;               ///< The raw receipt field (0 = not required, 1 = required, 2 = received, 3 = checksum mismatch).
+    uint16_t ID;                ///< The message ID.
+    byte Priority;              ///< The message priority.
+    uint16_t DataLength;        ///< The number of data bytes in the message.
+    const byte* Data;           ///< The message data.
+    bool ChecksumOK;            ///< TRUE if the packet's XOR checksum matches.
+};
+
+///
+/// \brief The fields of a decoded XBee API frame.
+///
+struct XBeeFrame
+{
+    byte Type;                  ///< The API frame type.
+    byte FrameID;               ///< The frame ID, for frame types that carry one.
+    uint64_t Address;           ///< The 64-bit address, for frame types that carry one.
+    char Command[3];            ///< The AT command, for AT frame types.  NUL terminated.
+    byte Status;                ///< The command status, for response frame types.
+    const byte* Data;           ///< The parameter or payload bytes.
+    unsigned int DataLength;    ///< The number of parameter or payload bytes.
+    bool ChecksumOK;            ///< TRUE if the frame's checksum matches.
+};
+
+///
+/// \brief DecodeSCPacket Decodes an unescaped SC::Communicator packet.
+/// \param Frame The packet, starting with the header byte.
+/// \param Length The length of the packet.
+/// \param Output The decoded fields.
+/// \return TRUE if the packet is complete and well formed, otherwise FALSE.
+///
+bool DecodeSCPacket(const byte* Frame, unsigned int Length, SCPacket& Output);
+///
+/// \brief DecodeXBeeFrame Decodes an unescaped XBee API frame.
+/// \param Frame The frame, starting with the 0x7E delimiter.
+/// \param Length The length of the frame.
+/// \param Output The decoded fields.
+/// \return TRUE if the frame is complete and well formed, otherwise FALSE.
+///
+bool DecodeXBeeFrame(const byte* Frame, unsigned int Length, XBeeFrame& Output);
+///
+/// \brief ChannelName Gets a short printable name for a capture channel.
+///
+const char* ChannelName(Capture::Channel Channel);
+///
+/// \brief Describe Decodes a captured frame into a single printable line.
+/// \param Channel The channel the frame was captured on.
+/// \param Frame The raw frame.
+/// \param Length The length of the frame.
+/// \return A human readable description of the frame.
+///
+std::string Describe(Capture::Channel Channel, const byte* Frame, unsigned int Length);
+
+}
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,138 @@
+#include "ReplayStream.h"
+
+using namespace SC;
+
+ReplayStream::ReplayStream(CaptureReader& Reader, Capture::Channel Source, bool Paced)
+{
+  ReplayStream::mReader = &Reader;
+  ReplayStream::mSource = Source;
+  ReplayStream::mPaced = Paced;
+  ReplayStream::mEnded = false;
+  ReplayStream::mStarted = false;
+  ReplayStream::mClockStart = 0;
+  ReplayStream::mCaptureStart = 0;
+  ReplayStream::mPendingPosition = 0;
+  ReplayStream::mHaveNext = false;
+  ReplayStream::mPackets = 0;
+  ReplayStream::mBytes = 0;
+  ReplayStream::mWritten = 0;
+}
+
+// STREAM
+int ReplayStream::available()
+{
+  ReplayStream::Fill();
+  return static_cast<int>(ReplayStream::mPending.size() - ReplayStream::mPendingPosition);
+}
+int ReplayStream::read()
+{
+  ReplayStream::Fill();
+  if(ReplayStream::mPendingPosition >= ReplayStream::mPending.size())
+  {
+    return -1;
+  }
+  ReplayStream::mBytes++;
+  return ReplayStream::mPending[ReplayStream::mPendingPosition++];
+}
+int ReplayStream::peek()
+{
+  ReplayStream::Fill();
+  if(ReplayStream::mPendingPosition >= ReplayStream::mPending.size())
+  {
+    return -1;
+  }
+  return ReplayStream::mPending[ReplayStream::mPendingPosition];
+}
+size_t ReplayStream::write(uint8_t)
+{
+  ReplayStream::mWritten++;
+  return 1;
+}
+size_t ReplayStream::write(const uint8_t*, size_t Size)
+{
+  ReplayStream::mWritten += Size;
+  return Size;
+}
+int ReplayStream::availableForWrite()
+{
+  // Writes are discarded, so there is always room.
+  return 0x7FFF;
+}
+
+// PROPERTIES
+bool ReplayStream::pFinished()
+{
+  ReplayStream::Fill();
+  return ReplayStream::mEnded && !ReplayStream::mHaveNext && ReplayStream::mPendingPosition >= ReplayStream::mPending.size();
+}
+unsigned long ReplayStream::pPacketsReplayed() const
+{
+  return ReplayStream::mPackets;
+}
+unsigned long long ReplayStream::pBytesReplayed() const
+{
+  return ReplayStream::mBytes;
+}
+unsigned long long ReplayStream::pBytesWritten() const
+{
+  return ReplayStream::mWritten;
+}
+
+// PRIVATE METHODS
+void ReplayStream::Fill()
+{
+  if(ReplayStream::mPendingPosition < ReplayStream::mPending.size())
+  {
+    return;
+  }
+
+  // Find the next record on the replayed channel.
+  while(!ReplayStream::mHaveNext && !ReplayStream::mEnded)
+  {
+    if(!ReplayStream::mReader->Next(ReplayStream::mNext))
+    {
+      ReplayStream::mEnded = true;
+    }
+    else if(ReplayStream::mNext.Channel == ReplayStream::mSource && ReplayStream::mNext.Length > 0)
+    {
+      ReplayStream::mHaveNext = true;
+    }
+  }
+  if(!ReplayStream::mHaveNext)
+  {
+    return;
+  }
+
+  // Hold the record back until its time has come.
+  uint64_t Now = host::now_micros();
+  if(!ReplayStream::mStarted)
+  {
+    ReplayStream::mStarted = true;
+    ReplayStream::mClockStart = Now;
+    ReplayStream::mCaptureStart = ReplayStream::mNext.Timestamp;
+  }
+  if(ReplayStream::mPaced && Now - ReplayStream::mClockStart < ReplayStream::mNext.Timestamp - ReplayStream::mCaptureStart)
+  {
+    return;
+  }
+
+  // Re-escape the packet exactly as SC::Communicator::TX would have put it on the wire.
+  const byte* Frame = ReplayStream::mNext.Frame;
+  ReplayStream::mPending.clear();
+  ReplayStream::mPendingPosition = 0;
+  ReplayStream::mPending.push_back(Frame[0]);
+  for(unsigned int i = 1; i < ReplayStream::mNext.Length; i++)
+  {
+    if(Frame[i] == 0xAA || Frame[i] == 0x1B)
+    {
+      ReplayStream::mPending.push_back(0x1B);
+      ReplayStream::mPending.push_back(Frame[i] - 1);
+    }
+    else
+    {
+      ReplayStream::mPending.push_back(Frame[i]);
+    }
+  }
+  ReplayStream::mHaveNext = false;
+  ReplayStream::mPackets++;
+}
@@ -0,0 +1,88 @@
+/// \file ReplayStream.h
+/// \brief Defines the SC::ReplayStream class.
+#ifndef REPLAYSTREAM_H
+#define REPLAYSTREAM_H
+
+#include "CaptureReader.h"
+
+#include <vector>
+
+namespace SC {
+
+///
+/// \brief A Stream that plays the SC packets of one capture channel back as escaped serial bytes.
+/// \details Hand this to an SC::Communicator in place of a serial port to replay what a device received
+/// (Capture::Channel::SCRX) or sent (Capture::Channel::SCTX).  Anything the Communicator writes, such as
+/// receipts, is counted and discarded.
+///
+/// When paced, a record only becomes readable once host::now_micros() has reached the record's timestamp
+/// relative to the first replayed record, so the Communicator sees the original timing.  Use with the
+/// virtual clock for deterministic replays.  When not paced, records are served as fast as they are read.
+///
+class ReplayStream : public Stream
+{
+public:
+    ///
+    /// \brief ReplayStream Creates a new replay.
+    /// \param Reader An open capture reader.  Sequential reading starts from its current position.
+    /// \param Source The channel whose packets are replayed.
+    /// \param Paced TRUE to release records at their captured times, FALSE to release them immediately.
+    ///
+    ReplayStream(CaptureReader& Reader, Capture::Channel Source, bool Paced);
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+    size_t write(const uint8_t* Buffer, size_t Size) override;
+    int availableForWrite() override;
+
+    // PROPERTIES
+    ///
+    /// \brief pFinished PROPERTY Gets if every record has been read out.
+    ///
+    bool pFinished();
+    ///
+    /// \brief pPacketsReplayed PROPERTY Gets the number of packets released so far.
+    ///
+    unsigned long pPacketsReplayed() const;
+    ///
+    /// \brief pBytesReplayed PROPERTY Gets the number of escaped bytes released so far.
+    ///
+    unsigned long long pBytesReplayed() const;
+    ///
+    /// \brief pBytesWritten PROPERTY Gets the number of bytes written back by the Communicator.
+    ///
+    unsigned long long pBytesWritten() const;
+
+private:
+    CaptureReader* mReader;
+    Capture::Channel mSource;
+    bool mPaced;
+    bool mEnded;
+    bool mStarted;
+    uint64_t mClockStart;
+    uint64_t mCaptureStart;
+
+    ///
+    /// \brief mPending Stores the escaped bytes of the record being served.
+    ///
+    std::vector<byte> mPending;
+    size_t mPendingPosition;
+    CaptureReader::Record mNext;
+    bool mHaveNext;
+
+    unsigned long mPackets;
+    unsigned long long mBytes;
+    unsigned long long mWritten;
+
+    ///
+    /// \brief Fill Loads the next due record into the pending buffer, if the current one is used up.
+    ///
+    void Fill();
+};
+
+}
+
+#endif // REPLAYSTREAM_H
@@ -0,0 +1,198 @@
+/// \file sccapture.cpp
+/// \brief Host tool for inspecting and replaying SC::Capture files.
+///
+/// Usage:
+///   sccapture stats  <capture>                       Index the capture and summarize it.
+///   sccapture dump   <capture> [first] [count]       Decode records, one per line.
+///   sccapture replay <capture> [scrx|sctx] [paced]   Replay SC packets into a Communicator.
+#include "CaptureReader.h"
+#include "FrameDecoder.h"
+#include "ReplayStream.h"
+
+#include <SerialCommunicator.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <map>
+
+using namespace SC;
+
+namespace {
+
+double seconds_now()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int stats(CaptureReader& reader)
+{
+  double start = seconds_now();
+  size_t records = reader.BuildIndex();
+  double elapsed = seconds_now() - start;
+
+  unsigned long long frames[5] = {0, 0, 0, 0, 0};
+  unsigned long long bytes[5] = {0, 0, 0, 0, 0};
+  unsigned long long malformed = 0;
+  unsigned long long bad_checksum = 0;
+  unsigned long sessions = 0;
+  CaptureReader::Record record;
+  while(reader.Next(record))
+  {
+    unsigned int channel = static_cast<unsigned int>(record.Channel);
+    if(channel < 5)
+    {
+      frames[channel]++;
+      bytes[channel] += record.Length;
+    }
+    switch(record.Channel)
+    {
+    case Capture::Channel::Session:
+      sessions++;
+      break;
+    case Capture::Channel::SCTX:
+    case Capture::Channel::SCRX:
+      {
+        SCPacket packet;
+        if(!DecodeSCPacket(record.Frame, record.Length, packet))
+        {
+          malformed++;
+        }
+        else if(!packet.ChecksumOK)
+        {
+          bad_checksum++;
+        }
+      }
+      break;
+    case Capture::Channel::XBeeTX:
+    case Capture::Channel::XBeeRX:
+      {
+        XBeeFrame frame;
+        if(!DecodeXBeeFrame(record.Frame, record.Length, frame))
+        {
+          malformed++;
+        }
+        else if(!frame.ChecksumOK)
+        {
+          bad_checksum++;
+        }
+      }
+      break;
+    }
+  }
+
+  printf("size:         %llu bytes\n", static_cast<unsigned long long>(reader.pSize()));
+  printf("records:      %zu\n", records);
+  printf("sessions:     %lu\n", sessions);
+  for(unsigned int i = 1; i < 5; i++)
+  {
+    printf("%-13s %llu frames, %llu bytes\n", (std::string(ChannelName(static_cast<Capture::Channel>(i))) + ":").c_str(), frames[i], bytes[i]);
+  }
+  printf("malformed:    %llu\n", malformed);
+  printf("bad checksum: %llu\n", bad_checksum);
+  printf("truncated:    %s\n", reader.pTruncated() ? "yes" : "no");
+  printf("index time:   %.3f s (%.1f MB/s)\n", elapsed, elapsed > 0 ? reader.pSize() / elapsed / 1e6 : 0.0);
+  return 0;
+}
+
+int dump(CaptureReader& reader, size_t first, size_t count)
+{
+  reader.BuildIndex();
+  CaptureReader::Record record;
+  for(size_t i = first; i < reader.pRecordCount() && i - first < count; i++)
+  {
+    reader.At(i, record);
+    printf("%zu s%lu %12.6f %-7s %s\n", i, record.Session, record.Timestamp * 1e-6,
+           ChannelName(record.Channel), Describe(record.Channel, record.Frame, record.Length).c_str());
+  }
+  return 0;
+}
+
+int replay(CaptureReader& reader, Capture::Channel source, bool paced)
+{
+  // Paced replays run on the virtual clock so they finish as fast as the host allows.
+  host::use_virtual_clock(paced);
+  ReplayStream stream(reader, source, paced);
+  Communicator communicator(stream);
+  communicator.pQueueSize(256);
+
+  std::map<unsigned int, unsigned long> received;
+  unsigned long total = 0;
+  double start = seconds_now();
+  while(!stream.pFinished() || communicator.MessagesAvailable() > 0)
+  {
+    communicator.Spin();
+    while(communicator.MessagesAvailable() > 0)
+    {
+      MessageHandle message = communicator.Receive();
+      received[message->pID()]++;
+      total++;
+    }
+    if(paced)
+    {
+      host::advance_micros(100);
+    }
+  }
+  double elapsed = seconds_now() - start;
+
+  printf("packets replayed:  %lu\n", stream.pPacketsReplayed());
+  printf("messages received: %lu\n", total);
+  for(std::map<unsigned int, unsigned long>::const_iterator i = received.begin(); i != received.end(); ++i)
+  {
+    printf("  id 0x%04X: %lu\n", i->first, i->second);
+  }
+  printf("bytes in/out:      %llu / %llu\n", stream.pBytesReplayed(), stream.pBytesWritten());
+  printf("wall time:         %.3f s (%.0f packets/s)\n", elapsed, elapsed > 0 ? stream.pPacketsReplayed() / elapsed : 0.0);
+  return 0;
+}
+
+int usage()
+{
+  fprintf(stderr,
+          "usage: sccapture stats  <capture>\n"
+          "       sccapture dump   <capture> [first] [count]\n"
+          "       sccapture replay <capture> [scrx|sctx] [paced]\n");
+  return 2;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  if(argc < 3)
+  {
+    return usage();
+  }
+  std::string command = argv[1];
+
+  CaptureReader reader;
+  if(!reader.Open(argv[2]))
+  {
+    fprintf(stderr, "sccapture: %s is not a readable capture\n", argv[2]);
+    return 1;
+  }
+
+  if(command == "stats")
+  {
+    return stats(reader);
+  }
+  if(command == "dump")
+  {
+    size_t first = argc > 3 ? strtoull(argv[3], NULL, 0) : 0;
+    size_t count = argc > 4 ? strtoull(argv[4], NULL, 0) : static_cast<size_t>(-1);
+    return dump(reader, first, count);
+  }
+  if(command == "replay")
+  {
+    Capture::Channel source = Capture::Channel::SCRX;
+    if(argc > 3 && std::string(argv[3]) == "sctx")
+    {
+      source = Capture::Channel::SCTX;
+    }
+    bool paced = argc > 4 && std::string(argv[4]) == "paced";
+    return replay(reader, source, paced);
+  }
+  return usage();
+}
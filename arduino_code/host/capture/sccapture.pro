@@ -0,0 +1,15 @@
+TEMPLATE = app
+TARGET = sccapture
+
+include(../host.pri)
+
+SOURCES += \
+    CaptureReader.cpp \
+    FrameDecoder.cpp \
+    ReplayStream.cpp \
+    sccapture.cpp
+
+HEADERS += \
+    CaptureReader.h \
+    FrameDecoder.h \
+    ReplayStream.h
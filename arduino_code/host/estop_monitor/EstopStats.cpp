@@ -0,0 +1,233 @@
+#include "EstopStats.h"
+
+#include <algorithm>
+
+using namespace Monitor;
+
+// LATENCYSUMMARY
+LatencySummary::LatencySummary()
+{
+  LatencySummary::mCount = 0;
+  LatencySummary::mSum = 0;
+  LatencySummary::mMin = 0;
+  LatencySummary::mMax = 0;
+  LatencySummary::mNext = 0;
+}
+void LatencySummary::Add(uint64_t Sample)
+{
+  if(LatencySummary::mCount == 0 || Sample < LatencySummary::mMin)
+  {
+    LatencySummary::mMin = Sample;
+  }
+  if(Sample > LatencySummary::mMax)
+  {
+    LatencySummary::mMax = Sample;
+  }
+  LatencySummary::mCount++;
+  LatencySummary::mSum += Sample;
+
+  // Keep a ring of the most recent samples.
+  if(LatencySummary::mRecent.size() < LatencySummary::cWindow)
+  {
+    LatencySummary::mRecent.push_back(Sample);
+  }
+  else
+  {
+    LatencySummary::mRecent[LatencySummary::mNext] = Sample;
+    LatencySummary::mNext = (LatencySummary::mNext + 1) % LatencySummary::cWindow;
+  }
+}
+uint64_t LatencySummary::Percentile(double Fraction) const
+{
+  if(LatencySummary::mRecent.empty())
+  {
+    return 0;
+  }
+  std::vector<uint64_t> sorted(LatencySummary::mRecent);
+  size_t index = static_cast<size_t>(Fraction * (sorted.size() - 1) + 0.5);
+  std::nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+  return sorted[index];
+}
+unsigned long LatencySummary::pCount() const
+{
+  return LatencySummary::mCount;
+}
+uint64_t LatencySummary::pMin() const
+{
+  return LatencySummary::mMin;
+}
+uint64_t LatencySummary::pMax() const
+{
+  return LatencySummary::mMax;
+}
+uint64_t LatencySummary::pMean() const
+{
+  return (LatencySummary::mCount == 0) ? 0 : LatencySummary::mSum / LatencySummary::mCount;
+}
+
+// ESTOPSTATS
+EstopStats::EstopStats(uint64_t ResponseWindow)
+{
+  EstopStats::mResponseWindow = ResponseWindow;
+}
+
+// EVENTS
+void EstopStats::Broadcast(const std::string& Transmitter, byte FrameID, uint64_t Time)
+{
+  TransmitterStats& transmitter = EstopStats::mTransmitters[Transmitter];
+  if(transmitter.Broadcasts > 0)
+  {
+    transmitter.Interval.Add(Time - transmitter.LastBroadcast);
+  }
+  transmitter.Broadcasts++;
+  transmitter.BroadcastID = FrameID;
+  transmitter.LastBroadcast = Time;
+}
+void EstopStats::Unicast(const std::string& Transmitter, uint64_t Address, byte FrameID, uint64_t Time)
+{
+  TransmitterStats& transmitter = EstopStats::mTransmitters[Transmitter];
+  RobotStats& robot = transmitter.Robots[Address];
+  robot.RetriesSent++;
+  if(FrameID != 0)
+  {
+    Retry& retry = transmitter.Retries[FrameID];
+    retry.Address = Address;
+    retry.Time = Time;
+  }
+}
+void EstopStats::Response(const std::string& Transmitter, uint64_t Address, byte FrameID, byte Status, uint64_t Time)
+{
+  TransmitterStats& transmitter = EstopStats::mTransmitters[Transmitter];
+
+  // An answer to a unicast retry?
+  std::map<byte, Retry>::iterator retry = transmitter.Retries.find(FrameID);
+  if(retry != transmitter.Retries.end() && retry->second.Address == Address)
+  {
+    RobotStats& robot = transmitter.Robots[Address];
+    robot.LastSeen = Time;
+    if(Status == 0x00)
+    {
+      robot.RetriesConfirmed++;
+      robot.Latency.Add(Time - retry->second.Time);
+      transmitter.RetryLatency.Add(Time - retry->second.Time);
+    }
+    else
+    {
+      robot.RetriesFailed++;
+    }
+    transmitter.Retries.erase(retry);
+    return;
+  }
+
+  // An answer to the latest broadcast?
+  if(transmitter.Broadcasts == 0 || FrameID != transmitter.BroadcastID || Time - transmitter.LastBroadcast > EstopStats::mResponseWindow)
+  {
+    transmitter.Unmatched++;
+    return;
+  }
+  std::map<uint64_t, RobotStats>::iterator found = transmitter.Robots.find(Address);
+  if(found == transmitter.Robots.end())
+  {
+    // A robot joins the census at the broadcast it first answers.
+    found = transmitter.Robots.insert(std::make_pair(Address, RobotStats())).first;
+    found->second.FirstBroadcast = transmitter.Broadcasts;
+  }
+  RobotStats& robot = found->second;
+  robot.LastSeen = Time;
+  if(Status != 0x00)
+  {
+    robot.ErrorResponses++;
+    return;
+  }
+  if(robot.FirstBroadcast == 0)
+  {
+    // Heard from first by a retry.
+    robot.FirstBroadcast = transmitter.Broadcasts;
+  }
+  if(robot.LastAnswered != transmitter.Broadcasts)
+  {
+    robot.LastAnswered = transmitter.Broadcasts;
+    robot.BroadcastsAnswered++;
+    robot.Latency.Add(Time - transmitter.LastBroadcast);
+    transmitter.BroadcastLatency.Add(Time - transmitter.LastBroadcast);
+  }
+}
+
+// METHODS
+void EstopStats::Report(FILE* Output, bool CSV, uint64_t Now) const
+{
+  if(CSV)
+  {
+    fprintf(Output, "transmitter,robot,broadcasts,answered,loss,retries,retries_confirmed,retries_failed,errors,p50_us,p90_us,p99_us,max_us,last_seen_s\n");
+  }
+  for(std::map<std::string, TransmitterStats>::const_iterator t = EstopStats::mTransmitters.begin(); t != EstopStats::mTransmitters.end(); ++t)
+  {
+    const TransmitterStats& transmitter = t->second;
+    if(CSV)
+    {
+      fprintf(Output, "%s,,%lu,%lu,,,,,%lu,%llu,%llu,%llu,%llu,\n", t->first.c_str(), transmitter.Broadcasts,
+              transmitter.BroadcastLatency.pCount(), transmitter.Unmatched,
+              static_cast<unsigned long long>(transmitter.BroadcastLatency.Percentile(0.5)),
+              static_cast<unsigned long long>(transmitter.BroadcastLatency.Percentile(0.9)),
+              static_cast<unsigned long long>(transmitter.BroadcastLatency.Percentile(0.99)),
+              static_cast<unsigned long long>(transmitter.BroadcastLatency.pMax()));
+    }
+    else
+    {
+      fprintf(Output, "transmitter %s: %lu broadcasts, %zu robots, %lu unmatched responses\n", t->first.c_str(),
+              transmitter.Broadcasts, transmitter.Robots.size(), transmitter.Unmatched);
+      fprintf(Output, "  interval:  mean %.1f ms, min %.1f ms, max %.1f ms\n", transmitter.Interval.pMean() / 1000.0,
+              transmitter.Interval.pMin() / 1000.0, transmitter.Interval.pMax() / 1000.0);
+      fprintf(Output, "  broadcast: %lu responses, p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n",
+              transmitter.BroadcastLatency.pCount(), transmitter.BroadcastLatency.Percentile(0.5) / 1000.0,
+              transmitter.BroadcastLatency.Percentile(0.9) / 1000.0, transmitter.BroadcastLatency.Percentile(0.99) / 1000.0,
+              transmitter.BroadcastLatency.pMax() / 1000.0);
+      fprintf(Output, "  retry:     %lu responses, p50 %.1f ms, p90 %.1f ms, max %.1f ms\n",
+              transmitter.RetryLatency.pCount(), transmitter.RetryLatency.Percentile(0.5) / 1000.0,
+              transmitter.RetryLatency.Percentile(0.9) / 1000.0, transmitter.RetryLatency.pMax() / 1000.0);
+    }
+
+    for(std::map<uint64_t, RobotStats>::const_iterator r = transmitter.Robots.begin(); r != transmitter.Robots.end(); ++r)
+    {
+      const RobotStats& robot = r->second;
+      unsigned long expected = EstopStats::Expected(transmitter, robot, Now);
+      double loss = (expected == 0) ? 0.0 : 1.0 - static_cast<double>(std::min(robot.BroadcastsAnswered, expected)) / expected;
+      double last_seen = (Now - robot.LastSeen) / 1e6;
+      if(CSV)
+      {
+        fprintf(Output, "%s,%016llX,%lu,%lu,%.4f,%lu,%lu,%lu,%lu,%llu,%llu,%llu,%llu,%.3f\n", t->first.c_str(),
+                static_cast<unsigned long long>(r->first), expected, robot.BroadcastsAnswered, loss, robot.RetriesSent,
+                robot.RetriesConfirmed, robot.RetriesFailed, robot.ErrorResponses,
+                static_cast<unsigned long long>(robot.Latency.Percentile(0.5)),
+                static_cast<unsigned long long>(robot.Latency.Percentile(0.9)),
+                static_cast<unsigned long long>(robot.Latency.Percentile(0.99)),
+                static_cast<unsigned long long>(robot.Latency.pMax()), last_seen);
+      }
+      else
+      {
+        fprintf(Output, "  robot %016llX: answered %lu/%lu (%.1f%% loss), retries %lu sent, %lu ok, %lu failed, "
+                "p50 %.1f ms, p90 %.1f ms, max %.1f ms, last seen %.1f s ago\n",
+                static_cast<unsigned long long>(r->first), robot.BroadcastsAnswered, expected, loss * 100.0,
+                robot.RetriesSent, robot.RetriesConfirmed, robot.RetriesFailed, robot.Latency.Percentile(0.5) / 1000.0,
+                robot.Latency.Percentile(0.9) / 1000.0, robot.Latency.pMax() / 1000.0, last_seen);
+      }
+    }
+  }
+  fflush(Output);
+}
+
+// PRIVATE METHODS
+unsigned long EstopStats::Expected(const TransmitterStats& Transmitter, const RobotStats& Robot, uint64_t Now) const
+{
+  if(Robot.FirstBroadcast == 0)
+  {
+    return 0;
+  }
+  unsigned long expected = Transmitter.Broadcasts - Robot.FirstBroadcast + 1;
+  // The latest broadcast doesn't count against a robot until its window has closed.
+  if(Robot.LastAnswered != Transmitter.Broadcasts && Now - Transmitter.LastBroadcast <= EstopStats::mResponseWindow)
+  {
+    expected--;
+  }
+  return expected;
+}
@@ -0,0 +1,131 @@
+/// \file EstopStats.h
+/// \brief Defines the Monitor::EstopStats class.
+#ifndef ESTOPSTATS_H
+#define ESTOPSTATS_H
+
+#include <Arduino.h>
+
+#include <map>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace Monitor {
+
+///
+/// \brief Summarizes a series of latencies, keeping the most recent samples for percentiles.
+///
+class LatencySummary
+{
+public:
+    LatencySummary();
+
+    ///
+    /// \brief Add Adds a sample, in microseconds.
+    ///
+    void Add(uint64_t Sample);
+    ///
+    /// \brief Percentile Gets a percentile of the recent samples.
+    /// \param Fraction The percentile, from 0 to 1.
+    /// \return The percentile in microseconds, or 0 if there are no samples.
+    ///
+    uint64_t Percentile(double Fraction) const;
+
+    unsigned long pCount() const;
+    uint64_t pMin() const;
+    uint64_t pMax() const;
+    uint64_t pMean() const;
+
+private:
+    ///
+    /// \brief cWindow The number of recent samples kept for percentiles.
+    ///
+    static const size_t cWindow = 1024;
+
+    unsigned long mCount;
+    uint64_t mSum;
+    uint64_t mMin;
+    uint64_t mMax;
+    std::vector<uint64_t> mRecent;
+    size_t mNext;
+};
+
+///
+/// \brief Tracks e-stop traffic and works out per-transmitter and per-robot latency and loss.
+/// \details Transmitters are identified by name, robots by the 64 bit address of their radio.  A robot's response
+/// to the e-stop broadcast is matched with its transmitter's latest broadcast, and a response to a unicast retry
+/// with the retry that carried its frame ID.  A robot is expected to answer every broadcast from the first one it
+/// answers, so its loss is the fraction of those broadcasts that it didn't answer within the response window.
+///
+class EstopStats
+{
+public:
+    ///
+    /// \brief EstopStats Creates an empty set of statistics.
+    /// \param ResponseWindow How long after a broadcast a response still counts as answering it, in microseconds.
+    ///
+    EstopStats(uint64_t ResponseWindow);
+
+    // EVENTS
+    ///
+    /// \brief Broadcast Records an e-stop broadcast (remote AT D1 = 5 to the broadcast address).
+    ///
+    void Broadcast(const std::string& Transmitter, byte FrameID, uint64_t Time);
+    ///
+    /// \brief Unicast Records an e-stop sent to a single robot (remote AT D1 = 5 to its address).
+    ///
+    void Unicast(const std::string& Transmitter, uint64_t Address, byte FrameID, uint64_t Time);
+    ///
+    /// \brief Response Records a robot's remote AT response to D1.
+    ///
+    void Response(const std::string& Transmitter, uint64_t Address, byte FrameID, byte Status, uint64_t Time);
+
+    // METHODS
+    ///
+    /// \brief Report Writes the statistics.
+    /// \param Output The file to write to.
+    /// \param CSV TRUE for CSV, one row per transmitter and robot, FALSE for text.
+    /// \param Now The current time, from host::now_micros().
+    ///
+    void Report(FILE* Output, bool CSV, uint64_t Now) const;
+
+private:
+    struct RobotStats
+    {
+        unsigned long FirstBroadcast;
+        unsigned long BroadcastsAnswered;
+        unsigned long LastAnswered;
+        unsigned long RetriesSent;
+        unsigned long RetriesConfirmed;
+        unsigned long RetriesFailed;
+        unsigned long ErrorResponses;
+        uint64_t LastSeen;
+        LatencySummary Latency;
+    };
+    struct Retry
+    {
+        uint64_t Address;
+        uint64_t Time;
+    };
+    struct TransmitterStats
+    {
+        unsigned long Broadcasts;
+        byte BroadcastID;
+        uint64_t LastBroadcast;
+        unsigned long Unmatched;
+        LatencySummary Interval;
+        LatencySummary BroadcastLatency;
+        LatencySummary RetryLatency;
+        std::map<byte, Retry> Retries;
+        std::map<uint64_t, RobotStats> Robots;
+    };
+
+    uint64_t mResponseWindow;
+    std::map<std::string, TransmitterStats> mTransmitters;
+
+    unsigned long Expected(const TransmitterStats& Transmitter, const RobotStats& Robot, uint64_t Now) const;
+};
+
+}
+
+#endif // ESTOPSTATS_H
@@ -0,0 +1,233 @@
+#include "Radio.h"
+
+#include <FrameDecoder.h>
+
+using namespace Monitor;
+
+namespace {
+
+const uint64_t broadcast_address = 0x000000000000FFFFULL;
+const unsigned int latency_report_id = 0x1003;
+const char* const latency_stage_names[] = {"switch to state", "state to send", "send to drain", "total"};
+
+// The upper bound, in microseconds, of a latency histogram bucket (see estop::latency_probe::bucket_count).
+unsigned long bucket_limit(size_t Bucket)
+{
+  return 16UL << Bucket;
+}
+
+// The upper bound of the bucket holding the given fraction of a stage's times.  The last bucket is open, so is bounded by the maximum.
+unsigned long bucket_percentile(const std::vector<unsigned int>& Buckets, unsigned int Count, unsigned long Max, double Fraction)
+{
+  unsigned long seen = 0;
+  for(size_t i = 0; i < Buckets.size(); i++)
+  {
+    seen += Buckets[i];
+    if(seen > 0 && seen >= Fraction * Count)
+    {
+      return (i + 1 == Buckets.size()) ? Max : bucket_limit(i);
+    }
+  }
+  return 0;
+}
+
+}
+
+Radio::Radio(const std::string& Transmitter, Kind Type, estop::xbee_parser::api_mode Mode)
+  : mParser(Mode)
+{
+  Radio::mTransmitter = Transmitter;
+  Radio::mType = Type;
+  Radio::mFrames = 0;
+  Radio::mBadChecksums = 0;
+  Radio::mBytesSkipped = 0;
+  Radio::mLatencyReceived = false;
+  Radio::mLatencyEnabled = false;
+  Radio::mLatencyAbandoned = 0;
+}
+
+// METHODS
+bool Radio::Open(const std::string& Path, unsigned long Baud)
+{
+  if(!Radio::mPort.Open(Path, Baud))
+  {
+    return false;
+  }
+  if(Radio::mType == Kind::SC)
+  {
+    Radio::mCommunicator.reset(new SC::Communicator(Radio::mPort));
+    Radio::mCommunicator->pQueueSize(256);
+  }
+  return true;
+}
+bool Radio::Service(EstopStats& Stats, FILE* Events)
+{
+  long count = Radio::mPort.Fill();
+  // Everything read in one go gets the same timestamp: the time it was read.
+  uint64_t time = Radio::mPort.pLastFill();
+
+  if(Radio::mType == Kind::SC)
+  {
+    Radio::mCommunicator->Spin();
+    while(Radio::mCommunicator->MessagesAvailable() > 0)
+    {
+      SC::MessageHandle message = Radio::mCommunicator->Receive();
+      Radio::mFrames++;
+      Radio::mCounts[message->pID()]++;
+      if(message->pID() == latency_report_id)
+      {
+        Radio::HandleLatencyReport(*message.pMessage());
+      }
+      if(Events)
+      {
+        fprintf(Events, "%.6f %s SC id=0x%04X length=%u\n", time * 1e-6, Radio::mTransmitter.c_str(), message->pID(), message->pDataLength());
+      }
+    }
+  }
+  else
+  {
+    while(Radio::mPort.available() > 0)
+    {
+      estop::xbee_parser::result result = Radio::mParser.parse(static_cast<uint8_t>(Radio::mPort.read()));
+      if(result == estop::xbee_parser::result::frame)
+      {
+        Radio::HandleFrame(Stats, Events, time);
+      }
+      else if(result == estop::xbee_parser::result::bad_checksum)
+      {
+        Radio::mBadChecksums++;
+      }
+    }
+  }
+  return count >= 0;
+}
+void Radio::Report(FILE* Output) const
+{
+  fprintf(Output, "port %s (%s, %s): %llu bytes, %lu %s", Radio::mPort.pPath().c_str(), Radio::mTransmitter.c_str(),
+          (Radio::mType == Kind::SC) ? "sc" : "xbee", Radio::mPort.pBytesRead(), Radio::mFrames,
+          (Radio::mType == Kind::SC) ? "messages" : "frames");
+  if(Radio::mType == Kind::XBee)
+  {
+    fprintf(Output, ", %lu bad checksums, %u too long", Radio::mBadChecksums, Radio::mParser.skipped());
+  }
+  for(std::map<unsigned int, unsigned long>::const_iterator i = Radio::mCounts.begin(); i != Radio::mCounts.end(); ++i)
+  {
+    fprintf(Output, ", 0x%0*X: %lu", (Radio::mType == Kind::SC) ? 4 : 2, i->first, i->second);
+  }
+  fprintf(Output, "\n");
+  Radio::ReportLatency(Output);
+}
+void Radio::RequestLatencyReport()
+{
+  if(Radio::mType != Kind::SC || !Radio::mCommunicator)
+  {
+    return;
+  }
+  Radio::mCommunicator->Send(SC::Message(latency_report_id));
+  Radio::mCommunicator->Spin();
+}
+
+// PROPERTIES
+SerialPort& Radio::pPort()
+{
+  return Radio::mPort;
+}
+const std::string& Radio::pTransmitter() const
+{
+  return Radio::mTransmitter;
+}
+
+// PRIVATE METHODS
+void Radio::HandleFrame(EstopStats& Stats, FILE* Events, uint64_t Time)
+{
+  SC::XBeeFrame frame;
+  if(!SC::DecodeXBeeFrame(Radio::mParser.frame(), Radio::mParser.length(), frame))
+  {
+    return;
+  }
+  Radio::mFrames++;
+  Radio::mCounts[frame.Type]++;
+
+  bool d1 = (frame.Command[0] == 'D' && frame.Command[1] == '1');
+  if(frame.Type == 0x17 && d1 && frame.DataLength == 1 && frame.Data[0] == 0x05)
+  {
+    if(frame.Address == broadcast_address)
+    {
+      Stats.Broadcast(Radio::mTransmitter, frame.FrameID, Time);
+    }
+    else
+    {
+      Stats.Unicast(Radio::mTransmitter, frame.Address, frame.FrameID, Time);
+    }
+  }
+  else if(frame.Type == 0x97 && d1)
+  {
+    Stats.Response(Radio::mTransmitter, frame.Address, frame.FrameID, frame.Status, Time);
+  }
+
+  if(Events)
+  {
+    fprintf(Events, "%.6f %s %s\n", Time * 1e-6, Radio::mTransmitter.c_str(),
+            SC::Describe(SC::Capture::Channel::XBeeRX, Radio::mParser.frame(), Radio::mParser.length()).c_str());
+  }
+}
+void Radio::HandleLatencyReport(const SC::Message& Message)
+{
+  // One message per stage, each with the header: enabled (1), stage count (1), bucket count (1), abandoned (2).  Then
+  // the stage (1), its count (2), min (4), max (4), and a count (2) per bucket.  Without probes, just the header.
+  unsigned int length = Message.pDataLength();
+  if(length < 5)
+  {
+    return;
+  }
+  unsigned int stages = Message.GetData<uint8_t>(1);
+  unsigned int buckets = Message.GetData<uint8_t>(2);
+
+  Radio::mLatencyReceived = true;
+  Radio::mLatencyEnabled = Message.GetData<uint8_t>(0) != 0;
+  Radio::mLatencyAbandoned = Message.GetData<uint16_t>(3);
+  if(Radio::mLatency.size() != stages)
+  {
+    Radio::mLatency.assign(stages, LatencyStage());
+  }
+  if(stages == 0 || length < 16 + 2 * buckets)
+  {
+    return;
+  }
+  unsigned int s = Message.GetData<uint8_t>(5);
+  if(s >= stages)
+  {
+    return;
+  }
+
+  LatencyStage& stage = Radio::mLatency[s];
+  stage.Count = Message.GetData<uint16_t>(6);
+  stage.Min = Message.GetData<uint32_t>(8);
+  stage.Max = Message.GetData<uint32_t>(12);
+  stage.Buckets.clear();
+  for(unsigned int b = 0; b < buckets; b++)
+  {
+    stage.Buckets.push_back(Message.GetData<uint16_t>(16 + 2 * b));
+  }
+}
+void Radio::ReportLatency(FILE* Output) const
+{
+  if(!Radio::mLatencyReceived)
+  {
+    return;
+  }
+  if(!Radio::mLatencyEnabled)
+  {
+    fprintf(Output, "  latency probes: not built in (ESTOP_LATENCY_PROBES)\n");
+    return;
+  }
+  fprintf(Output, "  latency probes: %u abandoned\n", Radio::mLatencyAbandoned);
+  for(size_t s = 0; s < Radio::mLatency.size(); s++)
+  {
+    const LatencyStage& stage = Radio::mLatency[s];
+    const char* name = (s < sizeof(latency_stage_names) / sizeof(latency_stage_names[0])) ? latency_stage_names[s] : "?";
+    fprintf(Output, "    %-16s %u, min %lu us, max %lu us, p50 <= %lu us, p99 <= %lu us\n", name, stage.Count,
+            stage.Min, stage.Max, bucket_percentile(stage.Buckets, stage.Count, stage.Max, 0.5),
+            bucket_percentile(stage.Buckets, stage.Count, stage.Max, 0.99));
+  }
+}
@@ -0,0 +1,114 @@
+/// \file Radio.h
+/// \brief Defines the Monitor::Radio class.
+#ifndef RADIO_H
+#define RADIO_H
+
+#include "EstopStats.h"
+#include "SerialPort.h"
+
+#include <Communicator.h>
+#include <xbee_parser.h>
+
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace Monitor {
+
+///
+/// \brief A port being monitored, and what has been decoded from it.
+/// \details An XBee port carries XBee API frames: a tap on either line of a transmitter's XBee UART, or the
+/// transmitter's USB port in forwarding mode.  Frames are split out with estop::xbee_parser, and e-stop traffic is
+/// passed on to the EstopStats under the port's transmitter name.  Taps on both lines of one radio should share a
+/// transmitter name.
+///
+/// An SC port is a transmitter's USB port in normal mode.  It is read with an SC::Communicator, and messages are
+/// counted by ID.  The transmitter's e-stop latency histograms (see estop::latency_probe) can be requested over it, and
+/// the latest answer is included in the port's report.
+///
+class Radio
+{
+public:
+    ///
+    /// \brief Enumerates what a port carries.
+    ///
+    enum class Kind
+    {
+        XBee,   ///< XBee API frames.
+        SC      ///< SC::Communicator packets.
+    };
+
+    ///
+    /// \brief Radio Creates a new monitored port.
+    /// \param Transmitter The name of the transmitter the port belongs to.
+    /// \param Type What the port carries.
+    /// \param Mode The XBee API mode, for XBee ports.
+    ///
+    Radio(const std::string& Transmitter, Kind Type, estop::xbee_parser::api_mode Mode);
+
+    // METHODS
+    ///
+    /// \brief Open Opens the port.
+    /// \return TRUE if the port is open, otherwise FALSE, with errno set.
+    ///
+    bool Open(const std::string& Path, unsigned long Baud);
+    ///
+    /// \brief Service Reads and decodes everything buffered for the port.
+    /// \param Stats The statistics to record e-stop traffic in.
+    /// \param Events If not NULL, where to log each decoded event.
+    /// \return FALSE if the port has closed, otherwise TRUE.
+    ///
+    bool Service(EstopStats& Stats, FILE* Events);
+    ///
+    /// \brief Report Writes the port's counters.
+    ///
+    void Report(FILE* Output) const;
+    ///
+    /// \brief RequestLatencyReport Asks an SC port's transmitter for its e-stop latency histograms.
+    /// \details The answer is picked up by Service().  Does nothing for XBee ports.
+    ///
+    void RequestLatencyReport();
+
+    // PROPERTIES
+    SerialPort& pPort();
+    const std::string& pTransmitter() const;
+
+private:
+    std::string mTransmitter;
+    Kind mType;
+    SerialPort mPort;
+    estop::xbee_parser mParser;
+    std::unique_ptr<SC::Communicator> mCommunicator;
+
+    unsigned long mFrames;
+    unsigned long mBadChecksums;
+    unsigned long mBytesSkipped;
+    std::map<unsigned int, unsigned long> mCounts;
+
+    ///
+    /// \brief A stage of a latency report.
+    ///
+    struct LatencyStage
+    {
+        unsigned int Count;
+        unsigned long Min;
+        unsigned long Max;
+        std::vector<unsigned int> Buckets;
+    };
+    /// \brief mLatencyReceived TRUE once a latency report has been received.
+    bool mLatencyReceived;
+    /// \brief mLatencyEnabled TRUE if the transmitter was built with its latency probes.
+    bool mLatencyEnabled;
+    unsigned int mLatencyAbandoned;
+    std::vector<LatencyStage> mLatency;
+
+    void HandleFrame(EstopStats& Stats, FILE* Events, uint64_t Time);
+    void HandleLatencyReport(const SC::Message& Message);
+    void ReportLatency(FILE* Output) const;
+};
+
+}
+
+#endif // RADIO_H
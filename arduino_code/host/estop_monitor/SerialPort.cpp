@@ -0,0 +1,205 @@
+#include "SerialPort.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace Monitor;
+
+namespace {
+
+speed_t baud_constant(unsigned long baud)
+{
+  switch(baud)
+  {
+  case 1200: return B1200;
+  case 2400: return B2400;
+  case 4800: return B4800;
+  case 9600: return B9600;
+  case 19200: return B19200;
+  case 38400: return B38400;
+  case 57600: return B57600;
+  case 115200: return B115200;
+  case 230400: return B230400;
+  default: return B0;
+  }
+}
+
+}
+
+SerialPort::SerialPort()
+{
+  SerialPort::mDescriptor = -1;
+  SerialPort::mTerminal = false;
+  SerialPort::mPosition = 0;
+  SerialPort::mLastFill = 0;
+  SerialPort::mBytesRead = 0;
+}
+SerialPort::~SerialPort()
+{
+  SerialPort::Close();
+}
+
+// METHODS
+bool SerialPort::Open(const std::string& Path, unsigned long Baud)
+{
+  SerialPort::Close();
+  SerialPort::mPath = Path;
+  SerialPort::mDescriptor = open(Path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+  if(SerialPort::mDescriptor < 0)
+  {
+    return false;
+  }
+
+  // Terminals get raw mode at the requested baud.  Anything else (a FIFO, a replayed file) is read as is.
+  SerialPort::mTerminal = isatty(SerialPort::mDescriptor);
+  if(SerialPort::mTerminal)
+  {
+    speed_t speed = baud_constant(Baud);
+    struct termios settings;
+    if(speed == B0 || tcgetattr(SerialPort::mDescriptor, &settings) != 0)
+    {
+      int error = (speed == B0) ? EINVAL : errno;
+      SerialPort::Close();
+      errno = error;
+      return false;
+    }
+    cfmakeraw(&settings);
+    cfsetispeed(&settings, speed);
+    cfsetospeed(&settings, speed);
+    settings.c_cflag |= CLOCAL | CREAD;
+    settings.c_cflag &= ~CRTSCTS;
+    settings.c_cc[VMIN] = 0;
+    settings.c_cc[VTIME] = 0;
+    if(tcsetattr(SerialPort::mDescriptor, TCSANOW, &settings) != 0)
+    {
+      int error = errno;
+      SerialPort::Close();
+      errno = error;
+      return false;
+    }
+    tcflush(SerialPort::mDescriptor, TCIFLUSH);
+  }
+  return true;
+}
+void SerialPort::Close()
+{
+  if(SerialPort::mDescriptor >= 0)
+  {
+    close(SerialPort::mDescriptor);
+    SerialPort::mDescriptor = -1;
+  }
+  SerialPort::mBuffer.clear();
+  SerialPort::mPosition = 0;
+}
+long SerialPort::Fill()
+{
+  if(SerialPort::mDescriptor < 0)
+  {
+    return -1;
+  }
+
+  // Drop what has been consumed before growing the buffer.
+  if(SerialPort::mPosition > 0)
+  {
+    SerialPort::mBuffer.erase(SerialPort::mBuffer.begin(), SerialPort::mBuffer.begin() + SerialPort::mPosition);
+    SerialPort::mPosition = 0;
+  }
+
+  long total = 0;
+  bool closed = false;
+  byte chunk[4096];
+  while(true)
+  {
+    ssize_t count = ::read(SerialPort::mDescriptor, chunk, sizeof(chunk));
+    if(count > 0)
+    {
+      SerialPort::mBuffer.insert(SerialPort::mBuffer.end(), chunk, chunk + count);
+      total += count;
+      continue;
+    }
+    if(count < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    // A terminal set to VMIN = VTIME = 0 reads nothing once drained, and reports a hangup as an error.  Otherwise
+    // reading nothing is end of file (the writer went away).
+    if(count == 0)
+    {
+      closed = !SerialPort::mTerminal;
+    }
+    else
+    {
+      closed = (errno != EAGAIN && errno != EWOULDBLOCK);
+    }
+    break;
+  }
+
+  // Count what was read, even if the port closed after it.
+  if(total > 0)
+  {
+    SerialPort::mLastFill = host::now_micros();
+    SerialPort::mBytesRead += total;
+    return total;
+  }
+  return closed ? -1 : 0;
+}
+
+// STREAM
+int SerialPort::available()
+{
+  return static_cast<int>(SerialPort::mBuffer.size() - SerialPort::mPosition);
+}
+int SerialPort::read()
+{
+  if(SerialPort::mPosition >= SerialPort::mBuffer.size())
+  {
+    return -1;
+  }
+  return SerialPort::mBuffer[SerialPort::mPosition++];
+}
+int SerialPort::peek()
+{
+  if(SerialPort::mPosition >= SerialPort::mBuffer.size())
+  {
+    return -1;
+  }
+  return SerialPort::mBuffer[SerialPort::mPosition];
+}
+size_t SerialPort::write(uint8_t Value)
+{
+  return SerialPort::write(&Value, 1);
+}
+size_t SerialPort::write(const uint8_t* Buffer, size_t Size)
+{
+  // Receipts and the like are small.  If the port can't take them now, they are dropped, as on a full UART.
+  if(SerialPort::mDescriptor < 0)
+  {
+    return 0;
+  }
+  ssize_t count = ::write(SerialPort::mDescriptor, Buffer, Size);
+  return (count > 0) ? static_cast<size_t>(count) : 0;
+}
+int SerialPort::availableForWrite()
+{
+  return 0x7FFF;
+}
+
+// PROPERTIES
+int SerialPort::pDescriptor() const
+{
+  return SerialPort::mDescriptor;
+}
+const std::string& SerialPort::pPath() const
+{
+  return SerialPort::mPath;
+}
+uint64_t SerialPort::pLastFill() const
+{
+  return SerialPort::mLastFill;
+}
+unsigned long long SerialPort::pBytesRead() const
+{
+  return SerialPort::mBytesRead;
+}
@@ -0,0 +1,88 @@
+/// \file SerialPort.h
+/// \brief Defines the Monitor::SerialPort class.
+#ifndef SERIALPORT_H
+#define SERIALPORT_H
+
+#include <Arduino.h>
+
+#include <string>
+#include <vector>
+
+namespace Monitor {
+
+///
+/// \brief A Linux serial port (or FIFO) as a non-blocking Stream.
+/// \details The port is opened raw with termios, so it can be handed to an SC::Communicator or fed to an
+/// estop::xbee_parser.  Reading never blocks: Fill() pulls in whatever the kernel has buffered, and is meant to be
+/// called when epoll reports the descriptor readable.  Each Fill() records the time it ran, which is the best
+/// timestamp available for the bytes it read.
+///
+class SerialPort : public Stream
+{
+public:
+    SerialPort();
+    ~SerialPort();
+
+    // METHODS
+    ///
+    /// \brief Open Opens a port.
+    /// \param Path The device or FIFO path.
+    /// \param Baud The baud rate.  Ignored for anything that is not a terminal.
+    /// \return TRUE if the port is open, otherwise FALSE, with errno set.
+    ///
+    bool Open(const std::string& Path, unsigned long Baud);
+    ///
+    /// \brief Close Closes the port.
+    ///
+    void Close();
+    ///
+    /// \brief Fill Reads everything the kernel has buffered for the port.
+    /// \return The number of bytes read, 0 if there was nothing to read, or -1 if the port has closed or failed.
+    ///
+    long Fill();
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+    size_t write(const uint8_t* Buffer, size_t Size) override;
+    int availableForWrite() override;
+
+    // PROPERTIES
+    ///
+    /// \brief pDescriptor PROPERTY Gets the file descriptor, or -1 if closed.
+    ///
+    int pDescriptor() const;
+    ///
+    /// \brief pPath PROPERTY Gets the path the port was opened with.
+    ///
+    const std::string& pPath() const;
+    ///
+    /// \brief pLastFill PROPERTY Gets the time, from host::now_micros(), of the last Fill() that read data.
+    ///
+    uint64_t pLastFill() const;
+    ///
+    /// \brief pBytesRead PROPERTY Gets the number of bytes read from the port.
+    ///
+    unsigned long long pBytesRead() const;
+
+private:
+    int mDescriptor;
+    std::string mPath;
+    ///
+    /// \brief mTerminal Stores if the port is a terminal.  Drained terminals read 0 bytes rather than EAGAIN.
+    ///
+    bool mTerminal;
+    ///
+    /// \brief mBuffer Stores bytes read from the port but not yet consumed.
+    ///
+    std::vector<byte> mBuffer;
+    size_t mPosition;
+    uint64_t mLastFill;
+    unsigned long long mBytesRead;
+};
+
+}
+
+#endif // SERIALPORT_H
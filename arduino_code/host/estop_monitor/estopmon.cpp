@@ -0,0 +1,306 @@
+/// \file estopmon.cpp
+/// \brief Linux daemon that watches e-stop traffic on one or more ports and publishes latency and loss statistics.
+///
+/// Usage:
+///   estopmon [--xbee name=path]... [--sc name=path]... [--baud rate] [--ap 1|2] [--interval seconds]
+///            [--window ms] [--format text|csv] [--output file] [--events]
+///
+/// Every port is watched from one epoll loop.  Statistics are published every --interval seconds, on SIGUSR1, and
+/// on exit (SIGINT or SIGTERM, or once every port has closed).  With --output, each report replaces the file
+/// atomically; otherwise reports go to stdout.  --events logs every decoded frame or message to stderr.  SC ports are
+/// asked for their transmitter's latency histograms at startup and after every periodic report.
+#include "EstopStats.h"
+#include "Radio.h"
+
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace Monitor;
+
+namespace {
+
+struct port_option
+{
+  std::string name;
+  std::string path;
+  Radio::Kind kind;
+};
+
+struct options
+{
+  std::vector<port_option> ports;
+  unsigned long baud;
+  estop::xbee_parser::api_mode mode;
+  unsigned int interval;
+  uint64_t window;
+  bool csv;
+  std::string output;
+  bool events;
+};
+
+void publish(const options& settings, const std::vector<std::unique_ptr<Radio> >& radios, const EstopStats& stats)
+{
+  FILE* output = stdout;
+  std::string temporary;
+  if(!settings.output.empty())
+  {
+    temporary = settings.output + ".tmp";
+    output = fopen(temporary.c_str(), "w");
+    if(!output)
+    {
+      fprintf(stderr, "estopmon: can't write %s: %s\n", temporary.c_str(), strerror(errno));
+      return;
+    }
+  }
+
+  uint64_t now = host::now_micros();
+  if(!settings.csv)
+  {
+    fprintf(output, "== %.3f s\n", now * 1e-6);
+    for(size_t i = 0; i < radios.size(); i++)
+    {
+      radios[i]->Report(output);
+    }
+  }
+  stats.Report(output, settings.csv, now);
+
+  if(output != stdout)
+  {
+    fclose(output);
+    if(rename(temporary.c_str(), settings.output.c_str()) != 0)
+    {
+      fprintf(stderr, "estopmon: can't replace %s: %s\n", settings.output.c_str(), strerror(errno));
+    }
+  }
+}
+
+bool parse_port(const char* value, Radio::Kind kind, std::vector<port_option>& ports)
+{
+  std::string text = value;
+  size_t separator = text.find('=');
+  if(separator == std::string::npos || separator == 0 || separator + 1 == text.size())
+  {
+    return false;
+  }
+  port_option port;
+  port.name = text.substr(0, separator);
+  port.path = text.substr(separator + 1);
+  port.kind = kind;
+  ports.push_back(port);
+  return true;
+}
+
+int usage()
+{
+  fprintf(stderr,
+          "usage: estopmon [--xbee name=path]... [--sc name=path]... [--baud rate] [--ap 1|2] [--interval seconds]\n"
+          "                [--window ms] [--format text|csv] [--output file] [--events]\n");
+  return 2;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+  options settings;
+  settings.baud = 9600;
+  settings.mode = estop::xbee_parser::api_mode::unescaped;
+  settings.interval = 10;
+  settings.window = 500000;
+  settings.csv = false;
+  settings.events = false;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string flag = argv[i];
+    if(flag == "--events")
+    {
+      settings.events = true;
+      continue;
+    }
+    if(i + 1 >= argc)
+    {
+      return usage();
+    }
+    const char* value = argv[++i];
+    if(flag == "--xbee" || flag == "--sc")
+    {
+      if(!parse_port(value, (flag == "--sc") ? Radio::Kind::SC : Radio::Kind::XBee, settings.ports))
+      {
+        return usage();
+      }
+    }
+    else if(flag == "--baud")
+    {
+      settings.baud = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--ap")
+    {
+      settings.mode = (strtoul(value, NULL, 0) == 2) ? estop::xbee_parser::api_mode::escaped : estop::xbee_parser::api_mode::unescaped;
+    }
+    else if(flag == "--interval")
+    {
+      settings.interval = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--window")
+    {
+      settings.window = strtoull(value, NULL, 0) * 1000;
+    }
+    else if(flag == "--format")
+    {
+      settings.csv = (std::string(value) == "csv");
+    }
+    else if(flag == "--output")
+    {
+      settings.output = value;
+    }
+    else
+    {
+      return usage();
+    }
+  }
+  if(settings.ports.empty())
+  {
+    return usage();
+  }
+
+  int epoll = epoll_create1(EPOLL_CLOEXEC);
+  if(epoll < 0)
+  {
+    perror("estopmon: epoll_create1");
+    return 1;
+  }
+
+  // Ports.  Event data is the index of the port's radio.
+  std::vector<std::unique_ptr<Radio> > radios;
+  for(size_t i = 0; i < settings.ports.size(); i++)
+  {
+    const port_option& port = settings.ports[i];
+    std::unique_ptr<Radio> radio(new Radio(port.name, port.kind, settings.mode));
+    if(!radio->Open(port.path, settings.baud))
+    {
+      fprintf(stderr, "estopmon: can't open %s: %s\n", port.path.c_str(), strerror(errno));
+      return 1;
+    }
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.u64 = radios.size();
+    if(epoll_ctl(epoll, EPOLL_CTL_ADD, radio->pPort().pDescriptor(), &event) != 0)
+    {
+      fprintf(stderr, "estopmon: can't watch %s: %s\n", port.path.c_str(), strerror(errno));
+      return 1;
+    }
+    radio->RequestLatencyReport();
+    radios.push_back(std::move(radio));
+  }
+  const uint64_t timer_event = radios.size();
+  const uint64_t signal_event = radios.size() + 1;
+
+  // Signals are handled in the loop, like everything else.
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  sigaddset(&signals, SIGUSR1);
+  sigprocmask(SIG_BLOCK, &signals, NULL);
+  int signal_descriptor = signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  struct epoll_event signal_watch;
+  signal_watch.events = EPOLLIN;
+  signal_watch.data.u64 = signal_event;
+  epoll_ctl(epoll, EPOLL_CTL_ADD, signal_descriptor, &signal_watch);
+
+  // Periodic reports.
+  int timer = -1;
+  if(settings.interval > 0)
+  {
+    timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec period;
+    memset(&period, 0, sizeof(period));
+    period.it_value.tv_sec = settings.interval;
+    period.it_interval.tv_sec = settings.interval;
+    timerfd_settime(timer, 0, &period, NULL);
+    struct epoll_event timer_watch;
+    timer_watch.events = EPOLLIN;
+    timer_watch.data.u64 = timer_event;
+    epoll_ctl(epoll, EPOLL_CTL_ADD, timer, &timer_watch);
+  }
+
+  EstopStats stats(settings.window);
+  FILE* events = settings.events ? stderr : NULL;
+  size_t open = radios.size();
+  bool running = true;
+  while(running && open > 0)
+  {
+    struct epoll_event ready[16];
+    int count = epoll_wait(epoll, ready, 16, -1);
+    if(count < 0)
+    {
+      if(errno == EINTR)
+      {
+        continue;
+      }
+      perror("estopmon: epoll_wait");
+      break;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+      uint64_t source = ready[i].data.u64;
+      if(source == timer_event)
+      {
+        uint64_t expirations;
+        if(read(timer, &expirations, sizeof(expirations)) > 0)
+        {
+          publish(settings, radios, stats);
+          // Refresh the latency histograms in time for the next report.
+          for(size_t r = 0; r < radios.size(); r++)
+          {
+            radios[r]->RequestLatencyReport();
+          }
+        }
+      }
+      else if(source == signal_event)
+      {
+        struct signalfd_siginfo info;
+        while(read(signal_descriptor, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info)))
+        {
+          if(info.ssi_signo == SIGUSR1)
+          {
+            publish(settings, radios, stats);
+          }
+          else
+          {
+            running = false;
+          }
+        }
+      }
+      else
+      {
+        Radio& radio = *radios[source];
+        int descriptor = radio.pPort().pDescriptor();
+        if(!radio.Service(stats, events))
+        {
+          // The port has gone away.  Keep its statistics, but stop watching it.
+          fprintf(stderr, "estopmon: %s closed\n", radio.pPort().pPath().c_str());
+          epoll_ctl(epoll, EPOLL_CTL_DEL, descriptor, NULL);
+          radio.pPort().Close();
+          open--;
+        }
+      }
+    }
+  }
+
+  publish(settings, radios, stats);
+  return 0;
+}
@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = estopmon
+
+include(../host.pri)
+
+INCLUDEPATH += $$PWD/../capture
+INCLUDEPATH += $$PWD/../../estop_transmitter
+
+SOURCES += \
+    $$PWD/../capture/FrameDecoder.cpp \
+    $$PWD/../../estop_transmitter/xbee_parser.cpp \
+    EstopStats.cpp \
+    Radio.cpp \
+    SerialPort.cpp \
+    estopmon.cpp
+
+HEADERS += \
+    EstopStats.h \
+    Radio.h \
+    SerialPort.h
@@ -0,0 +1,23 @@
+# Shared settings for the host (PC) builds of the Arduino code.
+# Pulls in the Arduino core stand-in and the SerialCommunicator library sources.
+CONFIG += c++11 console
+CONFIG -= app_bundle
+CONFIG -= qt
+
+INCLUDEPATH += $$PWD/arduino
+INCLUDEPATH += $$PWD/../libraries/serialcommunicator/src
+
+SOURCES += \
+    $$PWD/arduino/Arduino.cpp \
+    $$PWD/../libraries/serialcommunicator/src/Communicator.cpp \
+    $$PWD/../libraries/serialcommunicator/src/Message.cpp \
+    $$PWD/../libraries/serialcommunicator/src/MessageHandle.cpp \
+    $$PWD/../libraries/serialcommunicator/src/Capture.cpp \
+    $$PWD/../libraries/serialcommunicator/src/LinkQuality.cpp \
+    $$PWD/../libraries/serialcommunicator/src/utility/Outbound.cpp \
+    $$PWD/../libraries/serialcommunicator/src/utility/OutboundHeap.cpp \
+    $$PWD/../libraries/serialcommunicator/src/utility/Inbound.cpp \
+    $$PWD/../libraries/serialcommunicator/src/utility/Escape.cpp
+
+HEADERS += \
+    $$PWD/arduino/Arduino.h
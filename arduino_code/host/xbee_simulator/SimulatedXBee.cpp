@@ -0,0 +1,838 @@
+#include "SimulatedXBee.h"
+
+#include <string.h>
+
+using namespace Sim;
+
+// NETWORKCONFIG
+NetworkConfig::NetworkConfig()
+{
+    NetworkConfig::Robots = 10;
+    NetworkConfig::BroadcastLoss = 0.0;
+    NetworkConfig::UnicastLoss = 0.0;
+    NetworkConfig::Latency = 8000;
+    NetworkConfig::Jitter = 4000;
+    NetworkConfig::AirTime = 3000;
+    NetworkConfig::CarrierSense = 250;
+    NetworkConfig::ResponseWindow = 60000;
+    NetworkConfig::MacRetries = 10;
+    NetworkConfig::RetryBackoff = 10000;
+    NetworkConfig::LocalLatency = 500;
+    NetworkConfig::WriteLatency = 30000;
+    NetworkConfig::Baud = 9600;
+    NetworkConfig::MaxBaud = 0;
+    NetworkConfig::Seed = 1;
+}
+
+// CONSTRUCTORS
+SimulatedXBee::SimulatedXBee(const NetworkConfig& Config)
+{
+    SimulatedXBee::mConfig = Config;
+    memset(&(SimulatedXBee::mStats), 0, sizeof(SimulatedXBee::mStats));
+    // xorshift needs a nonzero state.
+    SimulatedXBee::mRandom = Config.Seed * 0x9E3779B97F4A7C15ULL + 1;
+    SimulatedXBee::mOrder = 0;
+    SimulatedXBee::mNow = 0;
+    SimulatedXBee::mTXFree = 0;
+    SimulatedXBee::mRXFree = 0;
+    SimulatedXBee::mAPMode = 1;
+    SimulatedXBee::mParserCorrupt = false;
+    SimulatedXBee::mHostBaud = Config.Baud;
+    SimulatedXBee::mRadioBaud = Config.Baud;
+
+    // Robots are numbered from 0x0013A200 41000000.
+    SimulatedXBee::mRobots.resize(Config.Robots);
+    for(unsigned int i = 0; i < Config.Robots; i++)
+    {
+        Robot& Target = SimulatedXBee::mRobots[i];
+        const byte Prefix[4] = {0x00, 0x13, 0xA2, 0x00};
+        memcpy(Target.Address, Prefix, 4);
+        Target.Address[4] = 0x41;
+        Target.Address[5] = static_cast<byte>(i >> 16);
+        Target.Address[6] = static_cast<byte>(i >> 8);
+        Target.Address[7] = static_cast<byte>(i);
+        Target.D1 = 4;
+        Target.StoppedAt = 0;
+        Target.BroadcastLoss = Config.BroadcastLoss;
+        Target.UnicastLoss = Config.UnicastLoss;
+        Target.CommandsReceived = 0;
+        Target.PacketsReceived = 0;
+    }
+
+    // The e-stop's factory name, in the device_name-team_name format.
+    const char* Name = "estop-team";
+    SimulatedXBee::mRegisters[('N' << 8) | 'I'] = std::vector<byte>(Name, Name + strlen(Name));
+    SimulatedXBee::mRegisters[('A' << 8) | 'P'] = std::vector<byte>(1, 1);
+    int BD = SimulatedXBee::BaudIndex(Config.Baud);
+    SimulatedXBee::mRegisters[('B' << 8) | 'D'] = std::vector<byte>(1, static_cast<byte>((BD < 0) ? 3 : BD));
+}
+
+// STREAM
+int SimulatedXBee::available()
+{
+    SimulatedXBee::Service();
+    uint64_t Now = host::now_micros();
+    int Count = 0;
+    for(size_t i = 0; i < SimulatedXBee::mRX.size() && SimulatedXBee::mRX[i].first <= Now; i++)
+    {
+        Count++;
+    }
+    return Count;
+}
+int SimulatedXBee::read()
+{
+    SimulatedXBee::Service();
+    if(SimulatedXBee::mRX.empty() || SimulatedXBee::mRX.front().first > host::now_micros())
+    {
+        return -1;
+    }
+    byte Value = SimulatedXBee::mRX.front().second;
+    SimulatedXBee::mRX.pop_front();
+    return Value;
+}
+int SimulatedXBee::peek()
+{
+    SimulatedXBee::Service();
+    if(SimulatedXBee::mRX.empty() || SimulatedXBee::mRX.front().first > host::now_micros())
+    {
+        return -1;
+    }
+    return SimulatedXBee::mRX.front().second;
+}
+size_t SimulatedXBee::write(uint8_t Value)
+{
+    SimulatedXBee::Service();
+
+    // Like HardwareSerial, a full transmit buffer blocks the caller until the UART clocks a byte out.
+    if(SimulatedXBee::TXQueued() >= SimulatedXBee::TXBufferSize)
+    {
+        uint64_t Room = SimulatedXBee::mTXFree - (SimulatedXBee::TXBufferSize - 1) * SimulatedXBee::ByteTime();
+        SimulatedXBee::mStats.BytesStalled++;
+        host::set_micros(Room);
+        SimulatedXBee::Service();
+    }
+
+    // The byte reaches the radio once the UART has clocked it out.
+    uint64_t Now = host::now_micros();
+    uint64_t Arrival = ((SimulatedXBee::mTXFree > Now) ? SimulatedXBee::mTXFree : Now) + SimulatedXBee::ByteTime();
+    SimulatedXBee::mTXFree = Arrival;
+    SimulatedXBee::mStats.BytesFromHost++;
+    if(SimulatedXBee::Lost())
+    {
+        SimulatedXBee::mStats.BytesGarbled++;
+        return 1;
+    }
+    SimulatedXBee::mParserCorrupt |= SimulatedXBee::Corrupted();
+
+    estop::xbee_parser::result Result = SimulatedXBee::mParser.parse(Value);
+    if(Result != estop::xbee_parser::result::incomplete && SimulatedXBee::mParserCorrupt)
+    {
+        // The frame's checksum would have failed.
+        SimulatedXBee::mParserCorrupt = false;
+        Result = estop::xbee_parser::result::bad_checksum;
+    }
+    if(Result == estop::xbee_parser::result::frame)
+    {
+        // Hand over the frame data, from the frame type up to the checksum.
+        const byte* Frame = SimulatedXBee::mParser.frame();
+        std::vector<byte> Data(Frame + 3, Frame + SimulatedXBee::mParser.length() - 1);
+        SimulatedXBee::Schedule(Arrival, EventType::HostFrame, 0, Data);
+    }
+    else if(Result == estop::xbee_parser::result::bad_checksum)
+    {
+        SimulatedXBee::mStats.BadFramesFromHost++;
+    }
+    return 1;
+}
+size_t SimulatedXBee::write(const uint8_t* Buffer, size_t Size)
+{
+    for(size_t i = 0; i < Size; i++)
+    {
+        SimulatedXBee::write(Buffer[i]);
+    }
+    return Size;
+}
+int SimulatedXBee::availableForWrite()
+{
+    return SimulatedXBee::TXBufferSize - SimulatedXBee::TXQueued();
+}
+
+// METHODS
+void SimulatedXBee::Service()
+{
+    uint64_t Now = host::now_micros();
+    while(!SimulatedXBee::mEvents.empty() && SimulatedXBee::mEvents.top().Time <= Now)
+    {
+        Event Next = SimulatedXBee::mEvents.top();
+        SimulatedXBee::mEvents.pop();
+        SimulatedXBee::mNow = Next.Time;
+
+        switch(Next.Type)
+        {
+            case EventType::HostFrame:
+            {
+                SimulatedXBee::HandleHostFrame(Next.Data);
+                break;
+            }
+            case EventType::LocalResponse:
+            {
+                SimulatedXBee::Emit(Next.Data, SimulatedXBee::mNow);
+                if(Next.Attempt != 0)
+                {
+                    // AP takes effect once its response is out.
+                    SimulatedXBee::pAPMode(Next.Attempt);
+                }
+                if(Next.Baud != 0)
+                {
+                    // So does BD.
+                    SimulatedXBee::mRadioBaud = Next.Baud;
+                    SimulatedXBee::mStats.BaudChanges++;
+                }
+                break;
+            }
+            case EventType::RobotReceive:
+            {
+                SimulatedXBee::HandleRobotReceive(Next.Robot, Next.Data);
+                break;
+            }
+            case EventType::UplinkStart:
+            {
+                SimulatedXBee::HandleUplinkStart(Next);
+                break;
+            }
+            case EventType::UplinkEnd:
+            {
+                SimulatedXBee::HandleUplinkEnd(Next);
+                break;
+            }
+            case EventType::DownlinkAttempt:
+            {
+                SimulatedXBee::HandleDownlinkAttempt(Next);
+                break;
+            }
+        }
+    }
+}
+void SimulatedXBee::ResetRobots()
+{
+    for(size_t i = 0; i < SimulatedXBee::mRobots.size(); i++)
+    {
+        SimulatedXBee::mRobots[i].D1 = 4;
+        SimulatedXBee::mRobots[i].StoppedAt = 0;
+    }
+}
+void SimulatedXBee::SetRobotLoss(unsigned int Index, double BroadcastLoss, double UnicastLoss)
+{
+    SimulatedXBee::mRobots.at(Index).BroadcastLoss = BroadcastLoss;
+    SimulatedXBee::mRobots.at(Index).UnicastLoss = UnicastLoss;
+}
+
+// PROPERTIES
+const std::vector<Robot>& SimulatedXBee::pRobots() const
+{
+    return SimulatedXBee::mRobots;
+}
+const NetworkStats& SimulatedXBee::pStats() const
+{
+    return SimulatedXBee::mStats;
+}
+std::vector<byte> SimulatedXBee::pRegister(char AT1, char AT2) const
+{
+    std::map<uint16_t, std::vector<byte> >::const_iterator Entry = SimulatedXBee::mRegisters.find((AT1 << 8) | AT2);
+    return (Entry == SimulatedXBee::mRegisters.end()) ? std::vector<byte>() : Entry->second;
+}
+byte SimulatedXBee::pAPMode() const
+{
+    return SimulatedXBee::mAPMode;
+}
+void SimulatedXBee::pAPMode(byte Mode)
+{
+    SimulatedXBee::mAPMode = Mode;
+    SimulatedXBee::mRegisters[('A' << 8) | 'P'] = std::vector<byte>(1, Mode);
+    SimulatedXBee::mParser.mode((Mode == 2) ? estop::xbee_parser::api_mode::escaped : estop::xbee_parser::api_mode::unescaped);
+}
+unsigned long SimulatedXBee::pHostBaud() const
+{
+    return SimulatedXBee::mHostBaud;
+}
+void SimulatedXBee::pHostBaud(unsigned long Baud)
+{
+    SimulatedXBee::mHostBaud = Baud;
+}
+unsigned long SimulatedXBee::pRadioBaud() const
+{
+    return SimulatedXBee::mRadioBaud;
+}
+
+// EVENTS
+bool SimulatedXBee::EventLater::operator()(const Event& A, const Event& B) const
+{
+    // Ties go to the event scheduled first, so runs are repeatable.
+    return (A.Time != B.Time) ? (A.Time > B.Time) : (A.Order > B.Order);
+}
+void SimulatedXBee::Schedule(uint64_t Time, EventType Type, unsigned int Robot, const std::vector<byte>& Data, byte Attempt, size_t Reception, unsigned long Baud)
+{
+    Event New;
+    New.Time = Time;
+    New.Order = SimulatedXBee::mOrder++;
+    New.Type = Type;
+    New.Robot = Robot;
+    New.Attempt = Attempt;
+    New.Reception = Reception;
+    New.Baud = Baud;
+    New.Data = Data;
+    SimulatedXBee::mEvents.push(New);
+}
+void SimulatedXBee::HandleHostFrame(const std::vector<byte>& Data)
+{
+    SimulatedXBee::mStats.FramesFromHost++;
+    if(Data.empty())
+    {
+        return;
+    }
+
+    switch(Data[0])
+    {
+        case 0x08:
+        case 0x09:
+        {
+            SimulatedXBee::HandleLocalAT(Data);
+            break;
+        }
+        case 0x17:
+        {
+            SimulatedXBee::HandleRemoteAT(Data);
+            break;
+        }
+        case 0x00:
+        {
+            SimulatedXBee::HandleTX(Data);
+            break;
+        }
+        default:
+        {
+            // Not modelled.
+        }
+    }
+}
+void SimulatedXBee::HandleLocalAT(const std::vector<byte>& Data)
+{
+    // Type, ID, Command (2), Parameter...
+    if(Data.size() < 4)
+    {
+        return;
+    }
+    byte FrameID = Data[1];
+    uint16_t Command = (Data[2] << 8) | Data[3];
+    std::vector<byte> Parameter(Data.begin() + 4, Data.end());
+    byte Status = 0x00;
+    byte NewAPMode = 0;
+    unsigned long NewBaud = 0;
+    std::vector<byte> Value;
+    uint32_t Delay = SimulatedXBee::mConfig.LocalLatency;
+
+    // Checks a parameter, returning the status to answer with.
+    struct Validate
+    {
+        static byte Check(uint16_t Command, const std::vector<byte>& Parameter)
+        {
+            if(Command == (('N' << 8) | 'I') && Parameter.size() > 20)
+            {
+                return 0x03;
+            }
+            if(Command == (('A' << 8) | 'P') && (Parameter.size() != 1 || Parameter[0] > 2))
+            {
+                return 0x03;
+            }
+            if(Command == (('K' << 8) | 'Y') && Parameter.size() > 16)
+            {
+                return 0x03;
+            }
+            if(Command == (('B' << 8) | 'D') && (Parameter.empty() || Parameter.size() > 4 || SimulatedXBee::BaudRate(Number(Parameter)) == 0))
+            {
+                return 0x03;
+            }
+            return 0x00;
+        }
+        static uint32_t Number(const std::vector<byte>& Parameter)
+        {
+            uint32_t Value = 0;
+            for(size_t i = 0; i < Parameter.size(); i++)
+            {
+                Value = (Value << 8) | Parameter[i];
+            }
+            return Value;
+        }
+    };
+
+    if(Data[0] == 0x09)
+    {
+        // Queue the change until AC, or the next 0x08.
+        Status = Validate::Check(Command, Parameter);
+        if(Status == 0x00)
+        {
+            SimulatedXBee::mQueued.push_back(std::make_pair(Command, Parameter));
+        }
+    }
+    else
+    {
+        // Apply anything queued first.
+        for(size_t i = 0; i < SimulatedXBee::mQueued.size(); i++)
+        {
+            SimulatedXBee::mRegisters[SimulatedXBee::mQueued[i].first] = SimulatedXBee::mQueued[i].second;
+            if(SimulatedXBee::mQueued[i].first == (('A' << 8) | 'P'))
+            {
+                NewAPMode = SimulatedXBee::mQueued[i].second[0];
+            }
+            if(SimulatedXBee::mQueued[i].first == (('B' << 8) | 'D'))
+            {
+                NewBaud = SimulatedXBee::BaudRate(Validate::Number(SimulatedXBee::mQueued[i].second));
+            }
+        }
+        SimulatedXBee::mQueued.clear();
+
+        if(Command == (('A' << 8) | 'C'))
+        {
+            // Nothing more to do.
+        }
+        else if(Command == (('W' << 8) | 'R'))
+        {
+            SimulatedXBee::mStats.ConfigurationWrites++;
+            Delay = SimulatedXBee::mConfig.WriteLatency;
+        }
+        else if(!Parameter.empty())
+        {
+            Status = Validate::Check(Command, Parameter);
+            if(Status == 0x00)
+            {
+                SimulatedXBee::mRegisters[Command] = Parameter;
+                if(Command == (('A' << 8) | 'P'))
+                {
+                    NewAPMode = Parameter[0];
+                }
+                if(Command == (('B' << 8) | 'D'))
+                {
+                    NewBaud = SimulatedXBee::BaudRate(Validate::Number(Parameter));
+                }
+            }
+        }
+        else if(Command != (('K' << 8) | 'Y'))
+        {
+            // Query.  KY is write-only.
+            Value = SimulatedXBee::pRegister(Data[2], Data[3]);
+        }
+    }
+
+    if(NewAPMode == 0 && NewBaud == 0 && FrameID == 0)
+    {
+        return;
+    }
+
+    // Type, ID, Command (2), Status, Value...
+    std::vector<byte> Response;
+    if(FrameID != 0)
+    {
+        Response.push_back(0x88);
+        Response.push_back(FrameID);
+        Response.push_back(Data[2]);
+        Response.push_back(Data[3]);
+        Response.push_back(Status);
+        Response.insert(Response.end(), Value.begin(), Value.end());
+    }
+    SimulatedXBee::Schedule(SimulatedXBee::mNow + Delay, EventType::LocalResponse, 0, Response, NewAPMode, 0, NewBaud);
+}
+void SimulatedXBee::HandleRemoteAT(const std::vector<byte>& Data)
+{
+    // Type, ID, 64b Address (8), 16b Address (2), Options, Command (2), Parameter...
+    if(Data.size() < 15)
+    {
+        return;
+    }
+
+    if(SimulatedXBee::IsBroadcast(&Data[2]))
+    {
+        // Every robot that hears the broadcast acts on it.
+        SimulatedXBee::mStats.AirTransmissions++;
+        for(unsigned int i = 0; i < SimulatedXBee::mRobots.size(); i++)
+        {
+            if(SimulatedXBee::Uniform() < SimulatedXBee::mRobots[i].BroadcastLoss)
+            {
+                SimulatedXBee::mStats.Lost++;
+                continue;
+            }
+            SimulatedXBee::Schedule(SimulatedXBee::mNow + SimulatedXBee::mConfig.Latency + SimulatedXBee::Random(SimulatedXBee::mConfig.Jitter), EventType::RobotReceive, i, Data);
+        }
+        return;
+    }
+
+    int Index = SimulatedXBee::FindRobot(&Data[2]);
+    if(Index < 0)
+    {
+        // Nobody there.  The radio gives up after its retries.
+        SimulatedXBee::mStats.DownlinkFailed++;
+        if(Data[1] != 0)
+        {
+            std::vector<byte> Response(Data.begin(), Data.begin() + 15);
+            Response[0] = 0x97;
+            Response.erase(Response.begin() + 12);
+            Response.push_back(0x04);
+            SimulatedXBee::Emit(Response, SimulatedXBee::mNow + SimulatedXBee::mConfig.Latency * (1 + SimulatedXBee::mConfig.MacRetries));
+        }
+        return;
+    }
+    SimulatedXBee::Schedule(SimulatedXBee::mNow, EventType::DownlinkAttempt, Index, Data, 0);
+}
+void SimulatedXBee::HandleTX(const std::vector<byte>& Data)
+{
+    // Type, ID, 64b Address (8), Options, Payload...
+    if(Data.size() < 11)
+    {
+        return;
+    }
+
+    if(SimulatedXBee::IsBroadcast(&Data[2]))
+    {
+        SimulatedXBee::mStats.AirTransmissions++;
+        for(unsigned int i = 0; i < SimulatedXBee::mRobots.size(); i++)
+        {
+            if(SimulatedXBee::Uniform() < SimulatedXBee::mRobots[i].BroadcastLoss)
+            {
+                SimulatedXBee::mStats.Lost++;
+                continue;
+            }
+            SimulatedXBee::Schedule(SimulatedXBee::mNow + SimulatedXBee::mConfig.Latency + SimulatedXBee::Random(SimulatedXBee::mConfig.Jitter), EventType::RobotReceive, i, Data);
+        }
+        if(Data[1] != 0)
+        {
+            // TX Status: Type, ID, 16b Address (2), Retries, Delivery Status, Discovery Status.
+            const byte Status[7] = {0x8B, Data[1], 0xFF, 0xFE, 0x00, 0x00, 0x00};
+            SimulatedXBee::Emit(std::vector<byte>(Status, Status + 7), SimulatedXBee::mNow + SimulatedXBee::mConfig.AirTime);
+        }
+        return;
+    }
+
+    int Index = SimulatedXBee::FindRobot(&Data[2]);
+    if(Index < 0)
+    {
+        SimulatedXBee::mStats.DownlinkFailed++;
+        if(Data[1] != 0)
+        {
+            const byte Status[7] = {0x8B, Data[1], 0xFF, 0xFE, SimulatedXBee::mConfig.MacRetries, 0x25, 0x00};
+            SimulatedXBee::Emit(std::vector<byte>(Status, Status + 7), SimulatedXBee::mNow + SimulatedXBee::mConfig.Latency * (1 + SimulatedXBee::mConfig.MacRetries));
+        }
+        return;
+    }
+    SimulatedXBee::Schedule(SimulatedXBee::mNow, EventType::DownlinkAttempt, Index, Data, 0);
+}
+void SimulatedXBee::HandleRobotReceive(unsigned int Index, const std::vector<byte>& Data)
+{
+    Robot& Target = SimulatedXBee::mRobots[Index];
+    bool Broadcast = SimulatedXBee::IsBroadcast(&Data[2]);
+
+    if(Data[0] == 0x00)
+    {
+        Target.PacketsReceived++;
+        return;
+    }
+
+    // Remote AT Command.
+    Target.CommandsReceived++;
+    byte AT1 = Data[13];
+    byte AT2 = Data[14];
+    std::vector<byte> Value;
+    if(AT1 == 'D' && AT2 == '1')
+    {
+        if(Data.size() > 15)
+        {
+            if(Data[15] == 5 && Target.D1 != 5)
+            {
+                Target.StoppedAt = SimulatedXBee::mNow;
+            }
+            Target.D1 = Data[15];
+        }
+        else
+        {
+            Value.push_back(Target.D1);
+        }
+    }
+
+    if(Data[1] == 0)
+    {
+        // No response wanted.
+        return;
+    }
+
+    // Robots answer with an acknowledged unicast.  Broadcasts are answered at a random time in the response window
+    // to spread the answers out; unicasts are answered right away.
+    std::vector<byte> Response = SimulatedXBee::RemoteResponse(Index, Data[1], AT1, AT2, 0x00, Value);
+    uint64_t Start = SimulatedXBee::mNow + (Broadcast ? SimulatedXBee::Random(SimulatedXBee::mConfig.ResponseWindow) : SimulatedXBee::Random(SimulatedXBee::mConfig.Jitter));
+    SimulatedXBee::Schedule(Start, EventType::UplinkStart, Index, Response, 0);
+}
+void SimulatedXBee::HandleUplinkStart(const Event& Started)
+{
+    // Listen first.  A frame that has been on the air long enough to be heard holds this one off until it ends.
+    uint64_t Clear = 0;
+    for(size_t i = 0; i < SimulatedXBee::mActiveReceptions.size(); i++)
+    {
+        const Reception& Other = SimulatedXBee::mReceptions[SimulatedXBee::mActiveReceptions[i]];
+        if(SimulatedXBee::mNow - Other.Start >= SimulatedXBee::mConfig.CarrierSense && Other.End > Clear)
+        {
+            Clear = Other.End;
+        }
+    }
+    if(Clear != 0)
+    {
+        SimulatedXBee::Schedule(Clear + SimulatedXBee::Random(SimulatedXBee::mConfig.RetryBackoff), EventType::UplinkStart, Started.Robot, Started.Data, Started.Attempt);
+        return;
+    }
+
+    SimulatedXBee::mStats.AirTransmissions++;
+
+    // Anything else on the air now collides with this frame, and this frame with it.
+    Reception New;
+    New.Start = SimulatedXBee::mNow;
+    New.End = SimulatedXBee::mNow + SimulatedXBee::mConfig.AirTime;
+    New.Collided = false;
+    New.Active = true;
+    for(size_t i = 0; i < SimulatedXBee::mActiveReceptions.size(); i++)
+    {
+        Reception& Other = SimulatedXBee::mReceptions[SimulatedXBee::mActiveReceptions[i]];
+        Other.Collided = true;
+        New.Collided = true;
+    }
+    SimulatedXBee::mReceptions.push_back(New);
+    size_t Index = SimulatedXBee::mReceptions.size() - 1;
+    SimulatedXBee::mActiveReceptions.push_back(Index);
+
+    SimulatedXBee::Schedule(New.End, EventType::UplinkEnd, Started.Robot, Started.Data, Started.Attempt, Index);
+}
+void SimulatedXBee::HandleUplinkEnd(const Event& Ended)
+{
+    Reception& Finished = SimulatedXBee::mReceptions[Ended.Reception];
+    Finished.Active = false;
+    for(size_t i = 0; i < SimulatedXBee::mActiveReceptions.size(); i++)
+    {
+        if(SimulatedXBee::mActiveReceptions[i] == Ended.Reception)
+        {
+            SimulatedXBee::mActiveReceptions.erase(SimulatedXBee::mActiveReceptions.begin() + i);
+            break;
+        }
+    }
+
+    bool Delivered = true;
+    if(Finished.Collided)
+    {
+        SimulatedXBee::mStats.Collisions++;
+        Delivered = false;
+    }
+    else if(SimulatedXBee::Uniform() < SimulatedXBee::mRobots[Ended.Robot].UnicastLoss)
+    {
+        SimulatedXBee::mStats.Lost++;
+        Delivered = false;
+    }
+
+    // Nothing refers to finished receptions once the air is clear.
+    if(SimulatedXBee::mActiveReceptions.empty())
+    {
+        SimulatedXBee::mReceptions.clear();
+    }
+
+    if(Delivered)
+    {
+        SimulatedXBee::Emit(Ended.Data, SimulatedXBee::mNow);
+    }
+    else if(Ended.Attempt < SimulatedXBee::mConfig.MacRetries)
+    {
+        SimulatedXBee::Schedule(SimulatedXBee::mNow + 1 + SimulatedXBee::Random(SimulatedXBee::mConfig.RetryBackoff), EventType::UplinkStart, Ended.Robot, Ended.Data, Ended.Attempt + 1);
+    }
+    else
+    {
+        SimulatedXBee::mStats.UplinkDropped++;
+    }
+}
+void SimulatedXBee::HandleDownlinkAttempt(const Event& Attempt)
+{
+    const std::vector<byte>& Data = Attempt.Data;
+    Robot& Target = SimulatedXBee::mRobots[Attempt.Robot];
+    SimulatedXBee::mStats.AirTransmissions++;
+
+    // Options bit 0 disables the MAC ACK, and with it the retries.
+    bool Remote = (Data[0] == 0x17);
+    byte Options = Remote ? Data[12] : Data[10];
+    byte Retries = (Options & 0x01) ? 0 : SimulatedXBee::mConfig.MacRetries;
+    uint64_t Arrival = SimulatedXBee::mNow + SimulatedXBee::mConfig.Latency + SimulatedXBee::Random(SimulatedXBee::mConfig.Jitter);
+
+    if(SimulatedXBee::Uniform() >= Target.UnicastLoss)
+    {
+        SimulatedXBee::Schedule(Arrival, EventType::RobotReceive, Attempt.Robot, Data);
+        if(!Remote && Data[1] != 0)
+        {
+            const byte Status[7] = {0x8B, Data[1], 0xFF, 0xFE, Attempt.Attempt, 0x00, 0x00};
+            SimulatedXBee::Emit(std::vector<byte>(Status, Status + 7), Arrival);
+        }
+        return;
+    }
+
+    SimulatedXBee::mStats.Lost++;
+    if(Attempt.Attempt < Retries)
+    {
+        SimulatedXBee::Schedule(Arrival + SimulatedXBee::Random(SimulatedXBee::mConfig.RetryBackoff), EventType::DownlinkAttempt, Attempt.Robot, Data, Attempt.Attempt + 1);
+        return;
+    }
+
+    // Out of retries.
+    SimulatedXBee::mStats.DownlinkFailed++;
+    if(Data[1] != 0)
+    {
+        if(Remote)
+        {
+            std::vector<byte> Response = SimulatedXBee::RemoteResponse(Attempt.Robot, Data[1], Data[13], Data[14], 0x04, std::vector<byte>());
+            SimulatedXBee::Emit(Response, Arrival);
+        }
+        else
+        {
+            const byte Status[7] = {0x8B, Data[1], 0xFF, 0xFE, Attempt.Attempt, 0x21, 0x00};
+            SimulatedXBee::Emit(std::vector<byte>(Status, Status + 7), Arrival);
+        }
+    }
+}
+
+// HELPERS
+void SimulatedXBee::Emit(const std::vector<byte>& Data, uint64_t Time)
+{
+    // Frame the data.
+    std::vector<byte> Frame;
+    Frame.push_back(static_cast<byte>(estop::xbee_parser::start_delimiter));
+    Frame.push_back(static_cast<byte>(Data.size() >> 8));
+    Frame.push_back(static_cast<byte>(Data.size()));
+    byte Sum = 0;
+    for(size_t i = 0; i < Data.size(); i++)
+    {
+        Frame.push_back(Data[i]);
+        Sum += Data[i];
+    }
+    Frame.push_back(0xFF - Sum);
+
+    // A mismatched UART loses the whole frame.  A marginal one corrupts it, which the host's checksum catches.
+    if(SimulatedXBee::Lost())
+    {
+        SimulatedXBee::mStats.BytesGarbled += Frame.size();
+        return;
+    }
+    for(size_t i = 0; i < Frame.size(); i++)
+    {
+        if(SimulatedXBee::Corrupted())
+        {
+            Frame.back() ^= 0x01;
+            break;
+        }
+    }
+
+    // Queue it for the host, escaping everything after the delimiter in escaped mode, at the UART's pace.
+    for(size_t i = 0; i < Frame.size(); i++)
+    {
+        byte Value = Frame[i];
+        bool Escape = (i > 0 && SimulatedXBee::mAPMode == 2 && estop::xbee_parser::needs_escape(Value));
+        for(int Part = Escape ? 0 : 1; Part < 2; Part++)
+        {
+            byte Out = (Part == 0) ? static_cast<byte>(estop::xbee_parser::escape) : (Escape ? static_cast<byte>(Value ^ estop::xbee_parser::escape_mask) : Value);
+            uint64_t Ready = ((SimulatedXBee::mRXFree > Time) ? SimulatedXBee::mRXFree : Time) + SimulatedXBee::ByteTime();
+            SimulatedXBee::mRXFree = Ready;
+            SimulatedXBee::mRX.push_back(std::make_pair(Ready, Out));
+            SimulatedXBee::mStats.BytesToHost++;
+        }
+    }
+    SimulatedXBee::mStats.FramesToHost++;
+}
+uint64_t SimulatedXBee::ByteTime() const
+{
+    // 10 bits per byte: start, 8 data, stop.
+    return (SimulatedXBee::mHostBaud == 0) ? 0 : (10000000ULL + SimulatedXBee::mHostBaud - 1) / SimulatedXBee::mHostBaud;
+}
+int SimulatedXBee::TXQueued() const
+{
+    // Bytes leave the buffer one ByteTime apart, the last at mTXFree.
+    uint64_t Now = host::now_micros();
+    uint64_t Time = SimulatedXBee::ByteTime();
+    if(SimulatedXBee::mTXFree <= Now || Time == 0)
+    {
+        return 0;
+    }
+    return static_cast<int>((SimulatedXBee::mTXFree - Now + Time - 1) / Time);
+}
+bool SimulatedXBee::Lost() const
+{
+    // Mismatched ends see nothing but framing errors.
+    return SimulatedXBee::mHostBaud != SimulatedXBee::mRadioBaud;
+}
+bool SimulatedXBee::Corrupted()
+{
+    // Past its limit, the link is marginal rather than dead: now and then a bit is sampled wrong.
+    if(SimulatedXBee::mConfig.MaxBaud != 0 && SimulatedXBee::mRadioBaud > SimulatedXBee::mConfig.MaxBaud &&
+       SimulatedXBee::Uniform() < 0.05)
+    {
+        SimulatedXBee::mStats.BytesGarbled++;
+        return true;
+    }
+    return false;
+}
+unsigned long SimulatedXBee::BaudRate(uint32_t Index)
+{
+    // The rates BD selects on the 900HP, or 0 for an invalid index.
+    const unsigned long Rates[] = {1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400};
+    return (Index < sizeof(Rates) / sizeof(Rates[0])) ? Rates[Index] : 0;
+}
+int SimulatedXBee::BaudIndex(unsigned long Baud)
+{
+    for(uint32_t i = 0; SimulatedXBee::BaudRate(i) != 0; i++)
+    {
+        if(SimulatedXBee::BaudRate(i) == Baud)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+double SimulatedXBee::Uniform()
+{
+    // xorshift64*.
+    SimulatedXBee::mRandom ^= SimulatedXBee::mRandom >> 12;
+    SimulatedXBee::mRandom ^= SimulatedXBee::mRandom << 25;
+    SimulatedXBee::mRandom ^= SimulatedXBee::mRandom >> 27;
+    return static_cast<double>((SimulatedXBee::mRandom * 0x2545F4914F6CDD1DULL) >> 11) / 9007199254740992.0;
+}
+uint32_t SimulatedXBee::Random(uint32_t Maximum)
+{
+    return (Maximum == 0) ? 0 : static_cast<uint32_t>(SimulatedXBee::Uniform() * (Maximum + 1));
+}
+int SimulatedXBee::FindRobot(const byte* Address) const
+{
+    for(size_t i = 0; i < SimulatedXBee::mRobots.size(); i++)
+    {
+        if(memcmp(SimulatedXBee::mRobots[i].Address, Address, 8) == 0)
+        {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+bool SimulatedXBee::IsBroadcast(const byte* Address) const
+{
+    const byte Broadcast[8] = {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF};
+    return memcmp(Address, Broadcast, 8) == 0;
+}
+std::vector<byte> SimulatedXBee::RemoteResponse(unsigned int Index, byte FrameID, byte AT1, byte AT2, byte Status, const std::vector<byte>& Value) const
+{
+    // Type, ID, 64b Address (8), 16b Address (2), Command (2), Status, Value...
+    std::vector<byte> Response;
+    Response.push_back(0x97);
+    Response.push_back(FrameID);
+    Response.insert(Response.end(), SimulatedXBee::mRobots[Index].Address, SimulatedXBee::mRobots[Index].Address + 8);
+    Response.push_back(0xFF);
+    Response.push_back(0xFE);
+    Response.push_back(AT1);
+    Response.push_back(AT2);
+    Response.push_back(Status);
+    Response.insert(Response.end(), Value.begin(), Value.end());
+    return Response;
+}
@@ -0,0 +1,338 @@
+/// \file SimulatedXBee.h
+/// \brief Defines the Sim::SimulatedXBee class.
+#ifndef SIMULATEDXBEE_H
+#define SIMULATEDXBEE_H
+
+#include "Arduino.h"
+
+#include <xbee_parser.h>
+
+#include <deque>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+namespace Sim {
+
+///
+/// \brief Configures the simulated radio network.
+/// \details Times are in microseconds.  Loss probabilities are per transmission attempt, from 0 to 1.
+///
+struct NetworkConfig
+{
+    NetworkConfig();
+
+    ///
+    /// \brief Robots Stores the number of robot transponders.
+    ///
+    unsigned int Robots;
+    ///
+    /// \brief BroadcastLoss Stores the probability that a robot misses a broadcast.
+    ///
+    double BroadcastLoss;
+    ///
+    /// \brief UnicastLoss Stores the probability that a unicast attempt is lost, in either direction.
+    ///
+    double UnicastLoss;
+    ///
+    /// \brief Latency Stores the one-way delivery time of a frame over the air, including radio processing.
+    ///
+    uint32_t Latency;
+    ///
+    /// \brief Jitter Stores the maximum random delay added to Latency.
+    ///
+    uint32_t Jitter;
+    ///
+    /// \brief AirTime Stores how long a frame occupies the channel.  Overlapping uplink frames collide.
+    ///
+    uint32_t AirTime;
+    ///
+    /// \brief CarrierSense Stores how long after a frame starts before other radios can hear it.  Robots that start
+    /// within this time of each other collide; later ones wait for the channel to clear.  Set to AirTime for no
+    /// carrier sense at all.
+    ///
+    uint32_t CarrierSense;
+    ///
+    /// \brief ResponseWindow Stores the window over which robots spread their responses to a broadcast, at random.
+    ///
+    uint32_t ResponseWindow;
+    ///
+    /// \brief MacRetries Stores the number of MAC-level retries for acknowledged unicasts.
+    ///
+    byte MacRetries;
+    ///
+    /// \brief RetryBackoff Stores the maximum random backoff before a MAC retry.
+    ///
+    uint32_t RetryBackoff;
+    ///
+    /// \brief LocalLatency Stores the time the local radio takes to answer a local AT command.
+    ///
+    uint32_t LocalLatency;
+    ///
+    /// \brief WriteLatency Stores the time the local radio takes to answer WR.
+    ///
+    uint32_t WriteLatency;
+    ///
+    /// \brief Baud Stores the UART baud rate between the host and the local radio at startup, which must be one BD
+    /// can select.  0 for instant transfers.
+    ///
+    unsigned long Baud;
+    ///
+    /// \brief MaxBaud Stores the fastest baud rate the UART link is clean at.  Faster, it corrupts one byte in 20.  0 for no limit.
+    ///
+    unsigned long MaxBaud;
+    ///
+    /// \brief Seed Stores the random seed.  Runs with the same seed and inputs are identical.
+    ///
+    uint64_t Seed;
+};
+
+///
+/// \brief A simulated robot transponder.
+///
+struct Robot
+{
+    ///
+    /// \brief Address Stores the 64 bit address of the robot's radio.
+    ///
+    byte Address[8];
+    ///
+    /// \brief D1 Stores the robot's D1 register.  5 (Digital Output High) means stopped.
+    ///
+    byte D1;
+    ///
+    /// \brief StoppedAt Stores the time D1 was last set to 5, or 0 if not stopped.
+    ///
+    uint64_t StoppedAt;
+    ///
+    /// \brief BroadcastLoss Stores this robot's broadcast loss probability.
+    ///
+    double BroadcastLoss;
+    ///
+    /// \brief UnicastLoss Stores this robot's unicast loss probability.
+    ///
+    double UnicastLoss;
+    ///
+    /// \brief CommandsReceived Stores the number of remote AT commands the robot received.
+    ///
+    unsigned long CommandsReceived;
+    ///
+    /// \brief PacketsReceived Stores the number of TX payloads the robot received.
+    ///
+    unsigned long PacketsReceived;
+};
+
+///
+/// \brief Counts what happened on the simulated network.
+///
+struct NetworkStats
+{
+    unsigned long FramesFromHost;
+    unsigned long FramesToHost;
+    unsigned long BadFramesFromHost;
+    unsigned long AirTransmissions;
+    unsigned long Collisions;
+    unsigned long Lost;
+    unsigned long UplinkDropped;
+    unsigned long DownlinkFailed;
+    unsigned long ConfigurationWrites;
+    unsigned long BaudChanges;
+    unsigned long long BytesGarbled;
+    unsigned long long BytesFromHost;
+    unsigned long long BytesStalled;
+    unsigned long long BytesToHost;
+};
+
+///
+/// \brief A simulated XBee 900HP in API mode, with a network of robot transponders behind it.
+/// \details Hand this to an estop::xbee in place of Serial1.  It speaks API frames:
+///
+/// - 0x08/0x09 local AT commands, answered with 0x88.  Registers are kept, 0x09 changes are queued until AC or
+///   the next 0x08, AP switches between the unescaped and escaped API modes, and BD changes the radio's baud rate.
+///   AP and BD take effect once their response is out.
+/// - 0x17 remote AT commands, broadcast or unicast to the robots, answered by each robot with 0x97.  Robots keep
+///   their D1 register, and note when it is set to 5.
+/// - 0x00 TX requests, broadcast or unicast, answered with 0x8B if the frame ID is not 0.
+///
+/// The network is a discrete event simulation on host::now_micros(), so it should be run on the virtual clock.
+/// Bytes cross the UART at the host's baud rate (see pHostBaud()) through a 64 byte transmit buffer, as on the 32u4's
+/// Serial1, so writing to a full buffer blocks the host until a byte goes out.  They are lost if it doesn't match the radio's, or
+/// corrupted now and then if it is faster than the link's MaxBaud.  Corruption is always caught by the checksum: the
+/// model never lets it hit the framing.  Robots miss broadcasts at random.  Acknowledged unicasts
+/// and robot responses are retried at the MAC level.  Robots listen before sending, but responses that start too
+/// close together to hear each other collide.  All
+/// randomness comes from the seeded generator, so runs are deterministic.
+///
+class SimulatedXBee : public Stream
+{
+public:
+    // CONSTANTS
+    ///
+    /// \brief TXBufferSize The size of the host's UART transmit buffer, in bytes.
+    ///
+    static const int TXBufferSize = 64;
+
+    ///
+    /// \brief SimulatedXBee Creates a new radio and its network of robots.
+    /// \param Config The network configuration.
+    ///
+    SimulatedXBee(const NetworkConfig& Config);
+
+    // STREAM
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t Value) override;
+    size_t write(const uint8_t* Buffer, size_t Size) override;
+    int availableForWrite() override;
+
+    // METHODS
+    ///
+    /// \brief Service Runs every network event due by the current time.
+    /// \details Called by the Stream methods, so only needed to let time pass without touching the port.
+    ///
+    void Service();
+    ///
+    /// \brief ResetRobots Sets every robot's D1 back to 4 (Digital Output Low), ready for another e-stop.
+    ///
+    void ResetRobots();
+    ///
+    /// \brief SetRobotLoss Overrides the loss probabilities of one robot.
+    ///
+    void SetRobotLoss(unsigned int Index, double BroadcastLoss, double UnicastLoss);
+
+    // PROPERTIES
+    ///
+    /// \brief pRobots PROPERTY Gets the robots.
+    ///
+    const std::vector<Robot>& pRobots() const;
+    ///
+    /// \brief pStats PROPERTY Gets the network counters.
+    ///
+    const NetworkStats& pStats() const;
+    ///
+    /// \brief pRegister PROPERTY Gets a local AT register, or an empty value if it was never set.
+    ///
+    std::vector<byte> pRegister(char AT1, char AT2) const;
+    ///
+    /// \brief pAPMode PROPERTY Gets the local radio's API mode (1 or 2).
+    ///
+    byte pAPMode() const;
+    ///
+    /// \brief pAPMode PROPERTY Sets the local radio's API mode (1 or 2), as if configured beforehand.
+    ///
+    void pAPMode(byte Mode);
+    ///
+    /// \brief pHostBaud PROPERTY Gets the baud rate of the host's side of the UART.
+    ///
+    unsigned long pHostBaud() const;
+    ///
+    /// \brief pHostBaud PROPERTY Sets the baud rate of the host's side of the UART, as Serial1.begin() would.
+    ///
+    void pHostBaud(unsigned long Baud);
+    ///
+    /// \brief pRadioBaud PROPERTY Gets the baud rate the radio's UART is set to by BD.
+    ///
+    unsigned long pRadioBaud() const;
+
+private:
+    ///
+    /// \brief Enumerates the kinds of network event.
+    ///
+    enum class EventType
+    {
+        HostFrame,          ///< A complete API frame from the host has reached the radio.
+        LocalResponse,      ///< The radio answers a local AT command.
+        RobotReceive,       ///< A robot receives a frame from the radio.
+        UplinkStart,        ///< A robot starts sending a frame to the radio.
+        UplinkEnd,          ///< A robot's frame finishes on the air.
+        DownlinkAttempt     ///< The radio makes an attempt at an acknowledged unicast.
+    };
+    ///
+    /// \brief A scheduled network event.
+    ///
+    struct Event
+    {
+        uint64_t Time;
+        uint64_t Order;
+        EventType Type;
+        unsigned int Robot;
+        byte Attempt;
+        size_t Reception;
+        ///
+        /// \brief Baud Stores the radio's new baud rate, for a LocalResponse to BD.  0 for no change.
+        ///
+        unsigned long Baud;
+        std::vector<byte> Data;
+    };
+    struct EventLater
+    {
+        bool operator()(const Event& A, const Event& B) const;
+    };
+    ///
+    /// \brief A frame on its way over the air to the radio.
+    ///
+    struct Reception
+    {
+        uint64_t Start;
+        uint64_t End;
+        bool Collided;
+        bool Active;
+    };
+
+    NetworkConfig mConfig;
+    std::vector<Robot> mRobots;
+    NetworkStats mStats;
+    uint64_t mRandom;
+
+    std::priority_queue<Event, std::vector<Event>, EventLater> mEvents;
+    uint64_t mOrder;
+    ///
+    /// \brief mNow Stores the time of the event being handled.
+    ///
+    uint64_t mNow;
+    std::vector<Reception> mReceptions;
+    std::vector<size_t> mActiveReceptions;
+
+    estop::xbee_parser mParser;
+    bool mParserCorrupt;
+    uint64_t mTXFree;
+    std::deque<std::pair<uint64_t, byte> > mRX;
+    uint64_t mRXFree;
+
+    std::map<uint16_t, std::vector<byte> > mRegisters;
+    std::vector<std::pair<uint16_t, std::vector<byte> > > mQueued;
+    byte mAPMode;
+    unsigned long mHostBaud;
+    unsigned long mRadioBaud;
+
+    // EVENTS
+    void Schedule(uint64_t Time, EventType Type, unsigned int Robot, const std::vector<byte>& Data, byte Attempt = 0, size_t Reception = 0, unsigned long Baud = 0);
+    void HandleHostFrame(const std::vector<byte>& Data);
+    void HandleLocalAT(const std::vector<byte>& Data);
+    void HandleRemoteAT(const std::vector<byte>& Data);
+    void HandleTX(const std::vector<byte>& Data);
+    void HandleRobotReceive(unsigned int Index, const std::vector<byte>& Data);
+    void HandleUplinkStart(const Event& Started);
+    void HandleUplinkEnd(const Event& Ended);
+    void HandleDownlinkAttempt(const Event& Attempt);
+
+    // HELPERS
+    void Emit(const std::vector<byte>& Data, uint64_t Time);
+    uint64_t ByteTime() const;
+    int TXQueued() const;
+    bool Lost() const;
+    bool Corrupted();
+    static unsigned long BaudRate(uint32_t Index);
+    static int BaudIndex(unsigned long Baud);
+    double Uniform();
+    uint32_t Random(uint32_t Maximum);
+    int FindRobot(const byte* Address) const;
+    bool IsBroadcast(const byte* Address) const;
+    std::vector<byte> RemoteResponse(unsigned int Index, byte FrameID, byte AT1, byte AT2, byte Status, const std::vector<byte>& Value) const;
+};
+
+}
+
+#endif // SIMULATEDXBEE_H
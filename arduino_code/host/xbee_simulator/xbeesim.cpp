@@ -0,0 +1,365 @@
+/// \file xbeesim.cpp
+/// \brief Host tool for benchmarking e-stop strategies against a simulated XBee network.
+///
+/// Usage:
+///   xbeesim [--robots n] [--loss p[,p...]] [--unicast-loss p] [--retry on|off|both] [--schedule name|all]
+///           [--rounds n] [--round-ms ms] [--loop-us us] [--baud rate] [--negotiate max] [--max-baud rate] [--ap 1|2]
+///           [--seed n] [--format text|csv]
+///
+/// Each round puts the transmitter into the e-stop state, runs its loop against the simulated network for
+/// --round-ms, and measures how long each robot took to stop.  Rounds are separated by a few idle seconds, and the
+/// robots are reset between them, but the transmitter keeps its census, as it would in a match.  Every combination of
+/// broadcast loss, schedule, and retry strategy is run against the same network, from the same seed.  With --negotiate,
+/// the transmitter first negotiates the UART up from --baud to at most the given rate, as it does at boot; --max-baud
+/// sets the fastest rate the simulated link actually works at.
+#include "SimulatedXBee.h"
+
+#include <broadcast_schedule.h>
+#include <xbee.h>
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+using namespace Sim;
+
+namespace {
+
+struct schedule
+{
+  const char* name;
+  std::vector<estop::broadcast_schedule::phase> phases;
+};
+
+// The schedules to compare.  "burst" is estop_controller::estop_schedule.
+std::vector<schedule> schedules()
+{
+  std::vector<schedule> list(3);
+  const estop::broadcast_schedule::phase steady[] = {{1, 1000, 0}};
+  const estop::broadcast_schedule::phase fast[] = {{1, 100, 10}};
+  const estop::broadcast_schedule::phase burst[] = {{5, 20, 5}, {5, 200, 20}, {1, 1000, 50}};
+  list[0].name = "steady";
+  list[0].phases.assign(steady, steady + 1);
+  list[1].name = "fast";
+  list[1].phases.assign(fast, fast + 1);
+  list[2].name = "burst";
+  list[2].phases.assign(burst, burst + 3);
+  return list;
+}
+
+struct options
+{
+  NetworkConfig network;
+  std::vector<double> losses;
+  std::string retry;
+  std::string schedule;
+  unsigned int rounds;
+  uint32_t round_ms;
+  uint32_t loop_us;
+  unsigned long negotiate;
+  unsigned int ap;
+  bool csv;
+};
+
+struct result
+{
+  std::vector<double> latencies;
+  unsigned long missed;
+  unsigned long broadcasts;
+  unsigned int known;
+  unsigned int overflowed;
+  unsigned long baud;
+  NetworkStats stats;
+};
+
+// Stands in for Serial1.begin() during baud rate negotiation.
+void set_baud(uint32_t baud, void* context)
+{
+  static_cast<SimulatedXBee*>(context)->pHostBaud(baud);
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+  if(sorted.empty())
+  {
+    return 0.0;
+  }
+  size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[index];
+}
+
+// Runs the transmitter's e-stop loop (see estop_controller::spin_once) against a fresh network.
+result run(const options& settings, const NetworkConfig& network, const schedule& plan, bool retry)
+{
+  host::use_virtual_clock(true);
+  host::set_micros(0);
+
+  SimulatedXBee radio(network);
+  radio.pAPMode(static_cast<byte>(settings.ap));
+  estop::xbee transmitter(radio, (settings.ap == 2) ? estop::xbee_parser::api_mode::escaped : estop::xbee_parser::api_mode::unescaped);
+  estop::broadcast_schedule broadcasts(&plan.phases[0], static_cast<uint8_t>(plan.phases.size()));
+
+  result outcome;
+  outcome.missed = 0;
+  outcome.broadcasts = 0;
+  outcome.baud = network.Baud;
+  if(settings.negotiate > 0)
+  {
+    outcome.baud = transmitter.negotiate_baud(&set_baud, &radio, settings.negotiate, false);
+  }
+  for(unsigned int round = 0; round < settings.rounds; round++)
+  {
+    radio.ResetRobots();
+    uint64_t start = host::now_micros();
+    uint64_t end = start + settings.round_ms * 1000ULL;
+    transmitter.begin_estop();
+    broadcasts.restart(millis());
+    while(host::now_micros() < end)
+    {
+      transmitter.spin_once();
+      uint32_t now = millis();
+      if(broadcasts.due(now))
+      {
+        transmitter.broadcast_estop();
+        broadcasts.sent(now);
+        outcome.broadcasts++;
+      }
+      if(retry)
+      {
+        transmitter.retry_estop();
+      }
+      host::advance_micros(settings.loop_us);
+    }
+
+    const std::vector<Robot>& robots = radio.pRobots();
+    for(size_t i = 0; i < robots.size(); i++)
+    {
+      if(robots[i].D1 == 5)
+      {
+        outcome.latencies.push_back((robots[i].StoppedAt - start) / 1000.0);
+      }
+      else
+      {
+        outcome.missed++;
+      }
+    }
+
+    // Let the outstanding responses and requests drain before the next round.
+    uint64_t idle = host::now_micros() + 3000000ULL;
+    while(host::now_micros() < idle)
+    {
+      transmitter.spin_once();
+      host::advance_micros(settings.loop_us);
+    }
+  }
+
+  std::sort(outcome.latencies.begin(), outcome.latencies.end());
+  outcome.known = transmitter.census().count();
+  outcome.overflowed = transmitter.census().overflowed();
+  outcome.stats = radio.pStats();
+  return outcome;
+}
+
+void report(const options& settings, const NetworkConfig& network, const schedule& plan, bool retry, const result& outcome, bool header)
+{
+  const std::vector<double>& latencies = outcome.latencies;
+  double total = static_cast<double>(latencies.size() + outcome.missed);
+  double stopped = (total > 0) ? latencies.size() / total : 0.0;
+  double mean = 0.0;
+  for(size_t i = 0; i < latencies.size(); i++)
+  {
+    mean += latencies[i] / latencies.size();
+  }
+  if(settings.csv)
+  {
+    if(header)
+    {
+      printf("schedule,retry,robots,loss,unicast_loss,baud,rounds,broadcasts_per_round,stopped,mean_ms,p50_ms,p90_ms,p99_ms,max_ms,known,census_overflow,air_frames,collisions,lost,uplink_dropped\n");
+    }
+    printf("%s,%d,%u,%.3f,%.3f,%lu,%u,%.1f,%.4f,%.1f,%.1f,%.1f,%.1f,%.1f,%u,%u,%lu,%lu,%lu,%lu\n", plan.name, retry ? 1 : 0,
+           network.Robots, network.BroadcastLoss, network.UnicastLoss, outcome.baud, settings.rounds,
+           static_cast<double>(outcome.broadcasts) / settings.rounds, stopped, mean,
+           percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+           latencies.empty() ? 0.0 : latencies.back(), outcome.known, outcome.overflowed,
+           outcome.stats.AirTransmissions, outcome.stats.Collisions, outcome.stats.Lost, outcome.stats.UplinkDropped);
+    return;
+  }
+
+  printf("%s schedule, retry %s: %u robots, %u rounds, broadcast loss %.3f, unicast loss %.3f\n", plan.name,
+         retry ? "on" : "off", network.Robots, settings.rounds, network.BroadcastLoss, network.UnicastLoss);
+  printf("  broadcasts:     %.1f per round\n", static_cast<double>(outcome.broadcasts) / settings.rounds);
+  printf("  stopped:        %.2f%% (%lu missed)\n", stopped * 100.0, outcome.missed);
+  printf("  latency:        mean %.1f ms, p50 %.1f ms, p90 %.1f ms, p99 %.1f ms, max %.1f ms\n", mean,
+         percentile(latencies, 0.5), percentile(latencies, 0.9), percentile(latencies, 0.99),
+         latencies.empty() ? 0.0 : latencies.back());
+  printf("  census:         %u known, %u responses dropped (full)\n", outcome.known, outcome.overflowed);
+  printf("  air:            %lu frames, %lu collisions, %lu lost, %lu responses dropped\n", outcome.stats.AirTransmissions,
+         outcome.stats.Collisions, outcome.stats.Lost, outcome.stats.UplinkDropped);
+  printf("  uart:           %lu baud, %llu bytes out, %llu bytes in, %llu garbled, %llu stalled\n", outcome.baud,
+         outcome.stats.BytesFromHost, outcome.stats.BytesToHost, outcome.stats.BytesGarbled, outcome.stats.BytesStalled);
+}
+
+bool parse_losses(const char* value, std::vector<double>& losses)
+{
+  losses.clear();
+  std::string text = value;
+  size_t start = 0;
+  while(start <= text.size())
+  {
+    size_t comma = text.find(',', start);
+    std::string item = text.substr(start, (comma == std::string::npos) ? std::string::npos : comma - start);
+    if(item.empty())
+    {
+      return false;
+    }
+    losses.push_back(atof(item.c_str()));
+    if(comma == std::string::npos)
+    {
+      break;
+    }
+    start = comma + 1;
+  }
+  return !losses.empty();
+}
+
+int usage()
+{
+  fprintf(stderr,
+          "usage: xbeesim [--robots n] [--loss p[,p...]] [--unicast-loss p] [--retry on|off|both] [--schedule steady|fast|burst|all]\n"
+          "               [--rounds n] [--round-ms ms] [--loop-us us] [--baud rate] [--negotiate max] [--max-baud rate] [--ap 1|2]\n"
+          "               [--seed n] [--format text|csv]\n");
+  return 2;
+}
+
+}
+
+// xbee::wait() spins on yield() while negotiating the baud rate.  Let virtual time pass meanwhile.
+void yield()
+{
+  host::advance_micros(100);
+}
+
+int main(int argc, char** argv)
+{
+  options settings;
+  settings.losses.push_back(0.0);
+  settings.retry = "both";
+  settings.schedule = "all";
+  settings.rounds = 20;
+  settings.round_ms = 2000;
+  settings.loop_us = 1000;
+  settings.negotiate = 0;
+  settings.ap = 1;
+  settings.csv = false;
+
+  for(int i = 1; i < argc; i++)
+  {
+    std::string flag = argv[i];
+    if(i + 1 >= argc)
+    {
+      return usage();
+    }
+    const char* value = argv[++i];
+    if(flag == "--robots")
+    {
+      settings.network.Robots = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--loss")
+    {
+      if(!parse_losses(value, settings.losses))
+      {
+        return usage();
+      }
+    }
+    else if(flag == "--unicast-loss")
+    {
+      settings.network.UnicastLoss = atof(value);
+    }
+    else if(flag == "--retry")
+    {
+      settings.retry = value;
+    }
+    else if(flag == "--schedule")
+    {
+      settings.schedule = value;
+    }
+    else if(flag == "--rounds")
+    {
+      settings.rounds = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--round-ms")
+    {
+      settings.round_ms = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--loop-us")
+    {
+      settings.loop_us = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--baud")
+    {
+      settings.network.Baud = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--negotiate")
+    {
+      settings.negotiate = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--max-baud")
+    {
+      settings.network.MaxBaud = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--ap")
+    {
+      settings.ap = strtoul(value, NULL, 0);
+    }
+    else if(flag == "--seed")
+    {
+      settings.network.Seed = strtoull(value, NULL, 0);
+    }
+    else if(flag == "--format")
+    {
+      settings.csv = (std::string(value) == "csv");
+    }
+    else
+    {
+      return usage();
+    }
+  }
+
+  std::vector<schedule> plans;
+  std::vector<schedule> known = schedules();
+  for(size_t i = 0; i < known.size(); i++)
+  {
+    if(settings.schedule == "all" || settings.schedule == known[i].name)
+    {
+      plans.push_back(known[i]);
+    }
+  }
+  if(plans.empty() || (settings.retry != "on" && settings.retry != "off" && settings.retry != "both") ||
+     (settings.ap != 1 && settings.ap != 2) || settings.loop_us == 0 || settings.rounds == 0)
+  {
+    return usage();
+  }
+
+  bool header = true;
+  for(size_t l = 0; l < settings.losses.size(); l++)
+  {
+    NetworkConfig network = settings.network;
+    network.BroadcastLoss = settings.losses[l];
+    for(size_t p = 0; p < plans.size(); p++)
+    {
+      if(settings.retry != "on")
+      {
+        report(settings, network, plans[p], false, run(settings, network, plans[p], false), header);
+        header = false;
+      }
+      if(settings.retry != "off")
+      {
+        report(settings, network, plans[p], true, run(settings, network, plans[p], true), header);
+        header = false;
+      }
+    }
+  }
+  return 0;
+}
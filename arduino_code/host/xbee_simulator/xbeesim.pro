@@ -0,0 +1,20 @@
+TEMPLATE = app
+TARGET = xbeesim
+
+include(../host.pri)
+
+INCLUDEPATH += $$PWD/../../estop_transmitter
+
+SOURCES += \
+    $$PWD/../../estop_transmitter/broadcast_schedule.cpp \
+    $$PWD/../../estop_transmitter/xbee.cpp \
+    $$PWD/../../estop_transmitter/xbee_parser.cpp \
+    $$PWD/../../estop_transmitter/responder_census.cpp \
+    SimulatedXBee.cpp \
+    xbeesim.cpp
+
+HEADERS += \
+    SimulatedXBee.h
+
+# The transmitter's clock, so xbee::uart_supports() rules out the same baud rates it does on the board.
+DEFINES += F_CPU=8000000UL
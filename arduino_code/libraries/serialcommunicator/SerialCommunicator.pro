@@ -15,16 +15,27 @@ INCLUDEPATH += $$PWD\src
 SOURCES += \
     src/Communicator.cpp \
     src/Message.cpp \
+    src/MessageHandle.cpp \
+    src/Capture.cpp \
+    src/LinkQuality.cpp \
     src/utility/Outbound.cpp \
-    src/utility/Inbound.cpp
+    src/utility/OutboundHeap.cpp \
+    src/utility/Inbound.cpp \
+    src/utility/Escape.cpp
 
 HEADERS += \
     src/SerialCommunicator.h \
     src/Communicator.h \
     src/Message.h \
+    src/MessageHandle.h \
+    src/Capture.h \
+    src/LinkQuality.h \
     src/utility/Outbound.h \
+    src/utility/OutboundHeap.h \
     src/utility/Inbound.h \
+    src/utility/Pool.h \
     src/utility/MessageStatus.h \
+    src/utility/Escape.h \
     src/utility/Serialization.h
 
 RESOURCES +=
@@ -0,0 +1,45 @@
+#include "Capture.h"
+
+#include "utility/Serialization.h"
+
+using namespace SC;
+
+// CONSTRUCTORS
+Capture::Capture(Print& Output)
+{
+  Capture::mOutput = &Output;
+  Capture::mEnabled = true;
+}
+
+// METHODS
+void Capture::Begin()
+{
+  const byte Magic[5] = {'S', 'C', 'A', 'P', Capture::cVersion};
+  Capture::Record(Capture::Channel::Session, Magic, 5);
+}
+void Capture::Record(Channel Source, const byte* Frame, unsigned int Length)
+{
+  if(!Capture::mEnabled)
+  {
+    return;
+  }
+
+  // Write the record header, followed by the frame itself.
+  byte Header[Capture::cRecordHeaderLength];
+  Header[0] = static_cast<byte>(Source);
+  Header[1] = 0;
+  SC::Serialize<uint32_t>(Header, 2, micros());
+  SC::Serialize<uint16_t>(Header, 6, Length);
+  Capture::mOutput->write(Header, Capture::cRecordHeaderLength);
+  Capture::mOutput->write(Frame, Length);
+}
+
+// PROPERTIES
+bool Capture::pEnabled()
+{
+  return Capture::mEnabled;
+}
+void Capture::pEnabled(bool Enabled)
+{
+  Capture::mEnabled = Enabled;
+}
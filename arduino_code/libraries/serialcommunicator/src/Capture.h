@@ -0,0 +1,96 @@
+/// \file Capture.h
+/// \brief Defines the SC::Capture class.
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "Arduino.h"
+
+namespace SC {
+
+///
+/// \brief Logs raw link frames to an append-only binary capture.
+/// \details A capture is a flat sequence of records.  Each record is written as:
+///
+///     Channel (1) | Flags (1) | Timestamp (4) | Length (2) | Frame (Length)
+///
+/// All multi-byte fields are big endian, matching the rest of the library.  The timestamp is micros()
+/// at the time of the record, and wraps every ~71 minutes; readers unwrap it by assuming records are in
+/// time order.  Frames are stored unescaped, exactly as they were framed/deframed.
+///
+/// Every call to Begin() writes a Session record whose frame is the magic "SCAP" followed by the format
+/// version, so a capture file that is appended to across several power cycles can still be split
+/// back into sessions.
+///
+class Capture
+{
+public:
+    // ENUMS
+    ///
+    /// \brief Enumerates the channels a record can belong to.
+    ///
+    enum class Channel
+    {
+        Session = 0,    ///< Marks the start of a capture session.  Frame is the magic and format version.
+        SCTX = 1,       ///< A packet transmitted by an SC::Communicator.
+        SCRX = 2,       ///< A packet received by an SC::Communicator.
+        XBeeTX = 3,     ///< An API frame written to an XBee.
+        XBeeRX = 4      ///< An API frame read from an XBee.
+    };
+
+    // CONSTANTS
+    ///
+    /// \brief cVersion Stores the version of the capture format.
+    ///
+    static const byte cVersion = 1;
+    ///
+    /// \brief cRecordHeaderLength Stores the length of the header in front of each record's frame.
+    ///
+    static const byte cRecordHeaderLength = 8;
+
+    // CONSTRUCTORS
+    ///
+    /// \brief Capture Creates a new capture that writes to the given output.
+    /// \param Output The output to append records to (e.g. a serial port or a file).
+    /// \note The capture is enabled on creation, but no session record is written until Begin() is called.
+    ///
+    Capture(Print& Output);
+
+    // METHODS
+    ///
+    /// \brief Begin Writes a session record to mark the start of a new capture session.
+    ///
+    void Begin();
+    ///
+    /// \brief Record Writes a single timestamped frame to the capture.
+    /// \param Source The channel the frame was seen on.
+    /// \param Frame The raw, unescaped frame bytes.
+    /// \param Length The length of the frame in bytes.
+    ///
+    void Record(Channel Source, const byte* Frame, unsigned int Length);
+
+    // PROPERTIES
+    ///
+    /// \brief pEnabled PROPERTY Gets if the capture is currently recording.
+    /// \return TRUE if records are being written, otherwise FALSE.
+    ///
+    bool pEnabled();
+    ///
+    /// \brief pEnabled PROPERTY Sets if the capture is currently recording.
+    /// \param Enabled TRUE to write records, FALSE to drop them.
+    ///
+    void pEnabled(bool Enabled);
+
+private:
+    ///
+    /// \brief mOutput A pointer to the output that records are appended to.
+    ///
+    Print* mOutput;
+    ///
+    /// \brief mEnabled Flag indicating if records are currently being written.
+    ///
+    bool mEnabled;
+};
+
+}
+
+#endif // CAPTURE_H
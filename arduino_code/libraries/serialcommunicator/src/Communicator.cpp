@@ -1,6 +1,7 @@
 #include "Communicator.h"
 
 #include "utility/Serialization.h"
+#include "utility/Escape.h"
 
 using namespace SC;
 
@@ -19,72 +20,83 @@ Communicator::Communicator(Stream& SerialPort)
   Communicator::mSequenceCounter = 0;
   Communicator::mReceiptTimeout = 100;
   Communicator::mTransmitLimit = 5;
+  Communicator::mCapture = NULL;
+  Communicator::mPiggybackAcks = false;
+  Communicator::mAckDelay = 10;
+  Communicator::mNPendingAcks = 0;
+  Communicator::mAckDeadline = 0;
+  Communicator::mMaxBurst = 1;
 
   // Set up queues.
-  Communicator::mTXQ = new Outbound*[Communicator::mQSize];
-  Communicator::mRXQ = new Inbound*[Communicator::mQSize];
-  for(unsigned int i = 0; i < Communicator::mQSize; i++)
-  {
-    Communicator::mTXQ[i] = NULL;
-    Communicator::mRXQ[i] = NULL;
-  }
+  Communicator::mReadyQ = new OutboundHeap(Outbound::SendsBefore, Communicator::mQSize);
+  Communicator::mWaitQ = new OutboundHeap(Outbound::DueBefore, Communicator::mQSize);
+  Communicator::mRXQ = new Inbound[Communicator::mQSize];
+  Communicator::mOutboundPool = new Pool<Outbound>(Communicator::mQSize);
+  Communicator::mMessagePool = new Pool<Message>(Communicator::mQSize);
 }
 Communicator::~Communicator()
 {
   // Clean out the queues.
+  for(unsigned int i = 0; i < Communicator::mReadyQ->pCount(); i++)
+  {
+    delete Communicator::mReadyQ->At(i);
+  }
+  for(unsigned int i = 0; i < Communicator::mWaitQ->pCount(); i++)
+  {
+    delete Communicator::mWaitQ->At(i);
+  }
   for(unsigned int i = 0; i < Communicator::mQSize; i++)
   {
-    if(Communicator::mTXQ[i] != NULL)
-    {
-      delete Communicator::mTXQ[i];
-    }
-    if(Communicator::mRXQ[i] != NULL)
-    {
-      delete Communicator::mRXQ[i];
-    }
+    delete Communicator::mRXQ[i].Unload();
   }
-  delete [] Communicator::mTXQ;
+  delete Communicator::mReadyQ;
+  delete Communicator::mWaitQ;
   delete [] Communicator::mRXQ;
+  delete Communicator::mOutboundPool;
+  delete Communicator::mMessagePool;
 }
 
 // METHODS
-bool Communicator::Send(const Message* Message, bool ReceiptRequired, MessageStatus* Tracker)
+bool Communicator::Send(Message* Message, bool ReceiptRequired, MessageStatus* Tracker)
 {
-    // Find an open spot in the TX queue.
-    for(unsigned int i = 0; i < Communicator::mQSize; i++)
+    // The communicator owns the pointer, so its contents can be moved into the queue.
+    bool Queued = Communicator::Send(static_cast<SC::Message&&>(*Message), ReceiptRequired, Tracker);
+    // Delete the message whether or not it was queued.
+    delete Message;
+    return Queued;
+}
+bool Communicator::Send(Message&& Message, bool ReceiptRequired, MessageStatus* Tracker)
+{
+    // Check for an open spot in the TX queue.
+    if(Communicator::TXQCount() < Communicator::mQSize)
     {
-        if(Communicator::mTXQ[i] == NULL)
-        {
-          // An open space was found.
-          // Create a new outgoing message in the opening.  It's tracker status is automatically set to queued.
-          // Add the sequence number and increment it.
-          Communicator::mTXQ[i] = new Outbound(Message, Communicator::mSequenceCounter++, ReceiptRequired, Tracker);
-
-          // Message was successfully added to the queue.
-          return true;
-        }
+      // Load the message into a pooled outgoing entry in the ready queue.  It's tracker status is automatically set to queued.
+      // Add the sequence number and increment it.
+      Outbound* Entry = Communicator::mOutboundPool->Acquire();
+      Entry->Load(static_cast<SC::Message&&>(Message), Communicator::mSequenceCounter++, ReceiptRequired, Tracker);
+      Communicator::mReadyQ->Push(Entry);
+
+      // Message was successfully added to the queue.
+      return true;
     }
 
     // If this point reached, no spot was found and the message was not added to the outgoing queue.
-    // Delete the message.
-    delete Message;
-    // Return false.
     return false;
 }
 unsigned int Communicator::MessagesAvailable()
 {
-  // Count the amount of non-null ptrs in the RXQ.
+  // Count the amount of occupied slots in the RXQ.
   unsigned int Output = 0;
   for(unsigned int i = 0; i < Communicator::mQSize; i++)
   {
-    if(Communicator::mRXQ[i] != NULL)
+    if(Communicator::mRXQ[i].pMessage() != NULL)
     {
       Output++;
     }
   }
   return Output;
 }
-const Message* Communicator::Receive(unsigned int ID)
+MessageHandle Communicator::Receive(unsigned int ID)
 {
   // Iterate through the RX queue to find the specified message with the highest priority and lowest sequence number.
   Inbound* ToRead = NULL;
@@ -94,31 +106,32 @@ const Message* Communicator::Receive(unsigned int ID)
   {
     // Check to see if there is anything at this position in the RX queue.
     // Also check to see if the message matches the ID.
-    if(Communicator::mRXQ[i] != NULL && (ID == 0xFFFF || Communicator::mRXQ[i]->pMessage()->pID() == ID))
+    Inbound* Slot = &Communicator::mRXQ[i];
+    if(Slot->pMessage() != NULL && (ID == 0xFFFF || Slot->pMessage()->pID() == ID))
     {
       // Check to see if ToRead is empty.
       if(ToRead == NULL)
       {
         // Initialize ToRead with the message at this location.
-        ToRead = Communicator::mRXQ[i];
+        ToRead = Slot;
         RXQLocation = i;
       }
       else
       {
         // Compare ToRead with the inbound message at this location.
-        if(Communicator::mRXQ[i]->pMessage()->pPriority() > ToRead->pMessage()->pPriority())
+        if(Slot->pMessage()->pPriority() > ToRead->pMessage()->pPriority())
         {
           // This location in the RXQ has a higher priority.  Set ToRead.
-          ToRead = Communicator::mRXQ[i];
+          ToRead = Slot;
           RXQLocation = i;
         }
-        else if(Communicator::mRXQ[i]->pMessage()->pPriority() == ToRead->pMessage()->pPriority())
+        else if(Slot->pMessage()->pPriority() == ToRead->pMessage()->pPriority())
         {
           // Proirities are the same.  Choose the inbound message with the earlier sequence number.
-          if(Communicator::mRXQ[i]->pSequenceNumber() < ToRead->pSequenceNumber())
+          if(Slot->pSequenceNumber() < ToRead->pSequenceNumber())
           {
             // This location has the same priority but a lower sequence number.  Set ToRead.
-            ToRead = Communicator::mRXQ[i];
+            ToRead = Slot;
             RXQLocation = i;
           }
         }
@@ -126,15 +139,14 @@ const Message* Communicator::Receive(unsigned int ID)
     }
   }
 
-  // Create a copy of the message pointer to return.
-  const Message* Output = ToRead->pMessage();
-
-  // Remove the inbound message from the queue.
-  delete Communicator::mRXQ[RXQLocation];
-  Communicator::mRXQ[RXQLocation] = NULL;
+  // Check if a message was found.
+  if(ToRead == NULL)
+  {
+    return MessageHandle();
+  }
 
-  // Return the message.
-  return Output;
+  // Remove the message from the queue and hand it to the caller.
+  return MessageHandle(Communicator::mRXQ[RXQLocation].Unload(), Communicator::mMessagePool);
 }
 void Communicator::Spin()
 {
@@ -147,109 +159,94 @@ void Communicator::Spin()
 
 void Communicator::SpinTX()
 {
-  // Send messages.
-  // Scan through the entire TXQ to find the message with the highest priority and lowest sequence number, but is also not awaiting a timestamp.
-  Outbound* ToSend = NULL;
-  unsigned int TXQLocation = 0;
-  for(unsigned int i = 0; i < Communicator::mQSize; i++)
+  // Send up to a burst of messages, sized to the link quality.
+  byte Burst = Communicator::mLinkQuality.BurstSize(Communicator::mMaxBurst);
+  for(byte i = 0; i < Burst; i++)
   {
-    // Check if this address has a valid outbound message in it.
-    if(Communicator::mTXQ[i] != NULL)
+    if(!Communicator::TXNext())
     {
-      // There is an outbound in this position.
-      // Check if this position is a receipt required message stuck waiting for a timeout.
-      if(Communicator::mTXQ[i]->pReceiptRequired() && !Communicator::mTXQ[i]->TimeoutElapsed(Communicator::mReceiptTimeout))
-      {
-        // Skip this position.
-        continue;
-      }
-      // Check if ToSend has a value in it yet.
-      if(ToSend == NULL)
-      {
-        // Update ToSend to the first available value.
-        ToSend = Communicator::mTXQ[i];
-        // Update location so this outbound message can be removed from the queue at the end.
-        TXQLocation = i;
-      }
-      else
-      {
-        // Compare ToSend with the current queued message.
-        if(Communicator::mTXQ[i]->pMessage()->pPriority() > ToSend->pMessage()->pPriority())
-        {
-          // Update ToSend to this higher priority outbound message.
-          ToSend = Communicator::mTXQ[i];
-          // Update location so message can be removed from queue at the end.
-          TXQLocation = i;
-        }
-        else if(Communicator::mTXQ[i]->pMessage()->pPriority() == ToSend->pMessage()->pPriority())
-        {
-          // Priorites are the same.  Find the earliest sequence number.  Don't have to worry about overflow here since messages are sent automatically shortly after queued.
-          if(Communicator::mTXQ[i]->pSequenceNumber() < ToSend->pSequenceNumber())
-          {
-            // Update ToSend to this lower sequence number outbound message.
-            ToSend = Communicator::mTXQ[i];
-            // Update location so message can be removed from queue at the end.
-            TXQLocation = i;
-          }
-        }
-      }
+      break;
     }
   }
+}
+bool Communicator::TXNext()
+{
+  // Send messages.
+  // Candidates are the top of the ready queue (never sent) and the top of the wait queue if its receipt deadline has passed.
+  // Messages still waiting on a receipt sit below the top of the wait queue and are never examined here.
+  Outbound* Ready = Communicator::mReadyQ->Peek();
+  Outbound* Due = Communicator::mWaitQ->Peek();
+  if(Due != NULL && !Due->DeadlineElapsed())
+  {
+    Due = NULL;
+  }
 
-  // At this point, ToSend contains the highest priority, lowest sequence message that is ready to be sent (e.g. not waiting for a timeout).
   // Step 1: Check if there is anything that needs to be sent.
-  if(ToSend != NULL)
+  if(Ready == NULL && Due == NULL)
   {
-    // Step 2: Check if this is the first time the message will be sent.
-    if(ToSend->pNTransmissions() == 0)
-    {
-      // Message has not been sent yet.
-      // Step 2.A.1: Send the message.
-      Communicator::TX(ToSend);
-      // Step 2.A.2: Check if receipt is required.
-      if(ToSend->pReceiptRequired())
-      {
-        // Receipt is required.
-        // Step 2.A.2.A.1: Leave in the TXQ, and update the tracker status.
-        ToSend->UpdateTracker(MessageStatus::Verifying);
-      }
-      else
-      {
-        // Receipt is not required.
-        // Step 2.A.2.B.1: Update tracker status status to sent.
-        ToSend->UpdateTracker(MessageStatus::Sent);
-        // Step 2.A.2.B.2: Remove this outbound message from the queue.
-        delete Communicator::mTXQ[TXQLocation];
-        Communicator::mTXQ[TXQLocation] = NULL;
-      }
+    // Nothing for pending acknowledgements to ride on.  Send them on their own once the delayed ACK timer expires.
+    if(Communicator::mNPendingAcks > 0 && static_cast<long>(millis() - Communicator::mAckDeadline) >= 0)
+    {
+      Communicator::FlushAcks();
+    }
+    return false;
+  }
+
+  // Step 2: Send whichever candidate has the highest priority and lowest sequence number.
+  if(Ready != NULL && (Due == NULL || Outbound::SendsBefore(Ready, Due)))
+  {
+    // Message has not been sent yet.
+    Communicator::mReadyQ->Pop();
+    // Step 2.A.1: Send the message.
+    Communicator::TX(Ready);
+    // Step 2.A.2: Check if receipt is required.
+    if(Ready->pReceiptRequired())
+    {
+      // Receipt is required.
+      // Step 2.A.2.A.1: Move to the wait queue, and update the tracker status.
+      Ready->Schedule(Communicator::mReceiptTimeout);
+      Communicator::mWaitQ->Push(Ready);
+      Ready->UpdateTracker(MessageStatus::Verifying);
     }
     else
     {
-      // Message has been sent at least once.
-      // Step 2.B.1: Check the timout.
-      if(ToSend->TimeoutElapsed(Communicator::mReceiptTimeout))
-      {
-        // Timeout has elapsed.
-        // Step 2.B.1.A.1: Check if the message can be resent.
-        if(ToSend->CanRetransmit(Communicator::mTransmitLimit))
-        {
-          // Message has not hit the maximum send limit.
-          // Step 2.B.1.A.1.A.1: Resend the message.
-          Communicator::TX(ToSend);
-        }
-        else
-        {
-          // Message has been sent the maximum number of times.
-          // Step 2.B.1.A.1.B.1: Update tracker status.
-          ToSend->UpdateTracker(MessageStatus::NotReceived);
-          // Step 2.B.1.A.1.B.2: Remove from the TXQ.
-          delete Communicator::mTXQ[TXQLocation];
-          Communicator::mTXQ[TXQLocation] = NULL;
-        }
-      }
-      // Otherwise don't do anything.  The else case for 2.B.1 should never be reached since messages waiting for timeout are skipped.
+      // Receipt is not required.
+      // Step 2.A.2.B.1: Update tracker status status to sent.
+      Ready->UpdateTracker(MessageStatus::Sent);
+      // Step 2.A.2.B.2: Message is no longer queued.
+      Ready->Unload();
+      Communicator::mOutboundPool->Release(Ready);
     }
   }
+  else
+  {
+    // Message has been sent at least once and the receipt timeout has elapsed.
+    Communicator::mWaitQ->Pop();
+    // Step 2.B.1: Check if the message can be resent.
+    if(Due->CanRetransmit(Communicator::mTransmitLimit))
+    {
+      // Message has not hit the maximum send limit.
+      // Step 2.B.1.A.1: Resend the message and wait for the next deadline, backing off on a lossy link.
+      Communicator::TX(Due);
+      Due->Schedule(Communicator::mLinkQuality.RetryTimeout(Communicator::mReceiptTimeout));
+      Communicator::mWaitQ->Push(Due);
+    }
+    else
+    {
+      // Message has been sent the maximum number of times.
+      // Step 2.B.1.B.1: Update tracker status and the link quality.
+      Due->UpdateTracker(MessageStatus::NotReceived);
+      Communicator::mLinkQuality.Lost();
+      // Step 2.B.1.B.2: Message is no longer queued.
+      Due->Unload();
+      Communicator::mOutboundPool->Release(Due);
+    }
+  }
+  return true;
+}
+unsigned int Communicator::TXQCount()
+{
+  return Communicator::mReadyQ->pCount() + Communicator::mWaitQ->pCount();
 }
 void Communicator::SpinRX()
 {
@@ -268,112 +265,173 @@ void Communicator::SpinRX()
     }
 
     // If this point is reached, a header byte has been found.
-    // Read the next 10 bytes in to ultimately get to the number of data bytes in the message.
-    byte* PKTBytes = new byte[11];
-    unsigned long PKTLength = 11;
-    // Set the first byte of the packet to the header byte.
-    PKTBytes[0] = Communicator::cHeaderByte;
-    // Read in the next ten bytes.
-    if(Communicator::RX(&PKTBytes[1], 10) != 10)
+    // Read the next 5 bytes to get the sequence number and receipt field.
+    byte Front[7];
+    Front[0] = Communicator::cHeaderByte;
+    if(Communicator::RX(&Front[1], 5) != 5)
     {
         // Timeout occured.
         return;
     }
+    // Check for piggybacked acknowledgements, which sit between the receipt field and the message.
+    unsigned long PrefixLength = 6;
+    byte NAcks = 0;
+    if(Front[5] & Communicator::cAckFlag)
+    {
+        if(Communicator::RX(&Front[6], 1) != 1)
+        {
+            // Timeout occured.
+            return;
+        }
+        NAcks = Front[6];
+        PrefixLength = 7;
+    }
+    // The message starts after the acknowledgements.
+    unsigned long MSGAddress = PrefixLength + 4 * static_cast<unsigned long>(NAcks);
+
+    // Read the acknowledgements and the 5 byte message header to ultimately get to the number of data bytes in the message.
+    // Small packets are assembled on the stack.
+    byte Stack[Communicator::cStackPacketLength];
+    unsigned long PKTLength = MSGAddress + 5;
+    byte* PKTBytes = (PKTLength <= Communicator::cStackPacketLength) ? Stack : new byte[PKTLength];
+    for(unsigned long i = 0; i < PrefixLength; i++)
+    {
+        PKTBytes[i] = Front[i];
+    }
+    if(Communicator::RX(&PKTBytes[PrefixLength], PKTLength - PrefixLength) != PKTLength - PrefixLength)
+    {
+        // Timeout occured.
+        if(PKTBytes != Stack)
+        {
+            delete [] PKTBytes;
+        }
+        return;
+    }
 
-    // If this point is reached, the first 11 bytes of the packet have been read.
     // Deserialize NDataBytes.
-    unsigned int NDataBytes = SC::Deserialize<unsigned int>(PKTBytes, 9);
-    // Resize the PKTBytes to accomodate the databytes + checksum.
-    byte* TMPPKT = new byte[PKTLength + NDataBytes + 1];
-    for(unsigned long i = 0; i < PKTLength; i++)
+    unsigned int NDataBytes = SC::Deserialize<uint16_t>(PKTBytes, MSGAddress + 3);
+    // Move the PKTBytes to the heap if the databytes + checksum don't fit on the stack.
+    if(PKTLength + NDataBytes + 1 > Communicator::cStackPacketLength)
     {
-        TMPPKT[i] = PKTBytes[i];
+        byte* TMPPKT = new byte[PKTLength + NDataBytes + 1];
+        for(unsigned long i = 0; i < PKTLength; i++)
+        {
+            TMPPKT[i] = PKTBytes[i];
+        }
+        if(PKTBytes != Stack)
+        {
+            delete [] PKTBytes;
+        }
+        PKTBytes = TMPPKT;
     }
-    delete [] PKTBytes;
-    PKTBytes = TMPPKT;
     PKTLength += NDataBytes + 1;
     // Attempt to read the remainder of the packet.
-    if(Communicator::RX(&PKTBytes[11], NDataBytes + 1) != NDataBytes + 1)
+    if(Communicator::RX(&PKTBytes[MSGAddress + 5], NDataBytes + 1) != NDataBytes + 1)
     {
         // Timeout occured.
+        if(PKTBytes != Stack)
+        {
+            delete [] PKTBytes;
+        }
         return;
     }
 
     // FULL PACKET HAS BEEN READ
 
+    // Log the packet if capturing.
+    if(Communicator::mCapture != NULL)
+    {
+        Communicator::mCapture->Record(Capture::Channel::SCRX, PKTBytes, PKTLength);
+    }
+
     // First, make sure the checksum matches.
     bool ChecksumOK = PKTBytes[PKTLength - 1] == Communicator::Checksum(PKTBytes, PKTLength - 1);
+    Communicator::mLinkQuality.Checked(ChecksumOK);
     // Second, get the sequence number from the packet.
-    unsigned long SequenceNumber = SC::Deserialize<unsigned long>(PKTBytes, 1);
+    unsigned long SequenceNumber = SC::Deserialize<uint32_t>(PKTBytes, 1);
+    Communicator::ReceiptType Receipt = Communicator::ReceiptType(PKTBytes[5] & ~Communicator::cAckFlag);
+
+    // Next, handle any piggybacked acknowledgements.
+    if(ChecksumOK)
+    {
+        for(byte i = 0; i < NAcks; i++)
+        {
+            Communicator::Acknowledge(SC::Deserialize<uint32_t>(PKTBytes, PrefixLength + 4 * i));
+        }
+    }
 
     // Next, handle receipts.
-    switch(Communicator::ReceiptType(PKTBytes[5]))
+    switch(Receipt)
     {
     case Communicator::ReceiptType::NotRequired:
         // Do nothing.
         break;
     case Communicator::ReceiptType::Required:
         {
-            // Send the receipt.
-            // Draft message.
-            byte* Receipt = new byte[12];
-            for(byte i = 0; i < 5; i++)
+            if(ChecksumOK && Communicator::mPiggybackAcks)
             {
-                Receipt[i] = PKTBytes[i];
-            }
-            if(ChecksumOK)
-            {
-                Receipt[5] = (byte)Communicator::ReceiptType::Received;
+                // Hold the receipt so it can ride on the next outgoing message.
+                Communicator::QueueAck(SequenceNumber);
             }
             else
             {
-                Receipt[5] = (byte)Communicator::ReceiptType::ChecksumMismatch;
-            }
-            for(byte i = 6; i < 9; i++)
-            {
-                Receipt[i] = PKTBytes[i];
+                // Send the receipt.
+                // Draft message.
+                byte Receipt[12];
+                for(byte i = 0; i < 5; i++)
+                {
+                    Receipt[i] = PKTBytes[i];
+                }
+                if(ChecksumOK)
+                {
+                    Receipt[5] = (byte)Communicator::ReceiptType::Received;
+                }
+                else
+                {
+                    Receipt[5] = (byte)Communicator::ReceiptType::ChecksumMismatch;
+                }
+                for(byte i = 6; i < 9; i++)
+                {
+                    Receipt[i] = PKTBytes[MSGAddress + i - 6];
+                }
+                Receipt[9] = 0;
+                Receipt[10] = 0;
+                Receipt[11] = Communicator::Checksum(Receipt, 11);
+                // Send message.
+                Communicator::TX(Receipt, 12);
             }
-            Receipt[9] = 0;
-            Receipt[10] = 0;
-            Receipt[11] = Communicator::Checksum(Receipt, 11);
-            // Send message.
-            Communicator::TX(Receipt, 12);
         }
         break;
     case Communicator::ReceiptType::Received:
         {
             if(ChecksumOK)
             {
-                // Remove the associated message from the TXQ if it is still in there.
-                for(byte i = 0; i < Communicator::mQSize; i++)
-                {
-                    if(Communicator::mTXQ[i] != NULL && Communicator::mTXQ[i]->pSequenceNumber() == SequenceNumber)
-                    {
-                        // Update the tracker status.
-                        Communicator::mTXQ[i]->UpdateTracker(MessageStatus::Received);
-                        // Remove from the queue.
-                        delete Communicator::mTXQ[i];
-                        Communicator::mTXQ[i] = NULL;
-                        // Break from the for loop.
-                        break;
-                    }
-                }
+                // Remove the associated message from the wait queue if it is still in there.
+                Communicator::Acknowledge(SequenceNumber);
             }
         }
         break;
     case Communicator::ReceiptType::ChecksumMismatch:
-        // Don't do anything.  This can be used in the future (e.g. immediate retransmit from TXQ instead of waiting for timeout).
+        {
+            if(ChecksumOK)
+            {
+                // The message arrived corrupted.  Retransmit it now instead of waiting for the receipt timeout.
+                Communicator::mLinkQuality.Checked(false);
+                Communicator::Expedite(SequenceNumber);
+            }
+        }
         break;
     }
 
     // Lastly, emplace this as an inbound message.
-    if(ChecksumOK)
+    // Receipts only carry the ID of the message they acknowledge, so they are not inbound messages themselves.
+    if(ChecksumOK && (Receipt == Communicator::ReceiptType::NotRequired || Receipt == Communicator::ReceiptType::Required))
     {
         // Find an open position in the RXQ.
         int Location = -1;
-        for(byte i = 0; i < Communicator::mQSize; i++)
+        for(unsigned int i = 0; i < Communicator::mQSize; i++)
         {
-            if(Communicator::mRXQ[i] == NULL)
+            if(Communicator::mRXQ[i].pMessage() == NULL)
             {
                 Location = i;
                 break;
@@ -381,36 +439,140 @@ void Communicator::SpinRX()
         }
         if(Location >= 0)
         {
-            // Create the message itself.
-            Message* MSG = new Message(PKTBytes, 6);
-            // Add a new Inbound to the RXQ.
-            Communicator::mRXQ[Location] = new Inbound(MSG, SequenceNumber);
+            // Deserialize the message into a pooled instance.
+            Message* MSG = Communicator::mMessagePool->Acquire();
+            *MSG = Message(PKTBytes, MSGAddress);
+            // Load it into the open slot of the RXQ.
+            Communicator::mRXQ[Location].Load(MSG, SequenceNumber);
         }
     }
 
     // Clean up PKTBytes.
-    delete PKTBytes;
+    if(PKTBytes != Stack)
+    {
+        delete [] PKTBytes;
+    }
+}
+void Communicator::Acknowledge(unsigned long SequenceNumber)
+{
+    // Remove the associated message from the wait queue if it is still in there.
+    for(unsigned int i = 0; i < Communicator::mWaitQ->pCount(); i++)
+    {
+        Outbound* Waiting = Communicator::mWaitQ->At(i);
+        if(Waiting->pSequenceNumber() == SequenceNumber)
+        {
+            // Update the tracker status and the link quality.
+            Waiting->UpdateTracker(MessageStatus::Received);
+            Communicator::mLinkQuality.Delivered(Waiting->pNTransmissions());
+            // Remove from the queue.
+            Communicator::mWaitQ->Remove(Waiting);
+            Waiting->Unload();
+            Communicator::mOutboundPool->Release(Waiting);
+            // Break from the for loop.
+            break;
+        }
+    }
+}
+void Communicator::Expedite(unsigned long SequenceNumber)
+{
+    for(unsigned int i = 0; i < Communicator::mWaitQ->pCount(); i++)
+    {
+        Outbound* Waiting = Communicator::mWaitQ->At(i);
+        if(Waiting->pSequenceNumber() == SequenceNumber)
+        {
+            // Move the deadline up to now, and re-insert to restore the heap order.
+            Communicator::mWaitQ->Remove(Waiting);
+            Waiting->Expedite();
+            Communicator::mWaitQ->Push(Waiting);
+            break;
+        }
+    }
+}
+void Communicator::QueueAck(unsigned long SequenceNumber)
+{
+    // Make room if the pending list is full.
+    if(Communicator::mNPendingAcks == Communicator::cMaxPendingAcks)
+    {
+        Communicator::FlushAcks();
+    }
+    // The delayed ACK timer starts with the first pending acknowledgement.
+    if(Communicator::mNPendingAcks == 0)
+    {
+        Communicator::mAckDeadline = millis() + Communicator::mAckDelay;
+    }
+    Communicator::mPendingAcks[Communicator::mNPendingAcks++] = SequenceNumber;
+}
+void Communicator::FlushAcks()
+{
+    // Send all pending acknowledgements in a single standalone receipt.
+    // The first rides in the receipt's sequence field, the rest are piggybacked on the empty receipt message.
+    byte NAcks = Communicator::mNPendingAcks - 1;
+    unsigned long PrefixLength = (NAcks > 0) ? 7 : 6;
+    unsigned long PKTLength = PrefixLength + 4 * static_cast<unsigned long>(NAcks) + 6;
+    byte Stack[Communicator::cStackPacketLength];
+    byte* PKTBytes = (PKTLength <= Communicator::cStackPacketLength) ? Stack : new byte[PKTLength];
+
+    PKTBytes[0] = Communicator::cHeaderByte;
+    SC::Serialize<uint32_t>(PKTBytes, 1, Communicator::mPendingAcks[0]);
+    PKTBytes[5] = (byte)Communicator::ReceiptType::Received;
+    if(NAcks > 0)
+    {
+        PKTBytes[5] |= Communicator::cAckFlag;
+        PKTBytes[6] = NAcks;
+    }
+    for(byte i = 0; i < NAcks; i++)
+    {
+        SC::Serialize<uint32_t>(PKTBytes, PrefixLength + 4 * i, Communicator::mPendingAcks[i + 1]);
+    }
+    // Empty message: ID 0, priority 0, no data.
+    for(unsigned long i = PKTLength - 6; i < PKTLength - 1; i++)
+    {
+        PKTBytes[i] = 0;
+    }
+    PKTBytes[PKTLength - 1] = Communicator::Checksum(PKTBytes, PKTLength - 1);
+
+    Communicator::TX(PKTBytes, PKTLength);
+    Communicator::mNPendingAcks = 0;
+
+    if(PKTBytes != Stack)
+    {
+        delete [] PKTBytes;
+    }
 }
 
 void Communicator::TX(Outbound* Message)
 {
     // Grab the original serialized bytes of the message.
     unsigned long MSGLength = Message->pMessage()->pMessageLength();
-    byte* MSGBytes = new byte[MSGLength];
-    Message->pMessage()->Serialize(MSGBytes);
+
+    // Any pending acknowledgements ride along in front of the message.
+    byte NAcks = Communicator::mNPendingAcks;
+    unsigned long PrefixLength = (NAcks > 0) ? 7 : 6;
+    unsigned long MSGAddress = PrefixLength + 4 * static_cast<unsigned long>(NAcks);
 
     // Create packet byte array.
-    // Add in the message length + 7 bytes of the packet (1 Header, 4 Sequence, 1 Receipt, 1 Checksum)
-    unsigned long PKTLength = MSGLength + 7;
-    byte* PKTBytes = new byte[PKTLength];
+    // Add in the message length + 7 bytes of the packet (1 Header, 4 Sequence, 1 Receipt, 1 Checksum) + any acknowledgements.
+    unsigned long PKTLength = MSGAddress + MSGLength + 1;
+    byte Stack[Communicator::cStackPacketLength];
+    byte* PKTBytes = (PKTLength <= Communicator::cStackPacketLength) ? Stack : new byte[PKTLength];
 
     // Write the front part of the packet.
     PKTBytes[0] = Communicator::cHeaderByte;
-    SC::Serialize<unsigned long>(PKTBytes, 1, Message->pSequenceNumber());
+    SC::Serialize<uint32_t>(PKTBytes, 1, Message->pSequenceNumber());
     PKTBytes[5] = byte(Message->pReceiptRequired());
+    if(NAcks > 0)
+    {
+        PKTBytes[5] |= Communicator::cAckFlag;
+        PKTBytes[6] = NAcks;
+        for(byte i = 0; i < NAcks; i++)
+        {
+            SC::Serialize<uint32_t>(PKTBytes, PrefixLength + 4 * i, Communicator::mPendingAcks[i]);
+        }
+        Communicator::mNPendingAcks = 0;
+    }
 
     // Write the message bytes into the packet.
-    Message->pMessage()->Serialize(PKTBytes, 6);
+    Message->pMessage()->Serialize(PKTBytes, MSGAddress);
 
     // Calculate the CRC.
     // Use length of PTKLength - 1 because the last position in the array is for the checksum itself.
@@ -422,12 +584,19 @@ void Communicator::TX(Outbound* Message)
     // Call the Sent method on the outbound message to update timestamps and counters.
     Message->Sent();
 
-    // Delete the packet and message bytes.
-    delete [] MSGBytes;
-    delete [] PKTBytes;
+    // Delete the packet bytes.
+    if(PKTBytes != Stack)
+    {
+        delete [] PKTBytes;
+    }
 }
 void Communicator::TX(byte *Packet, unsigned long Length)
 {
+    // Log the packet if capturing.
+    if(Communicator::mCapture != NULL)
+    {
+        Communicator::mCapture->Record(Capture::Channel::SCTX, Packet, Length);
+    }
     // Make sure there is enough room in the output buffer.
     while(Communicator::mSerial->availableForWrite() < Length)
     {
@@ -437,16 +606,21 @@ void Communicator::TX(byte *Packet, unsigned long Length)
     // Send header first.
     Communicator::mSerial->write(Packet[0]);
     // Write the rest of the bytes, with escapement.
-    for(unsigned long i = 1; i < Length; i++)
+    // Runs of bytes that don't need escaping are written in bulk.
+    unsigned long i = 1;
+    while(i < Length)
     {
-        if(Packet[i] == Communicator::cHeaderByte || Packet[i] == Communicator::cEscapeByte)
+        unsigned long Run = SC::FindEscape(&Packet[i], Length - i, Communicator::cHeaderByte, Communicator::cEscapeByte);
+        if(Run > 0)
         {
-            Communicator::mSerial->write(Communicator::cEscapeByte);
-            Communicator::mSerial->write(Packet[i] - 1);
+            Communicator::mSerial->write(&Packet[i], Run);
+            i += Run;
         }
-        else
+        if(i < Length)
         {
-            Communicator::mSerial->write(Packet[i]);
+            byte Escaped[2] = {Communicator::cEscapeByte, static_cast<byte>(Packet[i] - 1)};
+            Communicator::mSerial->write(Escaped, 2);
+            i++;
         }
     }
 }
@@ -458,35 +632,44 @@ unsigned long Communicator::RX(byte *Buffer, unsigned long Length)
     unsigned long CurrentLength = 0;
     while(CurrentLength < Length)
     {
-        // Read current available bytes.
+        // Read current available bytes straight into the unused end of the buffer.
+        // Escaped bytes only ever shrink when unescaped, so they can be unescaped in place.
         unsigned long RemainingLength = Length - CurrentLength;
-        byte* TempBuffer = new byte[RemainingLength];
-        unsigned int NRead = Communicator::mSerial->readBytes(TempBuffer, RemainingLength);
+        unsigned int NRead = Communicator::mSerial->readBytes(&Buffer[CurrentLength], RemainingLength);
         if(NRead < RemainingLength)
         {
             // Serial port timed out, quit.
             return 0;
         }
-        // Read through temporary buffer and extract bytes into the actual buffer.
-        for(unsigned long i = 0; i < RemainingLength; i++)
+        unsigned long Read = CurrentLength;
+        unsigned long End = CurrentLength + RemainingLength;
+        while(Read < End)
         {
-            if(TempBuffer[i] == Communicator::cEscapeByte)
+            if(UnescapeNext && Buffer[Read] != Communicator::cEscapeByte)
             {
-                // Mark escape flag.
-                UnescapeNext = true;
+                // Unescaping is adding 1 to the value.
+                Buffer[CurrentLength++] = Buffer[Read++] + 1;
+                UnescapeNext = false;
+                continue;
             }
-            else
+            // Move the run of bytes up to the next escape byte down into place.
+            unsigned long Run = SC::FindEscape(&Buffer[Read], End - Read, Communicator::cEscapeByte, Communicator::cEscapeByte);
+            if(Run > 0)
             {
-                // Copy the byte.
-                // Unescaping is adding 1 to the value.  Can use cast of Unescape flag.
-                Buffer[CurrentLength++] = TempBuffer[i] + static_cast<byte>(UnescapeNext);
-                // Set unescape flag.
-                UnescapeNext = false;
+                if(CurrentLength != Read)
+                {
+                    memmove(&Buffer[CurrentLength], &Buffer[Read], Run);
+                }
+                CurrentLength += Run;
+                Read += Run;
+            }
+            if(Read < End)
+            {
+                // Skip the escape byte and mark the escape flag.
+                Read++;
+                UnescapeNext = true;
             }
         }
-
-        // Delete temp buffer.
-        delete [] TempBuffer;
     }
 
     return CurrentLength;
@@ -513,30 +696,37 @@ void Communicator::pQueueSize(unsigned int Length)
     {
         // Need to resize the queues.
 
-        // Create temporary queues.
-        Outbound** TMPTXQ = new Outbound*[Length];
-        Inbound** TMPRXQ = new Inbound*[Length];
+        // Resize the TX queues.  These keep any messages already queued.
+        Communicator::mReadyQ->pCapacity(Length);
+        Communicator::mWaitQ->pCapacity(Length);
 
-        // Fill the temporary queues.
+        // Create temporary RX queue.  Its slots start out empty.
+        Inbound* TMPRXQ = new Inbound[Length];
+
+        // Fill the temporary queue.
         for(unsigned int i = 0; i < min(Length, Communicator::mQSize); i++)
         {
-            TMPTXQ[i] = Communicator::mTXQ[i];
-            TMPRXQ[i] = Communicator::mRXQ[i];
+            Message* MSG = Communicator::mRXQ[i].Unload();
+            if(MSG != NULL)
+            {
+                TMPRXQ[i].Load(MSG, Communicator::mRXQ[i].pSequenceNumber());
+            }
         }
 
-        // Check if the rest of the temporary queue needs to be NULLED out.
-        for(unsigned int i = Communicator::mQSize; i < Length; i++)
+        // Drop any messages that no longer fit.
+        for(unsigned int i = Length; i < Communicator::mQSize; i++)
         {
-            TMPTXQ[i] = NULL;
-            TMPRXQ[i] = NULL;
+            delete Communicator::mRXQ[i].Unload();
         }
 
-        // Replace the queues.
-        delete [] Communicator::mTXQ;
+        // Replace the queue.
         delete [] Communicator::mRXQ;
-        Communicator::mTXQ = TMPTXQ;
         Communicator::mRXQ = TMPRXQ;
 
+        // Resize the pools to match.
+        Communicator::mOutboundPool->pCapacity(Length);
+        Communicator::mMessagePool->pCapacity(Length);
+
         // Update the QSize.
         Communicator::mQSize = Length;
     }
@@ -557,3 +747,44 @@ void Communicator::pMaxRetries(unsigned int Retries)
 {
     Communicator::mTransmitLimit = Retries;
 }
+bool Communicator::pPiggybackAcks()
+{
+    return Communicator::mPiggybackAcks;
+}
+void Communicator::pPiggybackAcks(bool Enabled)
+{
+    // Don't strand acknowledgements that are already being held.
+    if(!Enabled && Communicator::mNPendingAcks > 0)
+    {
+        Communicator::FlushAcks();
+    }
+    Communicator::mPiggybackAcks = Enabled;
+}
+unsigned long Communicator::pAckDelay()
+{
+    return Communicator::mAckDelay;
+}
+void Communicator::pAckDelay(unsigned long Delay)
+{
+    Communicator::mAckDelay = Delay;
+}
+Capture* Communicator::pCapture()
+{
+    return Communicator::mCapture;
+}
+void Communicator::pCapture(Capture* Tap)
+{
+    Communicator::mCapture = Tap;
+}
+const LinkQuality* Communicator::pLinkQuality()
+{
+    return &(Communicator::mLinkQuality);
+}
+byte Communicator::pMaxBurst()
+{
+    return Communicator::mMaxBurst;
+}
+void Communicator::pMaxBurst(byte Burst)
+{
+    Communicator::mMaxBurst = (Burst > 0) ? Burst : 1;
+}
@@ -4,11 +4,16 @@
 #include "Arduino.h"
 
 #include "Message.h"
+#include "MessageHandle.h"
+#include "Capture.h"
+#include "LinkQuality.h"
 /// \file Communicator.h
 /// \brief Defines the SC::Communicator class.
 #include "utility/MessageStatus.h"
 #include "utility/Inbound.h"
 #include "utility/Outbound.h"
+#include "utility/OutboundHeap.h"
+#include "utility/Pool.h"
 
 ///
 /// \brief Contains all code related to the SerialCommunicator library.
@@ -41,7 +46,19 @@ public:
     /// by earliest.  The calling code can keep track of the message's status using the Tracker parameter.  The Communicator will update the Tracker
     /// pointer as the message's status changes.  Once placed in the queue, the message's status is set to SC::MessageStatus::Queued.
     ///
-    bool Send(const Message* Message, bool ReceiptRequired = false, MessageStatus* Tracker = NULL);
+    /// \note The Communicator takes ownership of the Message pointer, and deletes it even if it could not be queued.
+    ///
+    bool Send(Message* Message, bool ReceiptRequired = false, MessageStatus* Tracker = NULL);
+    ///
+    /// \brief Send Sends a message, moving it into the TX queue.
+    /// \param Message The message to send.  Its contents are moved into the queue, leaving it empty.
+    /// \param ReceiptRequired OPTIONAL Indicates that the message should be retransmitted until a receipt is received from the endpoint.  Defaults to FALSE.
+    /// \param Tracker OPTIONAL A pointer to a tracker for continuous updates on the sent message's status. Defaults to NULL (e.g. no tracking).
+    /// \return Returns TRUE if the message was queued into the TX queue.  Returns FALSE if the TX queue is full, in which case the message is left untouched.
+    /// \details Queue entries are pooled and small messages store their data inline, so once the queue has warmed up
+    /// sending a small message does not touch the heap.
+    ///
+    bool Send(Message&& Message, bool ReceiptRequired = false, MessageStatus* Tracker = NULL);
     ///
     /// \brief MessagesAvailable Counts the number of messages available to read in the RX queue.
     /// \return The number of available messages.
@@ -50,16 +67,16 @@ public:
     ///
     /// \brief Receive Receives the next message from the RX queue.
     /// \param ID OPTIONAL The ID of the next message to receive.  Defaults to 0xFFFF, which will receive any ID.
-    /// \return A pointer to the received message.  Will return NULL if no messages are available.
-    /// \note The calling code shall become responsible for the Message pointer and must clean up the Message's resources.
+    /// \return A handle to the received message.  The handle is empty (evaluates to FALSE) if no matching messages are available.
+    /// \note The message is returned to the Communicator's pool when the handle goes out of scope.
     /// \details Messages are ordered by highest priority, followed by earliest received.
     ///
-    const Message* Receive(unsigned int ID = 0xFFFF);
+    MessageHandle Receive(unsigned int ID = 0xFFFF);
     ///
     /// \brief Spin Performs the Communicator's regular duties.
     /// \note This should be called regularly in the main loop of your code.
-    /// \details A single spin operation will only attempt to send and recieve one Message.
-    /// This is to prevent the Spin method from severely blocking the main loop of the calling code.
+    /// \details A single spin operation will only attempt to recieve one Message, and to send one Message or a
+    /// short burst of them (see pMaxBurst()).  This is to prevent the Spin method from severely blocking the main loop of the calling code.
     ///
     void Spin();
 
@@ -126,6 +143,66 @@ public:
     /// \note The default value is 5 transmissions.
     ///
     void pMaxRetries(unsigned int Retries);
+    ///
+    /// \brief pPiggybackAcks PROPERTY Gets if receipts are piggybacked on outgoing messages.
+    /// \return TRUE if piggybacked receipts are enabled, otherwise FALSE.
+    ///
+    bool pPiggybackAcks();
+    ///
+    /// \brief pPiggybackAcks PROPERTY Sets if receipts are piggybacked on outgoing messages.
+    /// \param Enabled TRUE to enable piggybacked receipts.
+    /// \details When enabled, receipts for received messages are held for up to pAckDelay() milliseconds
+    /// and sent in the header of the next outgoing message instead of in a frame of their own.  If nothing
+    /// is sent before the delay expires, all held receipts are sent together in a single standalone receipt.
+    /// Receipts for messages with a checksum mismatch are always sent immediately.
+    /// \note Both Communicators must enable this, since the piggybacked header is not understood by older
+    /// versions.  Any Communicator can receive piggybacked receipts.  The default value is FALSE.
+    ///
+    void pPiggybackAcks(bool Enabled);
+    ///
+    /// \brief pAckDelay PROPERTY Gets how long a receipt may be held waiting for an outgoing message.
+    /// \return The delay in milliseconds.
+    ///
+    unsigned long pAckDelay();
+    ///
+    /// \brief pAckDelay PROPERTY Sets how long a receipt may be held waiting for an outgoing message.
+    /// \param Delay The delay in milliseconds.
+    /// \details Only used when pPiggybackAcks() is enabled.  Should be well under the sender's pReceiptTimeout().
+    /// \note The default value is 10ms.
+    ///
+    void pAckDelay(unsigned long Delay);
+    ///
+    /// \brief pCapture PROPERTY Gets the capture that raw packets are logged to.
+    /// \return A pointer to the capture, or NULL if packets are not being captured.
+    ///
+    Capture* pCapture();
+    ///
+    /// \brief pCapture PROPERTY Sets the capture that raw packets are logged to.
+    /// \param Tap A pointer to the capture to log to.  Set to NULL to stop capturing.
+    /// \details Every packet transmitted and every complete packet received is logged, unescaped, to the
+    /// capture.  The Communicator does not take ownership of the capture.
+    /// \note The default value is NULL (e.g. no capture).
+    ///
+    void pCapture(Capture* Tap);
+    ///
+    /// \brief pLinkQuality PROPERTY Gets the Communicator's estimate of the link quality.
+    /// \return A pointer to the estimate.  It is updated as receipts arrive, time out, or report checksum mismatches.
+    /// \details The receipt timeout is scaled by the estimated ETX before each retransmit, so retries back off on a
+    /// lossy link, and the burst size is scaled down by the estimated quality.  Only messages sent with a receipt
+    /// required contribute to the ETX.
+    ///
+    const LinkQuality* pLinkQuality();
+    ///
+    /// \brief pMaxBurst PROPERTY Gets the most messages sent back to back in a single spin.
+    /// \return The maximum burst size.
+    ///
+    byte pMaxBurst();
+    ///
+    /// \brief pMaxBurst PROPERTY Sets the most messages sent back to back in a single spin.
+    /// \param Burst The maximum burst size, used on a perfect link.  The actual burst shrinks as the link quality drops.
+    /// \note The default value is 1 message.
+    ///
+    void pMaxBurst(byte Burst);
 
 protected:
     // ENUMS
@@ -149,6 +226,20 @@ protected:
     /// \brief cEscapeByte Stores the escape byte flag.
     ///
     static const byte cEscapeByte = 0x1B;
+    ///
+    /// \brief cAckFlag Flag in the receipt field indicating that piggybacked acknowledgements follow.
+    /// \details When set, the receipt field is followed by a count byte and that many 4 byte sequence numbers
+    /// being acknowledged, ahead of the message itself.
+    ///
+    static const byte cAckFlag = 0x80;
+    ///
+    /// \brief cMaxPendingAcks Stores the maximum number of receipts that can be held for piggybacking.
+    ///
+    static const byte cMaxPendingAcks = 8;
+    ///
+    /// \brief cStackPacketLength Stores the largest packet that is assembled on the stack instead of the heap.
+    ///
+    static const unsigned int cStackPacketLength = 32;
 
     // ATTRIBUTES
     ///
@@ -172,15 +263,61 @@ protected:
     /// \brief mTransmitLimit Stores the max number of transmits.
     ///
     byte mTransmitLimit;
+    ///
+    /// \brief mCapture A pointer to the capture that raw packets are logged to.  NULL if not capturing.
+    ///
+    Capture* mCapture;
+    ///
+    /// \brief mPiggybackAcks Flag indicating if receipts are piggybacked on outgoing messages.
+    ///
+    bool mPiggybackAcks;
+    ///
+    /// \brief mAckDelay Stores how long a receipt may be held, in milliseconds.
+    ///
+    unsigned long mAckDelay;
+    ///
+    /// \brief mPendingAcks Stores the sequence numbers of receipts being held for piggybacking.
+    ///
+    uint32_t mPendingAcks[cMaxPendingAcks];
+    ///
+    /// \brief mNPendingAcks Stores the number of receipts being held.
+    ///
+    byte mNPendingAcks;
+    ///
+    /// \brief mAckDeadline Stores the time at which held receipts must be sent on their own.
+    ///
+    unsigned long mAckDeadline;
+    ///
+    /// \brief mLinkQuality Stores the estimate of the link quality.
+    ///
+    LinkQuality mLinkQuality;
+    ///
+    /// \brief mMaxBurst Stores the most messages sent back to back in a single spin.
+    ///
+    byte mMaxBurst;
 
     ///
-    /// \brief mTXQ The internal TX queue.
+    /// \brief mReadyQ The internal TX queue of messages that have not been transmitted yet.
+    /// \details Ordered by highest priority, followed by lowest sequence number.
+    ///
+    OutboundHeap* mReadyQ;
+    ///
+    /// \brief mWaitQ The internal TX queue of transmitted messages that are waiting for a receipt.
+    /// \details Ordered by earliest retransmit deadline, so only messages that are actually due are examined during a spin.
+    ///
+    OutboundHeap* mWaitQ;
     ///
-    Outbound** mTXQ;
+    /// \brief mRXQ The internal RX queue.  Slots without a message are free.
     ///
-    /// \brief mRXQ The internal RX queue.
+    Inbound* mRXQ;
     ///
-    Inbound** mRXQ;
+    /// \brief mOutboundPool Recycles the TX queue's entries.
+    ///
+    Pool<Outbound>* mOutboundPool;
+    ///
+    /// \brief mMessagePool Recycles received messages once their handles are released.
+    ///
+    Pool<Message>* mMessagePool;
 
     // METHODS
     ///
@@ -188,10 +325,39 @@ protected:
     ///
     void SpinTX();
     ///
+    /// \brief TXNext Sends the next message due in the TX queues, if any.
+    /// \return TRUE if a message was sent, FALSE if nothing was due.
+    ///
+    bool TXNext();
+    ///
+    /// \brief TXQCount Counts the number of messages currently held in the TX queues.
+    /// \return The number of queued and unreceipted messages.
+    ///
+    unsigned int TXQCount();
+    ///
     /// \brief SpinRX Conducts the RX duties during a spin cycle.
     ///
     void SpinRX();
     ///
+    /// \brief Acknowledge Marks a waiting message as received and removes it from the wait queue.
+    /// \param SequenceNumber The sequence number of the acknowledged message.
+    ///
+    void Acknowledge(unsigned long SequenceNumber);
+    ///
+    /// \brief Expedite Makes a waiting message due for retransmission immediately.
+    /// \param SequenceNumber The sequence number of the message.
+    ///
+    void Expedite(unsigned long SequenceNumber);
+    ///
+    /// \brief QueueAck Holds a receipt so it can be piggybacked on the next outgoing message.
+    /// \param SequenceNumber The sequence number of the received message.
+    ///
+    void QueueAck(unsigned long SequenceNumber);
+    ///
+    /// \brief FlushAcks Sends all held receipts in a single standalone receipt.
+    ///
+    void FlushAcks();
+    ///
     /// \brief TX Facilitates the serialization and sending of a message via serial.
     /// \param Message The outbound message to transmit.
     ///
@@ -0,0 +1,95 @@
+#include "LinkQuality.h"
+
+using namespace SC;
+
+// CONSTRUCTORS
+LinkQuality::LinkQuality()
+{
+    LinkQuality::Reset();
+}
+
+// METHODS
+void LinkQuality::Reset()
+{
+    LinkQuality::mETX = LinkQuality::cOne;
+    LinkQuality::mErrorRate = 0;
+    LinkQuality::mSamples = 0;
+}
+void LinkQuality::Delivered(byte Transmissions)
+{
+    // A receipted message was sent at least once, and counts as no worse than a lost one.
+    if(Transmissions == 0)
+    {
+        Transmissions = 1;
+    }
+    else if(Transmissions > LinkQuality::cMaxETX)
+    {
+        Transmissions = LinkQuality::cMaxETX;
+    }
+    LinkQuality::Average(LinkQuality::mETX, static_cast<unsigned long>(Transmissions) * LinkQuality::cOne);
+    LinkQuality::Count();
+}
+void LinkQuality::Lost()
+{
+    LinkQuality::Average(LinkQuality::mETX, static_cast<unsigned long>(LinkQuality::cMaxETX) * LinkQuality::cOne);
+    LinkQuality::Count();
+}
+void LinkQuality::Checked(bool ChecksumOK)
+{
+    LinkQuality::Average(LinkQuality::mErrorRate, ChecksumOK ? 0 : 0xFFFF);
+    LinkQuality::Count();
+}
+unsigned long LinkQuality::RetryTimeout(unsigned long Timeout) const
+{
+    // Scale by ETX, capped at 4x.  Split the multiply so that long timeouts don't overflow.
+    unsigned long Scale = min(LinkQuality::mETX, 4 * LinkQuality::cOne);
+    return (Timeout / LinkQuality::cOne) * Scale + ((Timeout % LinkQuality::cOne) * Scale) / LinkQuality::cOne;
+}
+byte LinkQuality::BurstSize(byte Maximum) const
+{
+    unsigned int Burst = (static_cast<unsigned int>(Maximum) * LinkQuality::pPercent() + 50) / 100;
+    return (Burst > 0) ? static_cast<byte>(Burst) : 1;
+}
+
+// PROPERTIES
+unsigned int LinkQuality::pETX() const
+{
+    return LinkQuality::mETX;
+}
+unsigned int LinkQuality::pErrorRate() const
+{
+    return LinkQuality::mErrorRate;
+}
+byte LinkQuality::pPercent() const
+{
+    // Delivery ratio (cOne / ETX) times the fraction of packets without errors, as a percentage.
+    unsigned long Numerator = 100UL * LinkQuality::cOne * (0xFFFFUL - LinkQuality::mErrorRate);
+    unsigned long Denominator = static_cast<unsigned long>(LinkQuality::mETX) * 0xFFFFUL;
+    return static_cast<byte>(Numerator / Denominator);
+}
+unsigned int LinkQuality::pSamples() const
+{
+    return LinkQuality::mSamples;
+}
+
+// PRIVATE METHODS
+void LinkQuality::Average(unsigned int& Value, unsigned long Sample)
+{
+    // Move 1/8th of the way toward the sample, rounding away from the average so it can always reach the sample.
+    const unsigned long Round = (1UL << LinkQuality::cShift) - 1;
+    if(Sample > Value)
+    {
+        Value += static_cast<unsigned int>((Sample - Value + Round) >> LinkQuality::cShift);
+    }
+    else
+    {
+        Value -= static_cast<unsigned int>((Value - Sample + Round) >> LinkQuality::cShift);
+    }
+}
+void LinkQuality::Count()
+{
+    if(LinkQuality::mSamples < 0xFFFF)
+    {
+        LinkQuality::mSamples++;
+    }
+}
@@ -0,0 +1,128 @@
+/// \file LinkQuality.h
+/// \brief Defines the SC::LinkQuality class.
+#ifndef LINKQUALITY_H
+#define LINKQUALITY_H
+
+#include "Arduino.h"
+
+namespace SC {
+
+///
+/// \brief A rolling estimate of link quality, built from receipt and retransmit history.
+/// \details Tracks two exponentially weighted moving averages in fixed point, so queries are cheap:
+///
+/// - ETX: the expected number of transmissions per delivered frame.  Each message that gets a receipt
+///   contributes the number of times it was sent; each message that is given up on contributes cMaxETX.
+/// - Error rate: the fraction of received packets, and of receipts, that report a checksum mismatch.
+///
+/// Each SC::Communicator keeps one of these, fed by its receipts, and uses it to scale its retry timeout and
+/// the number of messages it sends per spin.  It starts out assuming a perfect link.
+///
+class LinkQuality
+{
+public:
+    // CONSTANTS
+    ///
+    /// \brief cOne Stores the fixed point value of 1.0 for pETX().
+    ///
+    static const unsigned int cOne = 256;
+    ///
+    /// \brief cMaxETX Stores the ETX sample recorded for a message that was never delivered.
+    ///
+    static const byte cMaxETX = 16;
+    ///
+    /// \brief cShift Stores the weight of new samples in the moving averages, as a power of two (1/8).
+    ///
+    static const byte cShift = 3;
+
+    // CONSTRUCTORS
+    ///
+    /// \brief LinkQuality Creates a new estimate of a perfect link.
+    ///
+    LinkQuality();
+
+    // METHODS
+    ///
+    /// \brief Reset Forgets all history, returning to the estimate of a perfect link.
+    ///
+    void Reset();
+    ///
+    /// \brief Delivered Records that a message was receipted.
+    /// \param Transmissions The number of times the message was sent.
+    ///
+    void Delivered(byte Transmissions);
+    ///
+    /// \brief Lost Records that a message was given up on without a receipt.
+    ///
+    void Lost();
+    ///
+    /// \brief Checked Records the checksum result of a received packet or receipt.
+    /// \param ChecksumOK TRUE if the checksum matched.
+    ///
+    void Checked(bool ChecksumOK);
+    ///
+    /// \brief RetryTimeout Scales a receipt timeout by the current ETX.
+    /// \param Timeout The receipt timeout on a perfect link.
+    /// \return The timeout to wait before retransmitting, between 1 and 4 times the given timeout.
+    /// \details On a lossy link, waiting longer between retransmits keeps them from piling onto a congested link.
+    ///
+    unsigned long RetryTimeout(unsigned long Timeout) const;
+    ///
+    /// \brief BurstSize Scales the number of messages to send back to back by the current link quality.
+    /// \param Maximum The burst size on a perfect link.
+    /// \return The burst size to use, between 1 and Maximum.
+    ///
+    byte BurstSize(byte Maximum) const;
+
+    // PROPERTIES
+    ///
+    /// \brief pETX PROPERTY Gets the expected transmissions per delivered message.
+    /// \return The ETX in fixed point, where cOne (256) is 1.0.
+    ///
+    unsigned int pETX() const;
+    ///
+    /// \brief pErrorRate PROPERTY Gets the rate of checksum mismatches.
+    /// \return The error rate in fixed point, where 65535 is 100%.
+    ///
+    unsigned int pErrorRate() const;
+    ///
+    /// \brief pPercent PROPERTY Gets the overall link quality as a percentage.
+    /// \return 100 on a perfect link, falling as ETX and the error rate rise.
+    /// \details Computed as the delivery ratio (1/ETX) scaled by the fraction of error-free packets.
+    ///
+    byte pPercent() const;
+    ///
+    /// \brief pSamples PROPERTY Gets the number of samples recorded, saturating at 65535.
+    /// \return The number of samples.  Zero means the estimate is still the initial guess.
+    ///
+    unsigned int pSamples() const;
+
+private:
+    ///
+    /// \brief mETX Stores the ETX moving average, in fixed point with cOne as 1.0.
+    ///
+    unsigned int mETX;
+    ///
+    /// \brief mErrorRate Stores the error rate moving average, in fixed point with 65535 as 100%.
+    ///
+    unsigned int mErrorRate;
+    ///
+    /// \brief mSamples Stores the number of samples recorded.
+    ///
+    unsigned int mSamples;
+
+    ///
+    /// \brief Average Moves a fixed point moving average toward a sample.
+    /// \param Value The moving average to update.
+    /// \param Sample The new sample, in the same fixed point scale.
+    ///
+    static void Average(unsigned int& Value, unsigned long Sample);
+    ///
+    /// \brief Count Increments the sample count.
+    ///
+    void Count();
+};
+
+}
+
+#endif // LINKQUALITY_H
@@ -3,48 +3,69 @@
 using namespace SC;
 
 // CONSTRUCTORS
+Message::Message()
+{
+  Message::mID = 0;
+  Message::mPriority = 0;
+  Message::Allocate(0);
+}
 Message::Message(unsigned int ID)
 {
   Message::mID = ID;
   Message::mPriority = 0;
-  Message::mDataLength = 0;
-  Message::mData = NULL;
+  Message::Allocate(0);
 }
 Message::Message(unsigned int ID, unsigned int DataLength)
 {
   Message::mID = ID;
   Message::mPriority = 0;
-  Message::mDataLength = DataLength;
-  Message::mData = new byte[DataLength];
+  Message::Allocate(DataLength);
 }
 Message::Message(const byte* ByteArray, unsigned long Address)
 {
   // Parse out ID, priority, and data length.
-  Message::mID = SC::Deserialize<unsigned int>(ByteArray, Address);
+  Message::mID = SC::Deserialize<uint16_t>(ByteArray, Address);
   Message::mPriority = SC::Deserialize<byte>(ByteArray, Address + 2);
-  Message::mDataLength = SC::Deserialize<unsigned int>(ByteArray, Address + 3);
+  Message::Allocate(SC::Deserialize<uint16_t>(ByteArray, Address + 3));
   // Copy data bytes.
-  Message::mData = new byte[Message::mDataLength];
+  byte* Data = Message::Data();
   for(unsigned int i = 0; i < Message::mDataLength; i++)
   {
-    Message::mData[i] = ByteArray[Address + 5 + i];
+    Data[i] = ByteArray[Address + 5 + i];
   }
 }
+Message::Message(Message&& Other)
+{
+  Message::mDataLength = 0;
+  Message::Take(Other);
+}
+Message& Message::operator=(Message&& Other)
+{
+  if(&Other != this)
+  {
+    Message::Take(Other);
+  }
+  return *this;
+}
 Message::~Message()
 {
-  delete [] Message::mData;
+  if(Message::mDataLength > cInlineLength)
+  {
+    delete [] Message::mHeap;
+  }
 }
 
 // METHODS
 void Message::Serialize(byte* ByteArray, unsigned long Address) const
 {
   // Serialize the message into the byte array.
-  SC::Serialize<unsigned int>(ByteArray, Address, Message::mID);
+  SC::Serialize<uint16_t>(ByteArray, Address, Message::mID);
   SC::Serialize<byte>(ByteArray, Address + 2, Message::mPriority);
-  SC::Serialize<unsigned int>(ByteArray, Address + 3, Message::mDataLength);
+  SC::Serialize<uint16_t>(ByteArray, Address + 3, Message::mDataLength);
+  const byte* Data = Message::Data();
   for(unsigned int i = 0; i < Message::mDataLength; i++)
   {
-    ByteArray[Address + 5 + i] = Message::mData[i];
+    ByteArray[Address + 5 + i] = Data[i];
   }
 }
 
@@ -74,3 +95,40 @@ unsigned long Message::pMessageLength() const
   // Length is ID(2) + Priority(1) + DataLengthIndicator(2) + DataLength(n)
   return 5 + Message::mDataLength;
 }
+
+// PRIVATE METHODS
+void Message::Allocate(unsigned int DataLength)
+{
+  Message::mDataLength = DataLength;
+  if(DataLength > cInlineLength)
+  {
+    Message::mHeap = new byte[DataLength];
+  }
+}
+void Message::Take(Message& Other)
+{
+  // Release current data.
+  if(Message::mDataLength > cInlineLength)
+  {
+    delete [] Message::mHeap;
+  }
+
+  Message::mID = Other.mID;
+  Message::mPriority = Other.mPriority;
+  Message::mDataLength = Other.mDataLength;
+  if(Other.mDataLength > cInlineLength)
+  {
+    // Steal the heap buffer.
+    Message::mHeap = Other.mHeap;
+  }
+  else
+  {
+    for(unsigned int i = 0; i < cInlineLength; i++)
+    {
+      Message::mInline[i] = Other.mInline[i];
+    }
+  }
+
+  // Leave the other message empty.
+  Other.mDataLength = 0;
+}
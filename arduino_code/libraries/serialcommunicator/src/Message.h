@@ -10,10 +10,19 @@
 namespace SC {
 
 /// \brief Represents a single message of data that can be communicated.
+/// \details Data of up to cInlineLength bytes is stored inside the message itself, so small messages never
+/// allocate.  Messages own their data and are move-only: they can be moved into SC::Communicator::Send() or
+/// out of a function, but not copied.
 class Message
 {
 public:
+  // CONSTANTS
+  /// \brief The largest data length that is stored inline, without a heap allocation.
+  static const unsigned int cInlineLength = 4;
+
   // CONSTRUCTORS
+  /// \brief Creates a new, empty message with an ID of 0.
+  Message();
   /// \brief Creates a new message.
   /// \param ID The ID of the message.
   /// \details This creates a new message that has no data and a default priority of 0.
@@ -28,6 +37,17 @@ public:
   /// \param ByteArray The array that contains the serialized message data.
   /// \param Address OPTIONAL The index in the array where the serialized message starts.
   Message(const byte* ByteArray, unsigned long Address = 0);
+  /// \brief Moves a message, leaving the original empty.
+  /// \param Other The message to move from.
+  Message(Message&& Other);
+  /// \brief Moves a message into this one, releasing this message's data and leaving the original empty.
+  /// \param Other The message to move from.
+  /// \return This message.
+  Message& operator=(Message&& Other);
+  /// \brief Messages cannot be copied.
+  Message(const Message&) = delete;
+  /// \brief Messages cannot be copied.
+  Message& operator=(const Message&) = delete;
   /// \brief Destroys the message instance and cleans up resources.
   ~Message();
 
@@ -45,7 +65,7 @@ public:
       return false;
     }
 
-    SC::Serialize<T>(Message::mData, Address, Data);
+    SC::Serialize<T>(Message::Data(), Address, Data);
 
     // Return success.
     return true;
@@ -56,7 +76,7 @@ public:
   template <typename T>
   T GetData(unsigned int Address) const
   {
-    return SC::Deserialize<T>(Message::mData, Address);
+    return SC::Deserialize<T>(Message::Data(), Address);
   }
   /// \brief Serializes the message into a supplied byte array for transmission.
   /// \param ByteArray The array to serialize the message into.
@@ -92,8 +112,22 @@ private:
   byte mPriority;
   /// \brief Stores the message's data length.
   unsigned int mDataLength;
-  /// \brief Stores the message's data bytes.
-  byte* mData;
+  union
+  {
+    /// \brief Stores the message's data bytes when they don't fit inline.
+    byte* mHeap;
+    /// \brief Stores the message's data bytes when there are no more than cInlineLength of them.
+    byte mInline[cInlineLength];
+  };
+
+  /// \brief Gets the message's data bytes, wherever they are stored.
+  byte* Data() { return (Message::mDataLength > cInlineLength) ? Message::mHeap : Message::mInline; }
+  /// \brief Gets the message's data bytes, wherever they are stored.
+  const byte* Data() const { return (Message::mDataLength > cInlineLength) ? Message::mHeap : Message::mInline; }
+  /// \brief Allocates storage for the message's data bytes.
+  void Allocate(unsigned int DataLength);
+  /// \brief Releases the message's data bytes and takes over another message's data, leaving it empty.
+  void Take(Message& Other);
 };
 
 }
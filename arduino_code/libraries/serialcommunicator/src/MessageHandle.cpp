@@ -0,0 +1,68 @@
+#include "MessageHandle.h"
+
+using namespace SC;
+
+// CONSTRUCTORS
+MessageHandle::MessageHandle()
+{
+  MessageHandle::mMessage = NULL;
+  MessageHandle::mOwner = NULL;
+}
+MessageHandle::MessageHandle(Message* Message, Pool<SC::Message>* Owner)
+{
+  MessageHandle::mMessage = Message;
+  MessageHandle::mOwner = Owner;
+}
+MessageHandle::MessageHandle(MessageHandle&& Other)
+{
+  MessageHandle::mMessage = Other.mMessage;
+  MessageHandle::mOwner = Other.mOwner;
+  Other.mMessage = NULL;
+}
+MessageHandle& MessageHandle::operator=(MessageHandle&& Other)
+{
+  if(&Other != this)
+  {
+    MessageHandle::Release();
+    MessageHandle::mMessage = Other.mMessage;
+    MessageHandle::mOwner = Other.mOwner;
+    Other.mMessage = NULL;
+  }
+  return *this;
+}
+MessageHandle::~MessageHandle()
+{
+  MessageHandle::Release();
+}
+
+// METHODS
+void MessageHandle::Release()
+{
+  if(MessageHandle::mMessage != NULL)
+  {
+    // Drop the message's data before pooling it.
+    *MessageHandle::mMessage = Message();
+    MessageHandle::mOwner->Release(MessageHandle::mMessage);
+    MessageHandle::mMessage = NULL;
+  }
+}
+
+// OPERATORS
+MessageHandle::operator bool() const
+{
+  return MessageHandle::mMessage != NULL;
+}
+const Message* MessageHandle::operator->() const
+{
+  return MessageHandle::mMessage;
+}
+const Message& MessageHandle::operator*() const
+{
+  return *MessageHandle::mMessage;
+}
+
+// PROPERTIES
+const Message* MessageHandle::pMessage() const
+{
+  return MessageHandle::mMessage;
+}
@@ -0,0 +1,76 @@
+/// \file MessageHandle.h
+/// \brief Defines the SC::MessageHandle class.
+#ifndef MESSAGEHANDLE_H
+#define MESSAGEHANDLE_H
+
+#include "Arduino.h"
+
+#include "Message.h"
+#include "utility/Pool.h"
+
+namespace SC {
+
+///
+/// \brief An owning handle to a received message.
+/// \details Returned by SC::Communicator::Receive().  The handle gives read access to the message, and
+/// returns it to the Communicator's message pool when the handle is destroyed or released.  An empty handle
+/// (e.g. nothing was available to receive) evaluates to FALSE.  Handles are move-only.
+/// \note Handles must be released before the Communicator that issued them is destroyed.
+///
+class MessageHandle
+{
+public:
+    // CONSTRUCTORS
+    ///
+    /// \brief MessageHandle Creates an empty handle.
+    ///
+    MessageHandle();
+    ///
+    /// \brief MessageHandle Creates a handle that owns a pooled message.
+    /// \param Message The message to own.
+    /// \param Owner The pool the message is returned to.
+    ///
+    MessageHandle(Message* Message, Pool<SC::Message>* Owner);
+    MessageHandle(MessageHandle&& Other);
+    MessageHandle& operator=(MessageHandle&& Other);
+    MessageHandle(const MessageHandle&) = delete;
+    MessageHandle& operator=(const MessageHandle&) = delete;
+    ~MessageHandle();
+
+    // METHODS
+    ///
+    /// \brief Release Returns the message to its pool early, leaving the handle empty.
+    ///
+    void Release();
+
+    // OPERATORS
+    ///
+    /// \brief Checks if the handle holds a message.
+    /// \return TRUE if a message is held, otherwise FALSE.
+    ///
+    explicit operator bool() const;
+    const Message* operator->() const;
+    const Message& operator*() const;
+
+    // PROPERTIES
+    ///
+    /// \brief pMessage PROPERTY Gets the held message.
+    /// \return A pointer to the message, or NULL if the handle is empty.
+    /// \note The pointer is only valid for as long as the handle holds the message.
+    ///
+    const Message* pMessage() const;
+
+private:
+    ///
+    /// \brief mMessage Stores the held message.
+    ///
+    Message* mMessage;
+    ///
+    /// \brief mOwner Stores the pool the message is returned to.
+    ///
+    Pool<SC::Message>* mOwner;
+};
+
+}
+
+#endif // MESSAGEHANDLE_H
@@ -4,6 +4,9 @@
 #define SERIALCOMMUNICATOR_H
 
 #include "Message.h"
+#include "MessageHandle.h"
 #include "Communicator.h"
+#include "Capture.h"
+#include "LinkQuality.h"
 
 #endif // SERIALCOMMUNICATOR_H
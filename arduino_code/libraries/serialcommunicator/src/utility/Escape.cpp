@@ -0,0 +1,82 @@
+#include "Escape.h"
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace SC {
+
+unsigned long FindEscape(const byte* Data, unsigned long Length, byte First, byte Second)
+{
+    unsigned long i = 0;
+
+#if defined(__SSE2__) || defined(__AVX2__)
+    // Check the first few bytes one at a time.  In dense data the match is usually right at the start,
+    // where setting up a vector compare would cost more than it saves.
+    for(; i < 8 && i < Length; i++)
+    {
+        if(Data[i] == First || Data[i] == Second)
+        {
+            return i;
+        }
+    }
+#endif
+
+#if defined(__AVX2__)
+    // Compare 32 bytes at a time against both values.
+    const __m256i FirstWide = _mm256_set1_epi8(static_cast<char>(First));
+    const __m256i SecondWide = _mm256_set1_epi8(static_cast<char>(Second));
+    for(; i + 32 <= Length; i += 32)
+    {
+        __m256i Block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Data + i));
+        __m256i Matches = _mm256_or_si256(_mm256_cmpeq_epi8(Block, FirstWide), _mm256_cmpeq_epi8(Block, SecondWide));
+        unsigned int Mask = static_cast<unsigned int>(_mm256_movemask_epi8(Matches));
+        if(Mask != 0)
+        {
+            return i + __builtin_ctz(Mask);
+        }
+    }
+#endif
+
+#if defined(__SSE2__)
+    // Compare 16 bytes at a time against both values.
+    const __m128i FirstNarrow = _mm_set1_epi8(static_cast<char>(First));
+    const __m128i SecondNarrow = _mm_set1_epi8(static_cast<char>(Second));
+    for(; i + 16 <= Length; i += 16)
+    {
+        __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Data + i));
+        __m128i Matches = _mm_or_si128(_mm_cmpeq_epi8(Block, FirstNarrow), _mm_cmpeq_epi8(Block, SecondNarrow));
+        unsigned int Mask = static_cast<unsigned int>(_mm_movemask_epi8(Matches));
+        if(Mask != 0)
+        {
+            return i + __builtin_ctz(Mask);
+        }
+    }
+#endif
+
+    // Scan whatever is left one byte at a time.
+    return i + FindEscapeScalar(Data + i, Length - i, First, Second);
+}
+unsigned long FindEscapeScalar(const byte* Data, unsigned long Length, byte First, byte Second)
+{
+    for(unsigned long i = 0; i < Length; i++)
+    {
+        if(Data[i] == First || Data[i] == Second)
+        {
+            return i;
+        }
+    }
+    return Length;
+}
+const char* EscapeKernel()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(__SSE2__)
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
+
+}
@@ -0,0 +1,35 @@
+/// \file Escape.h
+/// \brief Defines the escape scanning functions used for packet framing.
+#ifndef ESCAPE_H
+#define ESCAPE_H
+
+#include "Arduino.h"
+
+namespace SC {
+
+///
+/// \brief FindEscape Finds the first byte that matches either of two values.
+/// \param Data The bytes to scan.
+/// \param Length The number of bytes to scan.
+/// \param First The first value to look for.
+/// \param Second The second value to look for.  Pass First again to look for a single value.
+/// \return The index of the first matching byte, or Length if no bytes match.
+/// \details Used to split packets into runs of bytes that need no escaping, so each run can be written or
+/// copied in bulk.  On host builds with SSE2 or AVX2 enabled the scan checks 16 or 32 bytes at a time;
+/// otherwise it falls back to FindEscapeScalar().  Both give identical results.
+///
+unsigned long FindEscape(const byte* Data, unsigned long Length, byte First, byte Second);
+///
+/// \brief FindEscapeScalar The byte-at-a-time version of FindEscape().
+/// \details Always available, so vectorized builds can be checked against it.
+///
+unsigned long FindEscapeScalar(const byte* Data, unsigned long Length, byte First, byte Second);
+///
+/// \brief EscapeKernel Gets the name of the scan FindEscape() was compiled with.
+/// \return "avx2", "sse2", or "scalar".
+///
+const char* EscapeKernel();
+
+}
+
+#endif // ESCAPE_H
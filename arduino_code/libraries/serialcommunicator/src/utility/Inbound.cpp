@@ -3,11 +3,24 @@
 using namespace SC;
 
 // CONSTRUCTORS
-Inbound::Inbound(const Message* Message, unsigned long SequenceNumber)
+Inbound::Inbound()
+{
+  Inbound::mMessage = NULL;
+  Inbound::mSequenceNumber = 0;
+}
+
+// METHODS
+void Inbound::Load(Message* Message, unsigned long SequenceNumber)
 {
   Inbound::mMessage = Message;
   Inbound::mSequenceNumber = SequenceNumber;
 }
+Message* Inbound::Unload()
+{
+  Message* Output = Inbound::mMessage;
+  Inbound::mMessage = NULL;
+  return Output;
+}
 
 // PROPERTIES
 const Message* Inbound::pMessage()
@@ -10,20 +10,32 @@ namespace SC {
 
 ///
 /// \brief Provides management of inbound messages.
+/// \details Inbound instances are stored by value in the SC::Communicator's RX queue.  An instance with no
+/// message loaded is an open slot.
 ///
 class Inbound
 {
 public:
     ///
-    /// \brief Inbound Creates a new inbound message instance.
-    /// \param Message A pointer to the SC::Message received via serial.
+    /// \brief Inbound Creates a new, empty inbound message instance.
+    ///
+    Inbound();
+
+    ///
+    /// \brief Load Loads a received message into the instance.
+    /// \param Message A pointer to the SC::Message received via serial.  The instance takes control of the pointer.
     /// \param SequenceNumber The sequence number set by the sending SC::Communicator.
     ///
-    Inbound(const Message* Message, unsigned long SequenceNumber);
+    void Load(Message* Message, unsigned long SequenceNumber);
+    ///
+    /// \brief Unload Gives up the loaded message, leaving the instance empty.
+    /// \return A pointer to the message.  The caller takes control of the pointer.
+    ///
+    Message* Unload();
 
     ///
     /// \brief pMessage PROPERTY Gets a constant copy of the inbound SC::Message.
-    /// \return A constant SC::Message copy.
+    /// \return A constant SC::Message copy, or NULL if the instance is empty.
     ///
     const Message* pMessage();
     ///
@@ -36,7 +48,7 @@ private:
     ///
     /// \brief mMessage Stores a local pointer to the message.
     ///
-    const Message* mMessage;
+    Message* mMessage;
     ///
     /// \brief mSequenceNumber Stores a local copy of the message's originating sequence number.
     ///
@@ -3,10 +3,22 @@
 using namespace SC;
 
 // CONSTRUCTORS
-Outbound::Outbound(const SC::Message* Message, unsigned long SequenceNumber, bool ReceiptRequired, MessageStatus* Tracker)
+Outbound::Outbound()
+{
+  Outbound::mSequenceNumber = 0;
+  Outbound::mReceiptRequired = false;
+  Outbound::mTracker = NULL;
+  Outbound::mTransmitTimestamp = 0;
+  Outbound::mNTransmissions = 0;
+  Outbound::mDeadline = 0;
+  Outbound::mHeapIndex = 0;
+}
+
+// METHODS
+void Outbound::Load(SC::Message&& Message, unsigned long SequenceNumber, bool ReceiptRequired, MessageStatus* Tracker)
 {
   // Store locals.
-  Outbound::mMessage = Message;
+  Outbound::mMessage = static_cast<SC::Message&&>(Message);
   Outbound::mSequenceNumber = SequenceNumber;
   Outbound::mReceiptRequired = ReceiptRequired;
   Outbound::mTracker = Tracker;
@@ -14,17 +26,18 @@ Outbound::Outbound(const SC::Message* Message, unsigned long SequenceNumber, boo
   // Initialize counters.
   Outbound::mTransmitTimestamp = 0;
   Outbound::mNTransmissions = 0;
+  Outbound::mDeadline = 0;
+  Outbound::mHeapIndex = 0;
 
   // Set tracker status to queued.
   Outbound::UpdateTracker(MessageStatus::Queued);
 }
-Outbound::~Outbound()
+void Outbound::Unload()
 {
-  // Delete the message since nobody will need it again.
-  delete Outbound::mMessage;
+  // Release the message's data since nobody will need it again.
+  Outbound::mMessage = SC::Message();
+  Outbound::mTracker = NULL;
 }
-
-// METHODS
 void Outbound::Sent()
 {
   // Update Transmission timestamp.
@@ -40,20 +53,18 @@ void Outbound::UpdateTracker(MessageStatus Status)
     (*Outbound::mTracker) = Status;
   }
 }
-bool Outbound::TimeoutElapsed(unsigned long Timeout)
+void Outbound::Schedule(unsigned long Timeout)
 {
-  unsigned long CurrentTime = millis();
-  // Check for wrapping around max value of unsigned long.
-  if(Outbound::mTransmitTimestamp <= CurrentTime)
-  {
-    // No wrapping occured.
-    return ((CurrentTime - Outbound::mTransmitTimestamp) > Timeout);
-  }
-  else
-  {
-    // Wrapping occured.
-    return ((((unsigned long)(0xFFFFFFFF) - Outbound::mTransmitTimestamp) + CurrentTime + 1) > Timeout);
-  }
+  // The deadline is reached once more than the full timeout has elapsed since the message was sent.
+  Outbound::mDeadline = Outbound::mTransmitTimestamp + Timeout + 1;
+}
+bool Outbound::DeadlineElapsed() const
+{
+  return static_cast<long>(millis() - Outbound::mDeadline) >= 0;
+}
+void Outbound::Expedite()
+{
+  Outbound::mDeadline = millis();
 }
 bool Outbound::CanRetransmit(byte TransmitLimit)
 {
@@ -63,7 +74,7 @@ bool Outbound::CanRetransmit(byte TransmitLimit)
 // PROPERTIES
 const Message* const Outbound::pMessage()
 {
-  return Outbound::mMessage;
+  return &(Outbound::mMessage);
 }
 unsigned long Outbound::pSequenceNumber()
 {
@@ -77,3 +88,18 @@ byte Outbound::pNTransmissions()
 {
   return Outbound::mNTransmissions;
 }
+
+// ORDERINGS
+bool Outbound::SendsBefore(const Outbound* A, const Outbound* B)
+{
+  if(A->mMessage.pPriority() != B->mMessage.pPriority())
+  {
+    return A->mMessage.pPriority() > B->mMessage.pPriority();
+  }
+  // Don't have to worry about overflow here since messages are sent automatically shortly after queued.
+  return A->mSequenceNumber < B->mSequenceNumber;
+}
+bool Outbound::DueBefore(const Outbound* A, const Outbound* B)
+{
+  return static_cast<long>(A->mDeadline - B->mDeadline) < 0;
+}
@@ -11,20 +11,29 @@ namespace SC {
 
 ///
 /// \brief Provides management of outbound messages.
+/// \details Outbound instances are pooled by the SC::Communicator, so they are loaded with a message when
+/// queued and unloaded when done rather than being constructed and destroyed for every message.
 ///
 class Outbound
 {
 public:
     ///
-    /// \brief Creates a new Outbound message instance.
-    /// \param Message A pointer to the message that will be sent.
+    /// \brief Creates a new, empty Outbound message instance.
+    ///
+    Outbound();
+
+    ///
+    /// \brief Load Loads a message into the Outbound instance.
+    /// \param Message The message that will be sent.  It is moved into the Outbound instance.
     /// \param SequenceNumber The sequence number assigned by the transmitting SC::Communicator.
     /// \param ReceiptRequired Indicates if receipt is required for this message.
     /// \param Tracker A pointer to the external tracker for providing message status updates.
-    /// \note This class takes control of the SC::Message pointer.
     ///
-    Outbound(const Message* Message, unsigned long SequenceNumber, bool ReceiptRequired, MessageStatus* Tracker);
-    ~Outbound();
+    void Load(Message&& Message, unsigned long SequenceNumber, bool ReceiptRequired, MessageStatus* Tracker);
+    ///
+    /// \brief Unload Releases the loaded message so the instance can be reused.
+    ///
+    void Unload();
 
     ///
     /// \brief Instructs the outgoing message that it has been sent.
@@ -38,11 +47,20 @@ public:
     ///
     void UpdateTracker(MessageStatus Status);
     ///
-    /// \brief TimeoutElapsed Checks if a specified timeout has elapsed since the message was last sent.
+    /// \brief Schedule Sets the message's deadline to a timeout after it was last sent.
     /// \param Timeout The length of the timeout period in milliseconds.
-    /// \return TRUE if the timeout has been elapsed, otherwise FALSE.
     ///
-    bool TimeoutElapsed(unsigned long Timeout);
+    void Schedule(unsigned long Timeout);
+    ///
+    /// \brief DeadlineElapsed Checks if the message's deadline has passed.
+    /// \return TRUE if the deadline has passed, otherwise FALSE.
+    ///
+    bool DeadlineElapsed() const;
+    ///
+    /// \brief Expedite Makes the message due immediately, instead of at its scheduled deadline.
+    /// \note The message must not be in an SC::OutboundHeap ordered by deadline while this is called.
+    ///
+    void Expedite();
     ///
     /// \brief CanRetransmit Checks if the message can be retransmitted.
     /// \param TransmitLimit The total number of times a message can be transmitted while attempting to get a receipt.
@@ -71,11 +89,26 @@ public:
     ///
     byte pNTransmissions();
 
+    // ORDERINGS
+    ///
+    /// \brief SendsBefore Orders messages by highest priority, followed by lowest sequence number.
+    /// \return TRUE if A should be sent before B.
+    ///
+    static bool SendsBefore(const Outbound* A, const Outbound* B);
+    ///
+    /// \brief DueBefore Orders messages by earliest deadline.
+    /// \return TRUE if A's deadline comes before B's.
+    /// \details Comparison is done on the difference of the deadlines, so it is safe across millis() wrap.
+    ///
+    static bool DueBefore(const Outbound* A, const Outbound* B);
+
 private:
+    friend class OutboundHeap;
+
     ///
-    /// \brief mMessage Stores a local copy of the outbound message.
+    /// \brief mMessage Stores the outbound message.
     ///
-    const Message* mMessage;
+    Message mMessage;
     ///
     /// \brief mSequenceNumber Stores a local copy of the outbound message's sequence number.
     ///
@@ -97,6 +130,14 @@ private:
     /// \brief mNTransmissions Stores the total number of times the message was transmitted.
     ///
     byte mNTransmissions;
+    ///
+    /// \brief mDeadline Stores the time at which the message next needs attention.
+    ///
+    unsigned long mDeadline;
+    ///
+    /// \brief mHeapIndex Stores the message's position within the SC::OutboundHeap holding it.
+    ///
+    unsigned int mHeapIndex;
 };
 
 }
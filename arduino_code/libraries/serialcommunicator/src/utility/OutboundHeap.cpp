@@ -0,0 +1,145 @@
+#include "OutboundHeap.h"
+
+using namespace SC;
+
+// CONSTRUCTORS
+OutboundHeap::OutboundHeap(Ordering Before, unsigned int Capacity)
+{
+  OutboundHeap::mBefore = Before;
+  OutboundHeap::mCount = 0;
+  OutboundHeap::mCapacity = Capacity;
+  OutboundHeap::mItems = new Outbound*[Capacity];
+}
+OutboundHeap::~OutboundHeap()
+{
+  // Only the array is owned by the heap.
+  delete [] OutboundHeap::mItems;
+}
+
+// METHODS
+bool OutboundHeap::Push(Outbound* Message)
+{
+  if(OutboundHeap::mCount >= OutboundHeap::mCapacity)
+  {
+    return false;
+  }
+
+  // Add to the bottom of the heap and move it up into place.
+  OutboundHeap::Place(OutboundHeap::mCount, Message);
+  OutboundHeap::SiftUp(OutboundHeap::mCount++);
+
+  return true;
+}
+Outbound* OutboundHeap::Peek() const
+{
+  if(OutboundHeap::mCount == 0)
+  {
+    return NULL;
+  }
+  return OutboundHeap::mItems[0];
+}
+Outbound* OutboundHeap::Pop()
+{
+  Outbound* Output = OutboundHeap::Peek();
+  if(Output != NULL)
+  {
+    OutboundHeap::Remove(Output);
+  }
+  return Output;
+}
+void OutboundHeap::Remove(Outbound* Message)
+{
+  unsigned int Index = Message->mHeapIndex;
+
+  // Move the last message into the vacated position.
+  OutboundHeap::mCount--;
+  if(Index != OutboundHeap::mCount)
+  {
+    OutboundHeap::Place(Index, OutboundHeap::mItems[OutboundHeap::mCount]);
+    // The moved message may belong either above or below its new position.
+    if(Index > 0 && OutboundHeap::mBefore(OutboundHeap::mItems[Index], OutboundHeap::mItems[(Index - 1) / 2]))
+    {
+      OutboundHeap::SiftUp(Index);
+    }
+    else
+    {
+      OutboundHeap::SiftDown(Index);
+    }
+  }
+}
+Outbound* OutboundHeap::At(unsigned int Index) const
+{
+  return OutboundHeap::mItems[Index];
+}
+
+// PROPERTIES
+unsigned int OutboundHeap::pCount() const
+{
+  return OutboundHeap::mCount;
+}
+unsigned int OutboundHeap::pCapacity() const
+{
+  return OutboundHeap::mCapacity;
+}
+void OutboundHeap::pCapacity(unsigned int Capacity)
+{
+  // Never drop messages that are currently held.
+  Capacity = max(Capacity, OutboundHeap::mCount);
+  if(Capacity != OutboundHeap::mCapacity)
+  {
+    Outbound** TMPItems = new Outbound*[Capacity];
+    for(unsigned int i = 0; i < OutboundHeap::mCount; i++)
+    {
+      TMPItems[i] = OutboundHeap::mItems[i];
+    }
+    delete [] OutboundHeap::mItems;
+    OutboundHeap::mItems = TMPItems;
+    OutboundHeap::mCapacity = Capacity;
+  }
+}
+
+// PRIVATE METHODS
+void OutboundHeap::Place(unsigned int Index, Outbound* Message)
+{
+  OutboundHeap::mItems[Index] = Message;
+  Message->mHeapIndex = Index;
+}
+void OutboundHeap::SiftUp(unsigned int Index)
+{
+  Outbound* Message = OutboundHeap::mItems[Index];
+  while(Index > 0)
+  {
+    unsigned int Parent = (Index - 1) / 2;
+    if(!OutboundHeap::mBefore(Message, OutboundHeap::mItems[Parent]))
+    {
+      break;
+    }
+    OutboundHeap::Place(Index, OutboundHeap::mItems[Parent]);
+    Index = Parent;
+  }
+  OutboundHeap::Place(Index, Message);
+}
+void OutboundHeap::SiftDown(unsigned int Index)
+{
+  Outbound* Message = OutboundHeap::mItems[Index];
+  while(true)
+  {
+    // Find the child that belongs highest in the heap.
+    unsigned int Child = 2 * Index + 1;
+    if(Child >= OutboundHeap::mCount)
+    {
+      break;
+    }
+    if(Child + 1 < OutboundHeap::mCount && OutboundHeap::mBefore(OutboundHeap::mItems[Child + 1], OutboundHeap::mItems[Child]))
+    {
+      Child++;
+    }
+    if(!OutboundHeap::mBefore(OutboundHeap::mItems[Child], Message))
+    {
+      break;
+    }
+    OutboundHeap::Place(Index, OutboundHeap::mItems[Child]);
+    Index = Child;
+  }
+  OutboundHeap::Place(Index, Message);
+}
@@ -0,0 +1,115 @@
+/// \file OutboundHeap.h
+/// \brief Defines the SC::OutboundHeap class.
+#ifndef OUTBOUNDHEAP_H
+#define OUTBOUNDHEAP_H
+
+#include "Arduino.h"
+#include "Outbound.h"
+
+namespace SC {
+
+///
+/// \brief A binary min-heap of outbound messages with a configurable ordering.
+/// \details The SC::Communicator keeps two of these: one ordered by send priority for messages that
+/// have not been transmitted yet, and one ordered by deadline for messages waiting on a receipt.
+/// This lets a spin cycle look only at the top of each heap instead of scanning every queued message.
+/// The heap does not own the messages it holds.
+///
+class OutboundHeap
+{
+public:
+    ///
+    /// \brief Ordering Defines the ordering function of the heap.
+    /// \details Must return TRUE if A belongs closer to the top of the heap than B.
+    ///
+    typedef bool (*Ordering)(const Outbound* A, const Outbound* B);
+
+    ///
+    /// \brief OutboundHeap Creates a new, empty heap.
+    /// \param Before The ordering function of the heap.
+    /// \param Capacity The number of messages the heap can hold.
+    ///
+    OutboundHeap(Ordering Before, unsigned int Capacity);
+    ~OutboundHeap();
+
+    ///
+    /// \brief Push Adds a message to the heap.
+    /// \param Message The message to add.
+    /// \return TRUE if the message was added, FALSE if the heap is full.
+    ///
+    bool Push(Outbound* Message);
+    ///
+    /// \brief Peek Gets the message at the top of the heap without removing it.
+    /// \return The top message, or NULL if the heap is empty.
+    ///
+    Outbound* Peek() const;
+    ///
+    /// \brief Pop Removes and returns the message at the top of the heap.
+    /// \return The top message, or NULL if the heap is empty.
+    ///
+    Outbound* Pop();
+    ///
+    /// \brief Remove Removes an arbitrary message from the heap.
+    /// \param Message The message to remove.  Must currently be held by this heap.
+    ///
+    void Remove(Outbound* Message);
+    ///
+    /// \brief At Gets the message stored at a position in the heap's storage.
+    /// \param Index The storage position, from 0 to pCount() - 1.
+    /// \return The message at the position.
+    /// \details Storage order is heap order, not sorted order.  Use for iterating over all held messages.
+    ///
+    Outbound* At(unsigned int Index) const;
+
+    ///
+    /// \brief pCount PROPERTY Gets the number of messages in the heap.
+    /// \return The number of messages in the heap.
+    ///
+    unsigned int pCount() const;
+    ///
+    /// \brief pCapacity PROPERTY Gets the number of messages the heap can hold.
+    /// \return The capacity of the heap.
+    ///
+    unsigned int pCapacity() const;
+    ///
+    /// \brief pCapacity PROPERTY Sets the number of messages the heap can hold.
+    /// \param Capacity The new capacity of the heap.
+    /// \note The capacity will never be reduced below the number of messages currently held.
+    ///
+    void pCapacity(unsigned int Capacity);
+
+private:
+    ///
+    /// \brief mBefore Stores the ordering function of the heap.
+    ///
+    Ordering mBefore;
+    ///
+    /// \brief mItems Stores the heap array.
+    ///
+    Outbound** mItems;
+    ///
+    /// \brief mCount Stores the number of messages in the heap.
+    ///
+    unsigned int mCount;
+    ///
+    /// \brief mCapacity Stores the allocated size of the heap array.
+    ///
+    unsigned int mCapacity;
+
+    ///
+    /// \brief Place Writes a message into a heap position and updates its stored index.
+    ///
+    void Place(unsigned int Index, Outbound* Message);
+    ///
+    /// \brief SiftUp Moves the message at a position up until the heap order is restored.
+    ///
+    void SiftUp(unsigned int Index);
+    ///
+    /// \brief SiftDown Moves the message at a position down until the heap order is restored.
+    ///
+    void SiftDown(unsigned int Index);
+};
+
+}
+
+#endif // OUTBOUNDHEAP_H
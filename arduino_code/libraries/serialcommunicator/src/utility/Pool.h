@@ -0,0 +1,106 @@
+/// \file Pool.h
+/// \brief Defines the SC::Pool class.
+#ifndef POOL_H
+#define POOL_H
+
+#include "Arduino.h"
+
+namespace SC {
+
+///
+/// \brief A free list that recycles objects instead of returning them to the heap.
+/// \details Objects are allocated on demand the first time they are needed, and are cached on release up to
+/// the pool's capacity.  Once the pool has warmed up, acquiring and releasing objects does not touch the heap.
+/// Objects are handed out as-is; the caller is responsible for resetting an object before releasing it.
+///
+template <typename T>
+class Pool
+{
+public:
+    ///
+    /// \brief Pool Creates a new, empty pool.
+    /// \param Capacity The maximum number of released objects to keep for reuse.
+    ///
+    Pool(unsigned int Capacity)
+    {
+        Pool::mCapacity = Capacity;
+        Pool::mCount = 0;
+        Pool::mFree = new T*[Capacity];
+    }
+    ~Pool()
+    {
+        for(unsigned int i = 0; i < Pool::mCount; i++)
+        {
+            delete Pool::mFree[i];
+        }
+        delete [] Pool::mFree;
+    }
+    Pool(const Pool&) = delete;
+    Pool& operator=(const Pool&) = delete;
+
+    ///
+    /// \brief Acquire Gets an object from the pool, allocating a new one if none are free.
+    /// \return A pointer to the object.
+    ///
+    T* Acquire()
+    {
+        if(Pool::mCount > 0)
+        {
+            return Pool::mFree[--Pool::mCount];
+        }
+        return new T();
+    }
+    ///
+    /// \brief Release Returns an object to the pool.
+    /// \param Item The object to return.  It is deleted if the pool is already full.
+    ///
+    void Release(T* Item)
+    {
+        if(Pool::mCount < Pool::mCapacity)
+        {
+            Pool::mFree[Pool::mCount++] = Item;
+        }
+        else
+        {
+            delete Item;
+        }
+    }
+
+    ///
+    /// \brief pCapacity PROPERTY Sets the maximum number of released objects to keep for reuse.
+    /// \param Capacity The new capacity.  Any cached objects beyond it are deleted.
+    ///
+    void pCapacity(unsigned int Capacity)
+    {
+        while(Pool::mCount > Capacity)
+        {
+            delete Pool::mFree[--Pool::mCount];
+        }
+        T** TMPFree = new T*[Capacity];
+        for(unsigned int i = 0; i < Pool::mCount; i++)
+        {
+            TMPFree[i] = Pool::mFree[i];
+        }
+        delete [] Pool::mFree;
+        Pool::mFree = TMPFree;
+        Pool::mCapacity = Capacity;
+    }
+
+private:
+    ///
+    /// \brief mFree Stores the objects available for reuse.
+    ///
+    T** mFree;
+    ///
+    /// \brief mCount Stores the number of objects available for reuse.
+    ///
+    unsigned int mCount;
+    ///
+    /// \brief mCapacity Stores the maximum number of objects kept for reuse.
+    ///
+    unsigned int mCapacity;
+};
+
+}
+
+#endif // POOL_H